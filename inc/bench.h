@@ -39,13 +39,27 @@
 #include <unistd.h>
 #include <wordexp.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <signal.h>
 
 #elif DARWIN
 #include <argp.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <sys/time.h>
 #include <netdb.h>
 
@@ -64,6 +78,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -155,6 +170,17 @@
 #define DEFAULT_CREATE_BATCH   10
 #define DEFAULT_SUB_INTERVAL   10000
 #define DEFAULT_QUERY_INTERVAL 10000
+#define DEFAULT_REPLAY_QUEUE   4
+#define REPLAY_READ_BUF        (4 << 20)
+#define AGENT_START_DELAY_MS   500
+#define AGENT_STATS_INTERVAL   1000
+#define METRICS_IO_TIMEOUT_MS  1000
+#define STATS_FORMAT_CSV      0
+#define STATS_FORMAT_JSONL    1
+#define REST_COMPRESS_NONE    0
+#define REST_COMPRESS_GZIP    1
+#define REST_COMPRESS_DEFLATE 2
+#define DEFAULT_LATENCY_MAX_MS 60000
 #define BARRAY_MIN_SIZE 8
 #define SML_LINE_SQL_SYNTAX_OFFSET 7
 
@@ -168,6 +194,22 @@
 #define FORCE_INLINE
 #endif
 
+#ifdef WINDOWS
+#define BENCH_THREAD_LOCAL __declspec(thread)
+#else
+#define BENCH_THREAD_LOCAL __thread
+#endif
+
+#ifdef WINDOWS
+#define BENCH_ATOMIC_ADD(ptr, val) \
+    InterlockedExchangeAdd64((volatile LONG64 *)(ptr), (LONG64)(val))
+#define BENCH_ATOMIC_LOAD(ptr) InterlockedOr64((volatile LONG64 *)(ptr), 0)
+#else
+#define BENCH_ATOMIC_ADD(ptr, val) \
+    __atomic_add_fetch((ptr), (val), __ATOMIC_RELAXED)
+#define BENCH_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#endif
+
 #define debugPrint(fp, fmt, ...)                                             \
     do {                                                                     \
         if (g_arguments->debug_print) {                                      \
@@ -244,6 +286,17 @@ enum TEST_MODE {
 
 enum enumSYNC_MODE { SYNC_MODE, ASYNC_MODE, MODE_BUT };
 
+enum enumRATE_UNIT { RATE_UNIT_ROWS, RATE_UNIT_REQUESTS };
+
+enum enumCOLUMN_GEN {
+    COLUMN_GEN_SAMPLE,  // value from the prepared rows, only null_ratio applies
+    COLUMN_GEN_RANDOM_WALK,
+    COLUMN_GEN_SINE,
+    COLUMN_GEN_COUNTER,
+    COLUMN_GEN_STEP,
+    COLUMN_GEN_ZIPF
+};
+
 enum enum_TAOS_INTERFACE {
     TAOSC_IFACE,
     REST_IFACE,
@@ -307,11 +360,29 @@ typedef struct BArray {
 } BArray;
 
 typedef struct TAOS_POOL_S {
-    int    size;
-    int    current;
-    TAOS **taos_list;
+    int             size;
+    int             current;
+    TAOS **         taos_list;
+    char **         db_list;    // database last selected on each connection
+    int64_t *       connect_us; // connect latency of each connection
+    pthread_mutex_t mutex;
 } TAOS_POOL;
 
+// per-column value generator, values are a pure function of the column,
+// the child table and the row's timestamp so they can be computed on the fly
+typedef struct SColumnGen_S {
+    uint8_t  kind;
+    double   nullRatio;
+    double   start;      // random_walk/counter start, sine/step base
+    double   step;       // random_walk step size, counter increment
+    double   amplitude;  // sine amplitude, step level spread
+    double   noise;      // sine noise amplitude
+    uint64_t period;     // sine period, step hold, counter reset in rows
+    double   skew;       // zipf exponent
+    uint32_t categories;
+    double * cdf;        // zipf cumulative distribution
+} SColumnGen;
+
 typedef struct SField {
     uint8_t  type;
     char     name[TSDB_COL_NAME_LEN + 1];
@@ -323,8 +394,28 @@ typedef struct SField {
     int64_t  min;
     tools_cJSON *  values;
     bool     sma;
+    SColumnGen *gen;
 } Field;
 
+typedef struct SRowFragment_S {
+    char *   data;
+    uint32_t len;
+} SRowFragment;
+
+// child table names, prefix + index formatted on demand, or packed back to
+// back in one arena when they are fetched from the server
+typedef struct SNameStore_S {
+    char *    prefix;   // pre-escaped, with the opening backquote if any
+    uint32_t  prefixLen;
+    bool      escape;
+    char *    arena;    // NUL terminated names, NULL when formatted
+    uint64_t  arenaLen;
+    uint64_t  arenaCap;
+    uint64_t *offsets;  // offsets[i] .. offsets[i + 1] - 1 is name i
+    uint64_t  count;
+    uint64_t  capacity;
+} SNameStore;
+
 typedef struct SSuperTable_S {
     char *   stbName;
     bool     random_data_source;  // rand_gen or sample
@@ -335,6 +426,11 @@ typedef struct SSuperTable_S {
     uint64_t childTblCount;
     uint64_t batchCreateTableNum;  // 0: no batch,  > 0: batch table number in
                                    // one sql
+    uint32_t create_table_inflight;    // async create batches per thread
+    uint32_t create_table_batch_bytes; // sql size limit of one create batch
+    uint32_t create_table_target_ms;   // > 0: resize batches toward latency
+    bool     vgroup_routing;  // give every insert thread tables of one vgroup
+    int32_t *tblVgroups;      // vgroup of each child table when routing
     bool     autoCreateTable;
     uint16_t iface;  // 0: taosc, 1: rest, 2: stmt
     uint16_t lineProtocol;
@@ -347,6 +443,18 @@ typedef struct SSuperTable_S {
     int      disorderRange;  // ms, us or ns. according to database precision
 
     uint64_t insert_interval;
+    uint64_t insert_rate;       // 0: closed loop, > 0: target rate per second
+    uint8_t  insert_rate_unit;  // RATE_UNIT_ROWS or RATE_UNIT_REQUESTS
+    uint32_t async_inflight;    // 0: blocking insert, > 0: async requests per thread
+    uint32_t pipeline_buffers;  // > 1: generate and send on separate threads
+    uint32_t rest_connections;  // > 0: rest requests multiplexed over epoll
+    uint32_t steal_chunk;       // 0: fixed table ranges, > 0: tables per stolen chunk
+    BArray * replayFiles;       // csv files streamed instead of generated rows
+    int32_t  replayPartitionCol;  // -1: file n goes to child table n
+    bool     replayByTag;       // partition value is the first tag, not a name
+    bool     replayShiftTs;     // move timestamps so the first row lands now
+    double   replaySpeed;       // 0: as fast as possible, N: N x recorded pace
+    uint32_t replayQueue;       // filled batches buffered per worker
     uint64_t insertRows;
     uint64_t timestamp_step;
     int64_t  startTimestamp;
@@ -356,14 +464,20 @@ typedef struct SSuperTable_S {
     char *   partialColumnNameBuf;
     BArray * cols;
     BArray * tags;
-    char **  childTblName;
+    SNameStore childTblNames;
     char *   colsOfCreateChildTable;
     uint32_t lenOfTags;
     uint32_t lenOfCols;
 
     char *sampleDataBuf;
+    SRowFragment *sampleRows;  // length-prefixed view of sampleDataBuf rows
+    SRowFragment *sampleCols;  // per-column view of sampleRows, with columnGen
+    bool     columnGen;        // some column has a generator or null ratio
     bool  useSampleTs;
-    char *tagDataBuf;
+    char *tagDataBuf;  // only when tags come from tags_file
+    SRowFragment *tagRows;  // distinct rows of tags_file in tagDataBuf
+    uint64_t tagRowCount;
+    uint64_t tagSeed;  // keys the tag stream of each child table
     bool  tcpTransfer;
     bool  non_stop;
     char *comment;
@@ -419,7 +533,6 @@ typedef struct SDataBase_S {
 typedef struct SSQL_S {
     char *command;
     char result[MAX_FILE_NAME_LEN];
-    int64_t* delay_list;
 } SSQL;
 
 typedef struct SpecifiedQueryInfo_S {
@@ -486,11 +599,34 @@ typedef struct SArguments_S {
     uint32_t           binwidth;
     uint32_t           intColumnCount;
     uint32_t           connection_pool;
+    uint32_t           connections_per_thread;
     uint32_t           nthreads;
     uint32_t           table_threads;
     uint64_t           prepared_rand;
     uint32_t           reqPerReq;
     uint64_t           insert_interval;
+    uint64_t           insert_rate;
+    uint8_t            insert_rate_unit;
+    uint32_t           async_inflight;
+    uint32_t           pipeline_buffers;
+    uint32_t           rest_connections;
+    uint8_t            rest_compression;
+    int32_t            rest_compression_level;
+    uint32_t           steal_chunk;
+    bool               phase_timers;
+    uint32_t           tag_cache;  // rendered tag strings kept per thread
+    uint64_t           latency_max;  // us, top of the histogram range
+    char *             latency_dump_file;
+    uint32_t           stats_interval_ms;
+    char *             stats_file;
+    uint8_t            stats_format;
+    uint16_t           metrics_port;
+    char *             metrics_host;
+    uint64_t           random_seed;
+    BArray *           agents;        // "host:port" of each agent, controller only
+    char *             agent_listen;  // [host:]port an agent waits on
+    uint32_t           agent_index;
+    uint32_t           agent_count;   // > 0 once a controller assigned a share
     bool               demo_mode;
     bool               aggr_func;
     struct sockaddr_in serv_addr;
@@ -508,16 +644,86 @@ typedef struct SArguments_S {
     bool               terminate;
 } SArguments;
 
-typedef struct delayNode_S {
-    uint64_t            value;
-    struct delayNode_S *next;
-} delayNode;
-
-typedef struct delayList_S {
-    uint64_t   size;
-    delayNode *head;
-    delayNode *tail;
-} delayList;
+// log-bucketed latency histogram in microseconds, fixed memory regardless
+// of how many values are recorded and mergeable across threads
+typedef struct SLatencyHist_S {
+    uint64_t *counts;
+    uint32_t  size;
+    uint64_t  highest;
+    uint64_t  count;
+    uint64_t  total;
+    uint64_t  min;
+    uint64_t  max;
+} SLatencyHist;
+
+// framing state of one http response, parsed incrementally as bytes arrive
+typedef struct SHttpResp_S {
+    int32_t status;
+    int64_t bodyStart;      // 0 until the header block is complete
+    int64_t contentLength;  // -1 when absent
+    bool    chunked;
+    bool    close;          // the server will close the connection
+    int64_t scanned;        // bytes already searched for the header end
+    int64_t readPos;        // next raw body byte to decode
+    int64_t bodyLen;        // decoded body bytes, chunks are compacted in place
+    int64_t chunkLeft;      // >0 data left in the chunk, else HTTP_CHUNK_*
+} SHttpResp;
+
+#define HTTP_CHUNK_SIZE    -1
+#define HTTP_CHUNK_CRLF    -2
+#define HTTP_CHUNK_TRAILER -3
+
+// hands out chunks of steal_chunk tables to whichever thread asks next. In
+// interlace mode a unit is one chunk for one round of interlaceRows rows and
+// units are ordered round by round, so all tables advance together.
+typedef struct STableScheduler_S {
+    pthread_mutex_t mutex;
+    uint64_t        next;
+    uint64_t        units;  // 0: unbounded, non_stop interlace
+    uint64_t        chunks;
+    uint64_t        chunkSize;
+    uint64_t        tables;
+} STableScheduler;
+
+// counters one worker thread shares with the stats sampler
+typedef struct SStatsSlot_S {
+    pthread_mutex_t      mutex;
+    const char *         label;  // super table or query kind
+    uint64_t             rows;
+    uint64_t             requests;
+    uint64_t             bytes;
+    uint64_t             errors;
+    int64_t              inflight;
+    SLatencyHist         hist;   // delays of the current interval
+    struct SStatsSlot_S *next;
+} SStatsSlot;
+
+// cumulative counters of one worker served on the metrics endpoint, kept
+// with relaxed atomics so a scrape never blocks the hot path
+#define METRICS_BUCKETS 14
+typedef struct SMetricSlot_S {
+    const char *          label;
+    uint64_t              rows;
+    uint64_t              affectedRows;
+    uint64_t              requests;
+    uint64_t              errors;
+    uint64_t              latencyUs;
+    uint64_t              buckets[METRICS_BUCKETS];  // last one is +Inf
+    struct SMetricSlot_S *next;
+} SMetricSlot;
+
+// where an insert thread's wall time goes when phase_timers is enabled,
+// every stretch is charged to exactly one phase
+enum {
+    PHASE_BUILD,     // row generation and sql/line serialization
+    PHASE_BIND,      // stmt bind and add batch
+    PHASE_JSON,      // schemaless json printing
+    PHASE_THROTTLE,  // insert_rate pacing and waits for a free async slot
+    PHASE_COMPRESS,  // rest_compression
+    PHASE_SEND,      // writing the http request
+    PHASE_WAIT,      // waiting for the server or the client library
+    PHASE_NUM
+};
 
 typedef struct SThreadInfo_S {
     TAOS *     taos;
@@ -526,11 +732,15 @@ typedef struct SThreadInfo_S {
     uint64_t * bind_ts_array;
     char *     bindParams;
     char *     is_null;
+    int32_t *  bind_lengths;
+    uint64_t   bindRow;  // next prepared row the stmt path binds from
     uint32_t   threadID;
     uint64_t   start_table_from;
     uint64_t   end_table_to;
     uint64_t   ntables;
     uint64_t   tables_created;
+    uint64_t   create_retries;  // create batches resent after a conflict
+    int32_t    vgroup;          // vgroup written when routing, -1 for several
     char *     buffer;
     uint64_t   counter;
     uint64_t   st;
@@ -547,17 +757,43 @@ typedef struct SThreadInfo_S {
     TAOS_SUB * tsub;
     char **    lines;
     int32_t    sockfd;
+    char *     httpHeader;     // request line and fixed headers, built once
+    uint32_t   httpHeaderLen;
+    char *     httpResp;       // reusable response buffer
+    uint64_t   httpRespCap;
+    void *     httpDeflate;    // z_stream reused for request bodies
+    char *     httpBody;       // compressed request body
+    uint64_t   httpBodyCap;
+    uint64_t   bodyBytes;      // request body bytes before compression
+    uint64_t   wireBytes;      // request body bytes after compression
+    uint64_t   compressCpuUs;
     uint32_t   db_index;
     uint32_t   stb_index;
-    char **    sml_tags;
-    tools_cJSON *    json_array;
-    tools_cJSON *    sml_json_tags;
+    SRowFragment *sml_tags;  // rendered line prefix or telnet suffix per table
+    char **    sml_json_tags;  // pre-serialized tag object per table
+    uint64_t   sml_len;        // bytes of the json or line batch in buffer
     uint64_t   start_time;
     uint64_t   max_sql_len;
+    SRowFragment *tblHeaders;
+    char *     tblHeaderBuf;
+    struct SAsyncPool_S *asyncPool;
+    SStatsSlot *         stats;        // NULL unless stats_interval_ms is set
+    SMetricSlot *        metrics;      // NULL unless metrics_port is set
+    uint64_t             fetchedRows;  // rows read by fetchResult
+    struct STableScheduler_S *scheduler;
+    struct SReplayQueue_S *   replayQueue;
+    uint64_t   unitsTaken;
     FILE *     fp;
     char       filePath[MAX_PATH_LEN];
-    delayList  delayList;
-    uint64_t*  query_delay_list;
+    SLatencyHist delayHist;
+    double     rate_next_us;   // intended send time of the next request
+    double     rate_step_us;   // send interval per row or per request
+    SLatencyHist correctedDelayHist;
+    int64_t    batchStartTs;
+    uint64_t   totalGenDelay;  // us spent building batches
+    uint64_t   phaseNs[PHASE_NUM];
+    int64_t    phaseTs;        // start of the current phase, 0 when disabled
+    int32_t    phase;
     double     avg_delay;
 } threadInfo;
 
@@ -589,29 +825,59 @@ void queryAggrFunc();
 void parse_field_datatype(char *dataType, BArray *fields, bool isTag);
 /* demoJsonOpt.c */
 int getInfoFromJsonFile();
+int getInfoFromJsonContent(char *content, const char *name);
 /* demoUtil.c */
 int     compare(const void *a, const void *b);
 void    encode_base_64();
 int     init_taos_list();
 TAOS *  select_one_from_pool(char *db_name);
+TAOS *  select_thread_conn(uint32_t threadID, uint32_t k, char *db_name);
 void    cleanup_taos_list();
 int64_t toolsGetTimestampMs();
 int64_t toolsGetTimestampUs();
 int64_t toolsGetTimestampNs();
 int64_t toolsGetTimestamp(int32_t precision);
 void    toolsMsleep(int32_t mseconds);
+void    toolsUsleepUntil(int64_t deadlineUs);
+int32_t benchInt64ToStr(int64_t value, char *buf);
 void    replaceChildTblName(char *inSql, char *outSql, int tblIndex);
 void    setupForAnsiEscape(void);
 void    resetAfterAnsiEscape(void);
 char *  taos_convert_datatype_to_string(int type);
 int     taos_convert_string_to_datatype(char *type, int length);
 int     taosRandom();
+void    benchRandInit(void);
+void    benchRandSeed(uint64_t stream);
+void    benchRandKeyed(uint64_t key, uint64_t saved[4]);
+void    benchRandRestore(const uint64_t saved[4]);
+uint64_t benchRandNext(void);
+uint32_t benchRandBelow(uint32_t bound);
+void    benchRandFill(uint32_t *out, int32_t n);
+void    benchRandFillRange(int32_t *out, int32_t n, int32_t min, int32_t max);
+void    benchRandFillDouble(double *out, int32_t n, double min, double max);
 void    tmfree(void *buf);
 void    tmfclose(FILE *fp);
-void    fetchResult(TAOS_RES *res, threadInfo *pThreadInfo);
+int     fetchResult(TAOS_RES *res, threadInfo *pThreadInfo);
 void    prompt(bool NonStopMode);
 void    ERROR_EXIT(const char *msg);
 int     postProceSql(char *sqlstr, threadInfo *pThreadInfo);
+void    freeHttpBuffers(threadInfo *pThreadInfo);
+int     parseHttpResponse(SHttpResp *resp, char *buf, int64_t received);
+int64_t compressHttpBody(threadInfo *pThreadInfo, void **stream,
+                         const char *body, int64_t len, char **out,
+                         uint64_t *cap);
+void    freeDeflateStream(void **stream);
+#ifdef LINUX
+// param, 0 or -1, send start and completion time in us
+typedef void (*restDoneFp)(void *param, int32_t code, int64_t startTs,
+                           int64_t endTs);
+typedef struct SRestEngine_S SRestEngine;
+SRestEngine *restEngineCreate(threadInfo *pThreadInfo, uint32_t connections,
+                              restDoneFp fp);
+void    restEngineSubmit(SRestEngine *engine, char *body, void *param);
+void    restEngineDrain(SRestEngine *engine);
+void    restEngineDestroy(SRestEngine *engine);
+#endif
 int     queryDbExec(TAOS *taos, char *command, QUERY_TYPE type, bool quiet, bool check);
 int     regexMatch(const char *s, const char *reg, int cflags);
 int     convertHostToServAddr(char *host, uint16_t port,
@@ -619,8 +885,46 @@ int     convertHostToServAddr(char *host, uint16_t port,
 int     getAllChildNameOfSuperTable(TAOS *taos, char *dbName, char *stbName,
                                     char ** childTblNameOfSuperTbl,
                                     int64_t childTblCountOfSuperTbl);
-void    delay_list_init(delayList *list);
-void    delay_list_destroy(delayList *list);
+void    initNameStore(SNameStore *store, const char *prefix, bool escape);
+int     appendNameStore(SNameStore *store, const char *name, uint32_t len);
+uint32_t getChildTblName(SSuperTable *stbInfo, uint64_t tableSeq, char *buf,
+                         char **name);
+int     reorderNameStore(SSuperTable *stbInfo, const uint64_t *order,
+                         uint64_t count);
+void    freeNameStore(SNameStore *store);
+void    benchHistInit(SLatencyHist *hist, uint64_t highest);
+void    benchHistDestroy(SLatencyHist *hist);
+void    benchHistRecord(SLatencyHist *hist, uint64_t value);
+void    benchHistMerge(SLatencyHist *dst, SLatencyHist *src);
+uint64_t benchHistPercentile(SLatencyHist *hist, double percentile);
+int     benchStatsStart();
+SStatsSlot *benchStatsRegister(const char *label);
+void    benchStatsRecord(SStatsSlot *slot, uint64_t rows, uint64_t bytes,
+                         uint64_t delay, bool failed);
+void    benchStatsInflight(SStatsSlot *slot, int64_t delta);
+void    benchStatsStop();
+int     benchMetricsStart();
+SMetricSlot *benchMetricsRegister(const char *label);
+void    benchMetricsRecord(SMetricSlot *slot, uint64_t rows,
+                           uint64_t affectedRows, uint64_t delay, int32_t code);
+void    benchMetricsThread(int64_t delta);
+void    benchMetricsStop();
+int     benchAgentAccept();
+int     benchAgentReady();
+void    benchAgentStats(int64_t now, uint64_t rows, uint64_t requests,
+                        uint64_t bytes, uint64_t errors, int64_t inflight,
+                        SLatencyHist *hist);
+void    benchAgentReport(const char *dbName, const char *stbName,
+                         uint64_t rows, uint64_t affectedRows, int64_t us,
+                         SLatencyHist *hist);
+void    benchAgentFinish(bool failed);
+int     benchControllerRun();
+void    benchPhaseStart(threadInfo *pThreadInfo);
+int32_t benchPhaseSwitch(threadInfo *pThreadInfo, int32_t phase);
+void    benchPhaseStop(threadInfo *pThreadInfo);
+void    benchHistPrint(FILE *fp, const char *title, SLatencyHist *hist,
+                       double divisor, const char *unit);
+int     benchHistDump(SLatencyHist *hist, const char *label);
 void*   benchCalloc(size_t nmemb, size_t size, bool record);
 BArray* benchArrayInit(size_t size, size_t elemSize);
 void* benchArrayPush(BArray* pArray, void* pData);
@@ -637,6 +941,10 @@ int64_t taos_convert_datatype_to_default_min(uint8_t type);
 /* demoInsert.c */
 int  insertTestProcess();
 void postFreeResource();
+void initTableScheduler(STableScheduler *scheduler, SSuperTable *stbInfo,
+                        uint64_t ntables);
+bool takeTableUnit(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                   int32_t *interlaceRows);
 /* demoQuery.c */
 int queryTestProcess();
 /* demoSubscribe.c */
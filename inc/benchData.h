@@ -25,10 +25,18 @@ void    generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                          int lenOfOneRow, BArray * fields, int64_t loop,
                          bool tag);
 int     stmt_prepare(SSuperTable *stbInfo, TAOS_STMT *stmt, uint64_t tableSeq);
+void    initStmtBind(threadInfo *pThreadInfo, SSuperTable *stbInfo);
+void    freeStmtBind(threadInfo *pThreadInfo);
 int bindParamBatch(threadInfo *pThreadInfo, uint32_t batch, int64_t startTime);
 int prepare_sample_data(int a, int b);
-void generateSmlJsonTags(tools_cJSON *tagsList, SSuperTable *stbInfo,
-                            uint64_t start_table_from, int tbSeq);
-void generateSmlJsonCols(tools_cJSON *array, tools_cJSON *tag, SSuperTable *stbInfo,
-                            uint32_t time_precision, int64_t timestamp);
+char *  getChildTblTags(SSuperTable *stbInfo, uint64_t tableSeq);
+void    freeTagCache();
+const char *csvValueEnd(const char *p, const char *end);
+uint32_t renderColumnGenRow(char *pstr, SSuperTable *stbInfo,
+                            uint64_t tableSeq, int64_t pos, int64_t timestamp);
+char *  generateSmlJsonTags(SSuperTable *stbInfo, uint64_t start_table_from,
+                            int tbSeq);
+uint32_t calcSmlJsonColLen(SSuperTable *stbInfo);
+uint32_t generateSmlJsonCols(char *pstr, const char *tags, SSuperTable *stbInfo,
+                             uint32_t time_precision, int64_t timestamp);
 #endif
@@ -210,6 +210,8 @@ void init_argument() {
     g_arguments->binwidth = DEFAULT_BINWIDTH;
     g_arguments->prepared_rand = DEFAULT_PREPARED_RAND;
     g_arguments->reqPerReq = DEFAULT_REQ_PER_REQ;
+    g_arguments->latency_max = DEFAULT_LATENCY_MAX_MS * 1000;
+    g_arguments->rest_compression_level = -1;  // Z_DEFAULT_COMPRESSION
     g_arguments->g_totalChildTables = DEFAULT_CHILDTABLES;
     g_arguments->g_actualChildTables = 0;
     g_arguments->g_autoCreatedChildTables = 0;
@@ -13,6 +13,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include "benchData.h"
 #include "bench.h"
 
@@ -68,7 +69,8 @@ static int usc2utf8(char *p, int unic) {
     return 0;
 }
 
-static void rand_string(char *str, int size, bool chinese) {
+// return the number of bytes written, not counting any terminator
+static int rand_string(char *str, int size, bool chinese) {
     if (chinese) {
         char *pstr = str;
         int   move = 0;
@@ -78,23 +80,31 @@ static void rand_string(char *str, int size, bool chinese) {
                 break;
             }
             // Basic Chinese Character's Unicode is from 0x4e00 to 0x9fa5
-            int unic = 0x4e00 + taosRandom() % (0x9fa5 - 0x4e00);
+            int unic = 0x4e00 + benchRandBelow(0x9fa5 - 0x4e00);
             move = usc2utf8(pstr, unic);
             pstr += move;
             size -= move;
         }
+        return (int)(pstr - str);
     } else {
         str[0] = 0;
         if (size > 0) {
             //--size;
-            int n;
-            for (n = 0; n < size; n++) {
-                int key = abs(taosRandom()) % (int)(sizeof(charset) - 1);
-                str[n] = charset[key];
+            int32_t keys[256];
+            int     n = 0;
+            while (n < size) {
+                int32_t m = (size - n) < 256 ? (size - n) : 256;
+                benchRandFillRange(keys, m, 0, (int32_t)(sizeof(charset) - 1));
+                for (int32_t i = 0; i < m; i++) {
+                    str[n + i] = charset[keys[i]];
+                }
+                n += m;
             }
             str[n] = 0;
+            return n;
         }
     }
+    return 0;
 }
 
 int stmt_prepare(SSuperTable *stbInfo, TAOS_STMT *stmt, uint64_t tableSeq) {
@@ -103,8 +113,7 @@ int stmt_prepare(SSuperTable *stbInfo, TAOS_STMT *stmt, uint64_t tableSeq) {
     if (stbInfo->autoCreateTable) {
         len += sprintf(prepare + len,
                        "INSERT INTO ? USING `%s` TAGS (%s) VALUES(?",
-                       stbInfo->stbName,
-                       stbInfo->tagDataBuf + stbInfo->lenOfTags * tableSeq);
+                       stbInfo->stbName, getChildTblTags(stbInfo, tableSeq));
     } else {
         len += sprintf(prepare + len, "INSERT INTO ? VALUES(?");
     }
@@ -132,90 +141,383 @@ int stmt_prepare(SSuperTable *stbInfo, TAOS_STMT *stmt, uint64_t tableSeq) {
     return 0;
 }
 
-static int generateSampleFromCsvForStb(char *buffer, char *file, int32_t length,
-                                       int64_t size) {
-    size_t  n = 0;
-    ssize_t readLen = 0;
-    char *  line = NULL;
-    int     getRows = 0;
+#define CSV_MIN_CHUNK  (1 << 20)
+#define CSV_MAX_CHUNK  (64 << 20)
+#define CSV_TOKEN_LEN  64
 
-    FILE *fp = fopen(file, "r");
-    if (fp == NULL) {
-        errorPrint(stderr, "Failed to open sample file: %s, reason:%s\n", file,
-                   strerror(errno));
-        return -1;
+// one newline-aligned piece of a csv file, parsed by its own thread: the
+// first pass counts valid rows, the second copies the ones that are kept
+typedef struct SCsvChunk_S {
+    const char *  begin;
+    const char *  end;
+    BArray *      fields;  // schema to check values against, NULL to skip
+    bool          withTs;  // leading timestamp column (use_sample_ts)
+    uint32_t      width;   // longest row the insert buffers take
+    bool          copy;
+    uint64_t      lines;
+    uint64_t      rows;
+    uint64_t      bytes;
+    uint64_t      tooLong;
+    uint64_t      malformed;
+    uint64_t      badLine;  // first malformed line in the chunk, 1-based
+    const char *  badReason;
+    uint64_t      keep;
+    char *        out;
+    SRowFragment *frags;
+} SCsvChunk;
+
+static bool isCsvNull(const char *v, uint32_t len) {
+    return len == 4 && 0 == strncasecmp(v, "null", 4);
+}
+
+// NULL when the value fits the column type, the reason otherwise
+static const char *checkCsvValue(Field *field, const char *v, uint32_t len,
+                                 bool quoted) {
+    if (!quoted && isCsvNull(v, len)) {
+        return NULL;
     }
-    while (1) {
-#if defined(WIN32) || defined(WIN64)
-    #ifdef TDENGINE_3
-        toolsGetLineFile(&line, &n, fp);
-        readLen = n;
-    #else
-        readLen = toolsGetLineFile(&line, &n, fp);
-    #endif
-#else
-        readLen = getline(&line, &n, fp);
-#endif
-        if (-1 == readLen) {
-            if (0 != fseek(fp, 0, SEEK_SET)) {
-                errorPrint(stderr, "Failed to fseek file: %s, reason:%s\n",
-                           file, strerror(errno));
-                fclose(fp);
-                return -1;
+    char  token[CSV_TOKEN_LEN];
+    char *end;
+    switch (field->type) {
+        case TSDB_DATA_TYPE_BINARY:
+            return len <= field->length ? NULL : "binary value too long";
+        case TSDB_DATA_TYPE_NCHAR:
+            // up to 4 bytes a character in utf-8
+            return len <= field->length * 4 ? NULL : "nchar value too long";
+        case TSDB_DATA_TYPE_JSON:
+            return NULL;
+        case TSDB_DATA_TYPE_TIMESTAMP:
+            if (quoted || (len == 3 && 0 == strncasecmp(v, "now", 3))) {
+                return NULL;
             }
-            continue;
+            break;
+        case TSDB_DATA_TYPE_BOOL:
+            if ((len == 4 && 0 == strncasecmp(v, "true", 4)) ||
+                (len == 5 && 0 == strncasecmp(v, "false", 5)) ||
+                (len == 1 && (*v == '0' || *v == '1'))) {
+                return NULL;
+            }
+            return "invalid bool";
+        default:
+            break;
+    }
+    if (len == 0 || len >= CSV_TOKEN_LEN) {
+        return "invalid number";
+    }
+    memcpy(token, v, len);
+    token[len] = '\0';
+    errno = 0;
+    if (field->type == TSDB_DATA_TYPE_FLOAT ||
+        field->type == TSDB_DATA_TYPE_DOUBLE) {
+        strtod(token, &end);
+    } else if (field->type == TSDB_DATA_TYPE_UTINYINT ||
+               field->type == TSDB_DATA_TYPE_USMALLINT ||
+               field->type == TSDB_DATA_TYPE_UINT ||
+               field->type == TSDB_DATA_TYPE_UBIGINT) {
+        if (token[0] == '-') {
+            return "negative unsigned value";
         }
+        strtoull(token, &end, 10);
+    } else {
+        strtoll(token, &end, 10);
+    }
+    if (*end != '\0' || errno == ERANGE) {
+        return "invalid number";
+    }
+    return NULL;
+}
 
-        if (('\r' == line[readLen - 1]) || ('\n' == line[readLen - 1])) {
-            line[--readLen] = 0;
+// end of the csv value starting at p: the comma after it or end, past the
+// closing quote of a '' or "" quoted value, NULL if that quote is missing
+const char *csvValueEnd(const char *p, const char *end) {
+    if (p < end && (*p == '\'' || *p == '"')) {
+        const char *close = memchr(p + 1, *p, end - p - 1);
+        return close ? close + 1 : NULL;
+    }
+    const char *comma = memchr(p, ',', end - p);
+    return comma ? comma : end;
+}
+
+// split one line on commas outside quotes and check each value
+static const char *checkCsvRow(SCsvChunk *chunk, const char *line,
+                               uint32_t len) {
+    const char *p = line;
+    const char *end = line + len;
+    int32_t     col = chunk->withTs ? -1 : 0;
+    int32_t     ncols = (int32_t)chunk->fields->size;
+    while (true) {
+        const char *next = csvValueEnd(p, end);
+        if (next == NULL) {
+            return "unterminated quote";
+        }
+        bool     quoted = p < end && (*p == '\'' || *p == '"');
+        uint32_t vlen = (uint32_t)(next - p) - (quoted ? 2 : 0);
+        if (col >= ncols) {
+            return "too many values";
+        }
+        if (col >= 0) {
+            const char *reason =
+                checkCsvValue(benchArrayGet(chunk->fields, col),
+                              quoted ? p + 1 : p, vlen, quoted);
+            if (reason) {
+                return reason;
+            }
+        }
+        col++;
+        p = next;
+        if (p == end) {
+            break;
         }
+        if (*p != ',') {
+            return "text after a quoted value";
+        }
+        p++;
+    }
+    return col == ncols ? NULL : "too few values";
+}
 
-        if (readLen == 0) {
+static void *parseCsvChunk(void *arg) {
+    SCsvChunk * chunk = (SCsvChunk *)arg;
+    const char *p = chunk->begin;
+    uint64_t    rows = 0;
+    char *      out = chunk->out;
+    while (p < chunk->end && (!chunk->copy || rows < chunk->keep)) {
+        const char *nl = memchr(p, '\n', chunk->end - p);
+        const char *lineEnd = nl ? nl : chunk->end;
+        const char *line = p;
+        uint32_t    len = (uint32_t)(lineEnd - line);
+        p = nl ? nl + 1 : chunk->end;
+        if (!chunk->copy) {
+            chunk->lines++;
+        }
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        if (len == 0) {
             continue;
         }
-
-        if (readLen > length) {
-            infoPrint(
-                stdout,
-                "sample row len[%d] overflow define schema len[%d], so discard "
-                "this row\n",
-                (int32_t)readLen, length);
+        if (len > chunk->width) {
+            if (!chunk->copy) {
+                chunk->tooLong++;
+            }
             continue;
         }
+        if (chunk->fields) {
+            const char *reason = checkCsvRow(chunk, line, len);
+            if (reason) {
+                if (!chunk->copy && 0 == chunk->malformed++) {
+                    chunk->badLine = chunk->lines;
+                    chunk->badReason = reason;
+                }
+                continue;
+            }
+        }
+        if (chunk->copy) {
+            memcpy(out, line, len);
+            out[len] = '\0';
+            chunk->frags[rows].data = out;
+            chunk->frags[rows].len = len;
+            out += len + 1;
+        } else {
+            chunk->bytes += len + 1;
+        }
+        rows++;
+    }
+    if (!chunk->copy) {
+        chunk->rows = rows;
+    }
+    return NULL;
+}
 
-        memcpy(buffer + getRows * length, line, readLen);
-        getRows++;
-
-        if (getRows == size) {
+static void runCsvChunks(SCsvChunk *chunks, int32_t count) {
+    pthread_t *pids = benchCalloc(count, sizeof(pthread_t), false);
+    int32_t    started = 0;
+    for (; started < count; started++) {
+        int code = pthread_create(pids + started, NULL, parseCsvChunk,
+                                  chunks + started);
+        if (code) {
+            errorPrint(stderr,
+                       "failed to start csv parsing thread: %s, parsing "
+                       "the rest inline\n", strerror(code));
             break;
         }
     }
-
-    fclose(fp);
-    tmfree(line);
-    return 0;
+    // chunks whose thread did not start are parsed by the caller
+    for (int32_t i = started; i < count; i++) {
+        parseCsvChunk(chunks + i);
+    }
+    for (int32_t i = 0; i < started; i++) {
+        pthread_join(pids[i], NULL);
+    }
+    tmfree(pids);
 }
 
-static int getAndSetRowsFromCsvFile(SSuperTable *stbInfo) {
-    int32_t code = -1;
-    FILE *  fp = fopen(stbInfo->sampleFile, "r");
-    int     line_count = 0;
-    char *  buf = NULL;
+// map a whole file read-only, a plain read where mmap is not available
+static char *mapCsvFile(const char *file, uint64_t *size) {
+#ifdef WINDOWS
+    FILE *fp = fopen(file, "rb");
     if (fp == NULL) {
-        errorPrint(stderr, "Failed to open sample file: %s, reason:%s\n",
-                   stbInfo->sampleFile, strerror(errno));
-        goto free_of_get_set_rows_from_csv;
+        return NULL;
     }
-    buf = benchCalloc(1, TSDB_MAX_SQL_LEN, false);
-    while (fgets(buf, TSDB_MAX_SQL_LEN, fp)) {
-        line_count++;
+    _fseeki64(fp, 0, SEEK_END);
+    *size = (uint64_t)_ftelli64(fp);
+    _fseeki64(fp, 0, SEEK_SET);
+    char *data = benchCalloc(1, *size + 1, false);
+    if (*size != fread(data, 1, *size, fp)) {
+        tmfree(data);
+        data = NULL;
     }
-    stbInfo->insertRows = line_count;
-    code = 0;
-free_of_get_set_rows_from_csv:
     fclose(fp);
-    tmfree(buf);
-    return code;
+    return data;
+#else
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size == 0) {
+        *size = 0;
+        close(fd);
+        return (char *)"";
+    }
+    *size = (uint64_t)st.st_size;
+    char *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, *size, MADV_SEQUENTIAL);
+    return data;
+#endif
+}
+
+static void unmapCsvFile(char *data, uint64_t size) {
+#ifdef WINDOWS
+    tmfree(data);
+#else
+    if (size > 0) {
+        munmap(data, size);
+    }
+#endif
+}
+
+// read up to want valid rows of a sample or tags file into one packed
+// store, chunks are parsed in parallel and rows that do not fit the schema
+// are counted and skipped. Only as much of the file as needed is parsed
+// unless countAll, *fileRows then holds all of its valid rows
+static int loadCsvRows(SSuperTable *stbInfo, const char *file,
+                       BArray *fields, bool withTs, uint32_t width,
+                       uint64_t want, bool countAll, char **store,
+                       SRowFragment **rows, uint64_t *count,
+                       uint64_t *fileRows) {
+    int64_t  startTs = toolsGetTimestampUs();
+    uint64_t size = 0;
+    char *   data = mapCsvFile(file, &size);
+    if (data == NULL) {
+        errorPrint(stderr, "Failed to open sample file: %s, reason:%s\n", file,
+                   strerror(errno));
+        return -1;
+    }
+    // values are only checked where they end up in sql text
+    if (stbInfo->iface != TAOSC_IFACE && stbInfo->iface != REST_IFACE) {
+        fields = NULL;
+    }
+
+    int32_t  threads = g_arguments->nthreads > 0 ? g_arguments->nthreads : 1;
+    uint64_t chunkSize = size / threads + 1;
+    if (chunkSize < CSV_MIN_CHUNK) chunkSize = CSV_MIN_CHUNK;
+    if (chunkSize > CSV_MAX_CHUNK) chunkSize = CSV_MAX_CHUNK;
+    int32_t    nchunks = (int32_t)((size + chunkSize - 1) / chunkSize);
+    SCsvChunk *chunks = benchCalloc(nchunks + 1, sizeof(SCsvChunk), false);
+    const char *p = data;
+    const char *end = data + size;
+    nchunks = 0;
+    while (p < end) {
+        SCsvChunk *chunk = chunks + nchunks++;
+        chunk->begin = p;
+        p = (uint64_t)(end - p) > chunkSize ? p + chunkSize : end;
+        const char *nl = p < end ? memchr(p, '\n', end - p) : NULL;
+        p = nl ? nl + 1 : end;
+        chunk->end = p;
+        chunk->fields = fields;
+        chunk->withTs = withTs;
+        chunk->width = width;
+    }
+
+    // count in waves of threads chunks, stopping early when enough rows
+    // are found and the total is not needed
+    uint64_t valid = 0;
+    int32_t  parsed = 0;
+    while (parsed < nchunks && (countAll || valid < want)) {
+        int32_t n = nchunks - parsed < threads ? nchunks - parsed : threads;
+        runCsvChunks(chunks + parsed, n);
+        for (int32_t i = parsed; i < parsed + n; i++) {
+            valid += chunks[i].rows;
+        }
+        parsed += n;
+    }
+
+    uint64_t lines = 0, tooLong = 0, malformed = 0;
+    for (int32_t i = 0; i < parsed; i++) {
+        SCsvChunk *chunk = chunks + i;
+        if (chunk->malformed && malformed == 0) {
+            infoPrint(stdout, "%s line %" PRIu64 " skipped: %s\n", file,
+                      lines + chunk->badLine, chunk->badReason);
+        }
+        lines += chunk->lines;
+        tooLong += chunk->tooLong;
+        malformed += chunk->malformed;
+    }
+    if (valid == 0) {
+        errorPrint(stderr, "no valid rows in %s\n", file);
+        tmfree(chunks);
+        unmapCsvFile(data, size);
+        return -1;
+    }
+
+    // copy the kept rows, a chunk that is only partly kept reserves its
+    // whole size
+    uint64_t keep = valid < want ? valid : want;
+    uint64_t bytes = 0, left = keep;
+    for (int32_t i = 0; i < parsed && left > 0; i++) {
+        chunks[i].keep = chunks[i].rows < left ? chunks[i].rows : left;
+        left -= chunks[i].keep;
+        bytes += chunks[i].bytes;
+    }
+    *store = benchCalloc(1, bytes + 1, true);
+    *rows = benchCalloc(keep, sizeof(SRowFragment), true);
+    char *   out = *store;
+    uint64_t first = 0;
+    int32_t  copied = 0;
+    for (int32_t i = 0; i < parsed && chunks[i].keep > 0; i++) {
+        chunks[i].copy = true;
+        chunks[i].out = out;
+        chunks[i].frags = *rows + first;
+        out += chunks[i].bytes;
+        first += chunks[i].keep;
+        copied++;
+    }
+    runCsvChunks(chunks, copied);
+    tmfree(chunks);
+    unmapCsvFile(data, size);
+
+    *count = keep;
+    if (fileRows) {
+        *fileRows = valid;
+    }
+    double spent = (toolsGetTimestampUs() - startTs) / 1E6;
+    if (spent <= 0) spent = 1E-6;
+    infoPrint(stdout,
+              "read %" PRIu64 " rows of %s, %" PRIu64 " kept, %" PRIu64
+              " too long and %" PRIu64 " malformed skipped, %.2fMB in %.3fs: "
+              "%.2fMB/s\n",
+              valid, file, keep, tooLong, malformed, size / 1048576.0, spent,
+              size / 1048576.0 / spent);
+    return 0;
 }
 
 static uint32_t calcRowLen(BArray *fields, int iface) {
@@ -284,7 +586,9 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
     int     iface = stbInfo->iface;
     int     line_protocol = stbInfo->lineProtocol;
     int64_t pos = 0;
-    if (iface == STMT_IFACE) {
+    // stmt binds columns from field->data, its tags still go into the sql
+    bool    bind = iface == STMT_IFACE && !tag;
+    if (bind) {
         for (int i = 0; i < fields->size; ++i) {
             Field * field = benchArrayGet(fields, i);
             if (field->type == TSDB_DATA_TYPE_BINARY ||
@@ -319,7 +623,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
             switch (field->type) {
                 case TSDB_DATA_TYPE_BOOL: {
                     bool rand_bool = (taosRandom() % 2) & 1;
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((bool *)field->data)[k] = rand_bool;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -348,7 +652,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                     int8_t tinyint =
                             field->min +
                         (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((int8_t *)field->data)[k] = tinyint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -373,7 +677,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                 }
                 case TSDB_DATA_TYPE_UTINYINT: {
                     uint8_t utinyint = field->min + (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((uint8_t *)field->data)[k] = utinyint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -397,7 +701,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                 }
                 case TSDB_DATA_TYPE_SMALLINT: {
                     int16_t smallint = field->min + (taosRandom() % (field->max -field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((int16_t *)field->data)[k] = smallint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -422,7 +726,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                 }
                 case TSDB_DATA_TYPE_USMALLINT: {
                     uint16_t usmallint = field->min + (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((uint16_t *)field->data)[k] = usmallint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -460,7 +764,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                         }
                         int_ = field->min + (taosRandom() % (field->max - field->min));
                     }
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((int32_t *)field->data)[k] = int_;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -485,7 +789,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                 case TSDB_DATA_TYPE_BIGINT: {
                     int32_t int_;
                     int_ = field->min + (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((int64_t *)field->data)[k] = int_;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -509,7 +813,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                 }
                 case TSDB_DATA_TYPE_UINT: {
                     uint32_t uint = field->min + (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((uint32_t *)field->data)[k] = uint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -536,7 +840,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                     uint32_t ubigint =
                             field->min +
                         (taosRandom() % (field->max - field->min));
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((uint64_t *)field->data)[k] = ubigint;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -573,7 +877,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                                           float_ / 1000000000) /
                                          360);
                     }
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((float *)(field->data))[k] = float_;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -602,7 +906,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                                  (taosRandom() %
                                   (field->max - field->min)) +
                                  taosRandom() % 1000000 / 1000000.0);
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         ((double *)field->data)[k] = double_;
                     }
                     if ((iface == SML_IFACE || iface == SML_REST_IFACE) &&
@@ -646,7 +950,7 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
                         rand_string(tmp, field->length,
                                     g_arguments->chinese);
                     }
-                    if (iface == STMT_IFACE) {
+                    if (bind) {
                         sprintf((char *)field->data + k * field->length,
                                 "%s", tmp);
                     }
@@ -710,6 +1014,388 @@ void generateRandData(SSuperTable *stbInfo, char *sampleDataBuf,
     }
 }
 
+#define GEN_WALK_LEVELS    32
+#define GEN_MAX_CATEGORIES 1000
+#define GEN_PI             3.14159265358979323846
+
+// splitmix64 finalizer, turns column/table/row into independent bits
+static FORCE_INLINE uint64_t genMix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// uniform in [0, 1), deterministic for the same key, table and row
+static FORCE_INLINE double genUniform(uint64_t key, uint64_t table,
+                                      uint64_t n) {
+    uint64_t h = genMix(genMix(genMix(key) ^ table) ^ n);
+    return (double)(h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// standard normal, Box-Muller over two keyed uniforms
+static double genGauss(uint64_t key, uint64_t table, uint64_t id) {
+    double u = 1 - genUniform(key + 2, table, id);
+    double v = genUniform(key + 3, table, id);
+    return sqrt(-2 * log(u)) * cos(2 * GEN_PI * v);
+}
+
+// sum of n independent normal steps, drawn by Brownian bridge: the end of
+// each block of 2^GEN_WALK_LEVELS rows first, then the midpoint of the
+// interval holding n until n is reached. Every integer is the midpoint of
+// exactly one interval, so it keys its own draw and any row is computed in
+// GEN_WALK_LEVELS steps without per-table state
+static double genRandomWalk(SColumnGen *gen, uint64_t key, uint64_t table,
+                            uint64_t n) {
+    const uint64_t span = 1ULL << GEN_WALK_LEVELS;
+    double         base = 0;
+    for (uint64_t b = 0; b < n / span; b++) {
+        base += sqrt((double)span) * genGauss(key, table ^ genMix(b), span);
+    }
+    table ^= genMix(n / span);
+    n %= span;
+    uint64_t lo = 0, hi = span;
+    double   wlo = 0, whi = sqrt((double)span) * genGauss(key, table, span);
+    while (n != lo) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        double   wmid = (wlo + whi) / 2 +
+                      sqrt((double)(hi - lo) / 4) * genGauss(key, table, mid);
+        if (n < mid) {
+            hi = mid;
+            whi = wmid;
+        } else {
+            lo = mid;
+            wlo = wmid;
+        }
+    }
+    return gen->start + gen->step * (base + wlo);
+}
+
+static uint32_t genZipfRank(SColumnGen *gen, double u) {
+    uint32_t lo = 0, hi = gen->categories - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (gen->cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// value of column colIndex for the n-th timestamp step of a child table
+static double genColumnValue(Field *field, uint32_t colIndex, uint64_t table,
+                             uint64_t n) {
+    SColumnGen *gen = field->gen;
+    uint64_t    key = (uint64_t)colIndex << 8;
+    double      value;
+    switch (gen->kind) {
+        case COLUMN_GEN_RANDOM_WALK:
+            value = genRandomWalk(gen, key, table, n);
+            break;
+        case COLUMN_GEN_SINE: {
+            uint64_t phase = genMix(key ^ table) % gen->period;
+            value = gen->start +
+                    gen->amplitude *
+                        sin(2 * GEN_PI * (double)((n + phase) % gen->period) /
+                            (double)gen->period);
+            if (gen->noise > 0) {
+                value += gen->noise * (genUniform(key + 1, table, n) * 2 - 1);
+            }
+            break;
+        }
+        case COLUMN_GEN_COUNTER:
+            if (gen->period > 0) {
+                uint64_t offset = genMix(key ^ table) % gen->period;
+                value = gen->start +
+                        gen->step * (double)((n + offset) % gen->period);
+            } else {
+                value = gen->start + gen->step * (double)n;
+            }
+            break;
+        case COLUMN_GEN_STEP:
+            value = gen->start +
+                    gen->amplitude * genUniform(key, table, n / gen->period);
+            break;
+        case COLUMN_GEN_ZIPF:
+            return genZipfRank(gen, genUniform(key, table, n));
+        default:
+            return 0;
+    }
+    if (value < (double)field->min) value = (double)field->min;
+    if (value > (double)field->max) value = (double)field->max;
+    return value;
+}
+
+static uint32_t renderColumnValue(char *pstr, Field *field, double value) {
+    SColumnGen *gen = field->gen;
+    if (gen->kind == COLUMN_GEN_ZIPF) {
+        uint32_t rank = (uint32_t)value;
+        if (field->values) {
+            tools_cJSON *item = tools_cJSON_GetArrayItem(field->values, rank);
+            if (tools_cJSON_IsString(item)) {
+                return sprintf(pstr, "'%.*s'", (int)field->length,
+                               item->valuestring);
+            }
+            value = item ? item->valuedouble : 0;
+        } else {
+            value = (double)field->min + rank;
+        }
+    }
+    switch (field->type) {
+        case TSDB_DATA_TYPE_BOOL:
+            return sprintf(pstr, "%s", ((int64_t)value & 1) ? "true" : "false");
+        case TSDB_DATA_TYPE_FLOAT:
+            return sprintf(pstr, "%.7g", value);
+        case TSDB_DATA_TYPE_DOUBLE:
+            return sprintf(pstr, "%.15g", value);
+        case TSDB_DATA_TYPE_BINARY:
+        case TSDB_DATA_TYPE_NCHAR: {
+            char tmp[BIGINT_BUFF_LEN];
+            tmp[benchInt64ToStr((int64_t)value, tmp)] = '\0';
+            return sprintf(pstr, "'%.*s'", (int)field->length, tmp);
+        }
+        default:
+            return benchInt64ToStr((int64_t)value, pstr);
+    }
+}
+
+// render one "(ts,c1,c2...)" tuple, generated columns are computed for the
+// table and timestamp, the others come from the prepared row
+uint32_t renderColumnGenRow(char *pstr, SSuperTable *stbInfo,
+                            uint64_t tableSeq, int64_t pos,
+                            int64_t timestamp) {
+    uint64_t n = 0;
+    // disorder can put a row before the start, it then takes row 0's values
+    if (stbInfo->timestamp_step > 0 && timestamp > stbInfo->startTimestamp) {
+        n = (uint64_t)((timestamp - stbInfo->startTimestamp) /
+                       stbInfo->timestamp_step);
+    }
+    char *p = pstr;
+    *p++ = '(';
+    p += benchInt64ToStr(timestamp, p);
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < stbInfo->cols->size; i++) {
+        Field *field = benchArrayGet(stbInfo->cols, i);
+        if (field->none) {
+            continue;
+        }
+        *p++ = ',';
+        SColumnGen *gen = field->gen;
+        if (gen && gen->nullRatio > 0 &&
+            genUniform(((uint64_t)i << 8) + 0xFF, tableSeq, n) <
+                gen->nullRatio) {
+            memcpy(p, "null", 4);
+            p += 4;
+        } else if (gen && gen->kind != COLUMN_GEN_SAMPLE) {
+            p += renderColumnValue(
+                p, field, genColumnValue(field, i, tableSeq, n));
+        } else {
+            SRowFragment *col =
+                stbInfo->sampleCols + pos * stbInfo->partialColumnNum + out;
+            memcpy(p, col->data, col->len);
+            p += col->len;
+        }
+        out++;
+    }
+    *p++ = ')';
+    return (uint32_t)(p - pstr);
+}
+
+// split every prepared row into its column values so generated columns can
+// be spliced in between them
+static void prepareSampleCols(SSuperTable *stbInfo) {
+    uint32_t ncols = stbInfo->partialColumnNum;
+    stbInfo->sampleCols = benchCalloc(g_arguments->prepared_rand * ncols,
+                                      sizeof(SRowFragment), true);
+    for (int64_t i = 0; i < g_arguments->prepared_rand; ++i) {
+        char *        p = stbInfo->sampleRows[i].data;
+        char *        end = p + stbInfo->sampleRows[i].len;
+        SRowFragment *col = stbInfo->sampleCols + i * ncols;
+        for (uint32_t j = 0; j < ncols && p <= end; j++) {
+            char *start = p;
+            bool  quoted = false;
+            while (p < end && (quoted || *p != ',')) {
+                if (*p == '\'') quoted = !quoted;
+                p++;
+            }
+            col[j].data = start;
+            col[j].len = (uint32_t)(p - start);
+            p++;
+        }
+    }
+}
+
+static void prepareColumnGen(SSuperTable *stbInfo) {
+    for (uint32_t i = 0; i < stbInfo->cols->size; i++) {
+        Field *     field = benchArrayGet(stbInfo->cols, i);
+        SColumnGen *gen = field->gen;
+        if (gen == NULL || gen->kind != COLUMN_GEN_ZIPF) {
+            continue;
+        }
+        if (field->values) {
+            gen->categories = tools_cJSON_GetArraySize(field->values);
+        } else {
+            double range = (double)field->max - (double)field->min + 1;
+            gen->categories = range < GEN_MAX_CATEGORIES
+                                  ? (uint32_t)range : GEN_MAX_CATEGORIES;
+        }
+        if (gen->categories == 0) gen->categories = 1;
+        gen->cdf = benchCalloc(gen->categories, sizeof(double), true);
+        double total = 0;
+        for (uint32_t r = 0; r < gen->categories; r++) {
+            total += 1.0 / pow(r + 1, gen->skew);
+            gen->cdf[r] = total;
+        }
+        for (uint32_t r = 0; r < gen->categories; r++) {
+            gen->cdf[r] /= total;
+        }
+    }
+    // the json parser only allows generators for taosc and rest
+    prepareSampleCols(stbInfo);
+}
+
+// tags are rendered on demand from a stream keyed by the stable and the
+// table index instead of being kept for every child table, a few recently
+// used strings may be cached per thread (tag_cache)
+typedef struct STagCacheEntry_S {
+    SSuperTable *stbInfo;
+    uint64_t     tableSeq;
+    uint64_t     lastUse;
+    char *       tags;
+    uint32_t     cap;
+} STagCacheEntry;
+
+static BENCH_THREAD_LOCAL STagCacheEntry *g_tagCache = NULL;
+static BENCH_THREAD_LOCAL uint64_t        g_tagCacheTick = 0;
+static BENCH_THREAD_LOCAL char *          g_tagScratch = NULL;
+static BENCH_THREAD_LOCAL uint32_t        g_tagScratchCap = 0;
+
+static FORCE_INLINE uint64_t childTblTagKey(SSuperTable *stbInfo,
+                                            uint64_t     tableSeq) {
+    return genMix(stbInfo->tagSeed ^ genMix(tableSeq));
+}
+
+static char *growTagBuf(char *buf, uint32_t *cap, uint32_t need) {
+    if (*cap < need) {
+        tmfree(buf);
+        buf = benchCalloc(1, need, false);
+        *cap = need;
+    }
+    return buf;
+}
+
+static void renderChildTblTags(SSuperTable *stbInfo, uint64_t tableSeq,
+                               char *buf) {
+    uint64_t saved[4];
+    benchRandKeyed(childTblTagKey(stbInfo, tableSeq), saved);
+    generateRandData(stbInfo, buf, stbInfo->lenOfTags, stbInfo->tags, 1,
+                     true);
+    benchRandRestore(saved);
+}
+
+// the tags of one child table, the same for the same seed whichever thread
+// asks. The string stays valid until the thread's next call
+char *getChildTblTags(SSuperTable *stbInfo, uint64_t tableSeq) {
+    if (stbInfo->tagRows) {
+        return stbInfo->tagRows[tableSeq % stbInfo->tagRowCount].data;
+    }
+    uint32_t size = g_arguments->tag_cache;
+    if (size == 0) {
+        g_tagScratch =
+            growTagBuf(g_tagScratch, &g_tagScratchCap, stbInfo->lenOfTags);
+        renderChildTblTags(stbInfo, tableSeq, g_tagScratch);
+        return g_tagScratch;
+    }
+    if (g_tagCache == NULL) {
+        g_tagCache = benchCalloc(size, sizeof(STagCacheEntry), false);
+    }
+    STagCacheEntry *victim = g_tagCache;
+    for (uint32_t i = 0; i < size; i++) {
+        STagCacheEntry *entry = g_tagCache + i;
+        if (entry->stbInfo == stbInfo && entry->tableSeq == tableSeq) {
+            entry->lastUse = ++g_tagCacheTick;
+            return entry->tags;
+        }
+        if (entry->lastUse < victim->lastUse) {
+            victim = entry;
+        }
+    }
+    victim->tags = growTagBuf(victim->tags, &victim->cap, stbInfo->lenOfTags);
+    renderChildTblTags(stbInfo, tableSeq, victim->tags);
+    victim->stbInfo = stbInfo;
+    victim->tableSeq = tableSeq;
+    victim->lastUse = ++g_tagCacheTick;
+    return victim->tags;
+}
+
+void freeTagCache() {
+    if (g_tagCache) {
+        for (uint32_t i = 0; i < g_arguments->tag_cache; i++) {
+            tmfree(g_tagCache[i].tags);
+        }
+        tmfree(g_tagCache);
+        g_tagCache = NULL;
+    }
+    tmfree(g_tagScratch);
+    g_tagScratch = NULL;
+    g_tagScratchCap = 0;
+}
+
+// column values the insert threads copy rows from
+static int prepareSampleRows(SSuperTable *stbInfo) {
+    infoPrint(stdout,
+              "generate stable<%s> columns data with lenOfCols<%u> * "
+              "prepared_rand<%" PRIu64 ">\n",
+              stbInfo->stbName, stbInfo->lenOfCols, g_arguments->prepared_rand);
+    stbInfo->sampleRows = benchCalloc(g_arguments->prepared_rand,
+                                      sizeof(SRowFragment), true);
+    if (stbInfo->random_data_source) {
+        stbInfo->sampleDataBuf = benchCalloc(
+            1, stbInfo->lenOfCols * g_arguments->prepared_rand, true);
+        generateRandData(stbInfo, stbInfo->sampleDataBuf, stbInfo->lenOfCols,
+                         stbInfo->cols, g_arguments->prepared_rand, false);
+        for (int64_t i = 0; i < g_arguments->prepared_rand; ++i) {
+            stbInfo->sampleRows[i].data =
+                stbInfo->sampleDataBuf + i * stbInfo->lenOfCols;
+            stbInfo->sampleRows[i].len =
+                (uint32_t)strlen(stbInfo->sampleRows[i].data);
+        }
+    } else {
+        // a short file is repeated to fill prepared_rand rows
+        SRowFragment *rows = NULL;
+        uint64_t      count = 0;
+        uint64_t      fileRows = 0;
+        if (loadCsvRows(stbInfo, stbInfo->sampleFile, stbInfo->cols,
+                        stbInfo->useSampleTs, stbInfo->lenOfCols,
+                        g_arguments->prepared_rand, stbInfo->useSampleTs,
+                        &stbInfo->sampleDataBuf, &rows, &count, &fileRows)) {
+            return -1;
+        }
+        if (stbInfo->useSampleTs) {
+            stbInfo->insertRows = fileRows;
+        }
+        for (int64_t i = 0; i < g_arguments->prepared_rand; ++i) {
+            stbInfo->sampleRows[i] = rows[i % count];
+        }
+        tmfree(rows);
+    }
+    debugPrint(stdout, "sampleDataBuf: %s\n", stbInfo->sampleDataBuf);
+    if (stbInfo->columnGen) {
+        if (!stbInfo->random_data_source) {
+            infoPrint(stdout,
+                      "column generators are ignored for stable<%s> with "
+                      "sample file\n",
+                      stbInfo->stbName);
+            stbInfo->columnGen = false;
+        } else {
+            prepareColumnGen(stbInfo);
+        }
+    }
+    return 0;
+}
+
 int prepare_sample_data(int db_index, int stb_index) {
     SDataBase *  database = benchArrayGet(g_arguments->databases, db_index);
     SSuperTable *stbInfo = benchArrayGet(database->superTbls, stb_index);
@@ -737,43 +1423,28 @@ int prepare_sample_data(int db_index, int stb_index) {
     } else {
         stbInfo->partialColumnNum = stbInfo->cols->size;
     }
-    stbInfo->sampleDataBuf =
-            benchCalloc(1, stbInfo->lenOfCols * g_arguments->prepared_rand, true);
-    infoPrint(stdout,
-              "generate stable<%s> columns data with lenOfCols<%u> * "
-              "prepared_rand<%" PRIu64 ">\n",
-              stbInfo->stbName, stbInfo->lenOfCols, g_arguments->prepared_rand);
-    if (stbInfo->random_data_source) {
-        generateRandData(stbInfo, stbInfo->sampleDataBuf, stbInfo->lenOfCols,
-                         stbInfo->cols, g_arguments->prepared_rand, false);
-    } else {
-        if (stbInfo->useSampleTs) {
-            if (getAndSetRowsFromCsvFile(stbInfo)) return -1;
-        }
-        if (generateSampleFromCsvForStb(stbInfo->sampleDataBuf,
-                                        stbInfo->sampleFile, stbInfo->lenOfCols,
-                                        g_arguments->prepared_rand)) {
-            return -1;
-        }
+    // a controller only creates the tables, its agents generate the rows
+    if (g_arguments->agents == NULL && prepareSampleRows(stbInfo)) {
+        return -1;
     }
-    debugPrint(stdout, "sampleDataBuf: %s\n", stbInfo->sampleDataBuf);
 
-    if (!stbInfo->childTblExists && stbInfo->tags->size != 0) {
-        stbInfo->tagDataBuf =
-                benchCalloc(1, stbInfo->childTblCount * stbInfo->lenOfTags, true);
+    // FNV-1a of the stable name, so a stable keeps its tags across runs
+    stbInfo->tagSeed = 0xCBF29CE484222325ULL;
+    for (const char *c = stbInfo->stbName; *c; c++) {
+        stbInfo->tagSeed = (stbInfo->tagSeed ^ (uint8_t)*c) * 0x100000001B3ULL;
+    }
+    if (!stbInfo->childTblExists && stbInfo->tags->size != 0 &&
+        stbInfo->tagsFile[0] != 0) {
         infoPrint(stdout,
-                  "generate stable<%s> tags data with lenOfTags<%u> * "
+                  "read stable<%s> tags data with lenOfTags<%u> * "
                   "childTblCount<%" PRIu64 ">\n",
                   stbInfo->stbName, stbInfo->lenOfTags, stbInfo->childTblCount);
-        if (stbInfo->tagsFile[0] != 0) {
-            if (generateSampleFromCsvForStb(
-                    stbInfo->tagDataBuf, stbInfo->tagsFile, stbInfo->lenOfTags,
-                    stbInfo->childTblCount)) {
-                return -1;
-            }
-        } else {
-            generateRandData(stbInfo, stbInfo->tagDataBuf, stbInfo->lenOfTags,
-                             stbInfo->tags, stbInfo->childTblCount, true);
+        // child tables past the end of the file wrap around to its start
+        if (loadCsvRows(stbInfo, stbInfo->tagsFile, stbInfo->tags, false,
+                        stbInfo->lenOfTags, stbInfo->childTblCount, false,
+                        &stbInfo->tagDataBuf, &stbInfo->tagRows,
+                        &stbInfo->tagRowCount, NULL)) {
+            return -1;
         }
         debugPrint(stdout, "tagDataBuf: %s\n", stbInfo->tagDataBuf);
     }
@@ -802,53 +1473,85 @@ int64_t getTSRandTail(int64_t timeStampStep, int32_t seq, int disorderRatio,
                       int disorderRange) {
     int64_t randTail = timeStampStep * seq;
     if (disorderRatio > 0) {
-        int rand_num = taosRandom() % 100;
-        if (rand_num < disorderRatio) {
-            randTail = (randTail + (taosRandom() % disorderRange + 1)) * (-1);
+        if (benchRandBelow(100) < (uint32_t)disorderRatio) {
+            randTail = (randTail + benchRandBelow(disorderRange) + 1) * (-1);
         }
     }
     return randTail;
 }
 
-int bindParamBatch(threadInfo *pThreadInfo, uint32_t batch, int64_t startTime) {
-    TAOS_STMT *  stmt = pThreadInfo->stmt;
-    SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
-    SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
-    uint32_t     columnCount = stbInfo->cols->size;
-    memset(pThreadInfo->bindParams, 0,
-           (sizeof(TAOS_MULTI_BIND) * (columnCount + 1)));
-    memset(pThreadInfo->is_null, 0, batch);
-
-    for (int c = 0; c < columnCount + 1; c++) {
-        TAOS_MULTI_BIND *param =
-            (TAOS_MULTI_BIND *)(pThreadInfo->bindParams +
-                                sizeof(TAOS_MULTI_BIND) * c);
-
-        char data_type;
+// build the per-thread bind descriptors once, each batch only re-points
+// their buffers at a window of the prepared column data; columns with the
+// same width share one length array
+void initStmtBind(threadInfo *pThreadInfo, SSuperTable *stbInfo) {
+    uint32_t columnCount = stbInfo->cols->size;
+    uint32_t rows = g_arguments->reqPerReq;
+    pThreadInfo->bind_ts_array =
+        benchCalloc(1, sizeof(int64_t) * rows, true);
+    pThreadInfo->bindParams =
+        benchCalloc(1, sizeof(TAOS_MULTI_BIND) * (columnCount + 1), true);
+    pThreadInfo->is_null = benchCalloc(1, rows, true);
+    pThreadInfo->bindRow = 0;
 
+    TAOS_MULTI_BIND *params = (TAOS_MULTI_BIND *)pThreadInfo->bindParams;
+    uint32_t widths = 0;
+    for (uint32_t c = 0; c < columnCount + 1; c++) {
+        TAOS_MULTI_BIND *param = params + c;
         if (c == 0) {
-            data_type = TSDB_DATA_TYPE_TIMESTAMP;
+            param->buffer_type = TSDB_DATA_TYPE_TIMESTAMP;
             param->buffer_length = sizeof(int64_t);
-            param->buffer = pThreadInfo->bind_ts_array;
-
         } else {
-            Field * col = benchArrayGet(stbInfo->cols, c - 1);
-            data_type = col->type;
-            param->buffer = col->data;
+            Field *col = benchArrayGet(stbInfo->cols, c - 1);
+            param->buffer_type = col->type;
             param->buffer_length = col->length;
             debugPrint(stdout, "col[%d]: type: %s, len: %d\n", c,
-                       taos_convert_datatype_to_string(data_type),
+                       taos_convert_datatype_to_string(col->type),
                        col->length);
         }
-        param->buffer_type = data_type;
-        param->length = benchCalloc(batch, sizeof(int32_t), true);
+        param->is_null = pThreadInfo->is_null;
+        uint32_t prev = 0;
+        while (prev < c && params[prev].buffer_length != param->buffer_length) {
+            prev++;
+        }
+        if (prev == c) {
+            widths++;
+        }
+    }
 
-        for (int b = 0; b < batch; b++) {
-            param->length[b] = (int32_t)param->buffer_length;
+    pThreadInfo->bind_lengths =
+        benchCalloc(widths, sizeof(int32_t) * rows, true);
+    int32_t *next = pThreadInfo->bind_lengths;
+    for (uint32_t c = 0; c < columnCount + 1; c++) {
+        TAOS_MULTI_BIND *param = params + c;
+        uint32_t prev = 0;
+        while (prev < c && params[prev].buffer_length != param->buffer_length) {
+            prev++;
         }
-        param->is_null = pThreadInfo->is_null;
-        param->num = batch;
+        if (prev < c) {
+            param->length = params[prev].length;
+            continue;
+        }
+        param->length = next;
+        for (uint32_t r = 0; r < rows; r++) {
+            next[r] = (int32_t)param->buffer_length;
+        }
+        next += rows;
     }
+}
+
+void freeStmtBind(threadInfo *pThreadInfo) {
+    tmfree(pThreadInfo->bind_ts_array);
+    tmfree(pThreadInfo->bindParams);
+    tmfree(pThreadInfo->is_null);
+    tmfree(pThreadInfo->bind_lengths);
+}
+
+int bindParamBatch(threadInfo *pThreadInfo, uint32_t batch, int64_t startTime) {
+    TAOS_STMT *  stmt = pThreadInfo->stmt;
+    SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
+    SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
+    uint32_t     columnCount = stbInfo->cols->size;
+    TAOS_MULTI_BIND *params = (TAOS_MULTI_BIND *)pThreadInfo->bindParams;
 
     for (uint32_t k = 0; k < batch; k++) {
         /* columnCount + 1 (ts) */
@@ -863,31 +1566,54 @@ int bindParamBatch(threadInfo *pThreadInfo, uint32_t batch, int64_t startTime) {
         }
     }
 
-    if (taos_stmt_bind_param_batch(
-            stmt, (TAOS_MULTI_BIND *)pThreadInfo->bindParams)) {
-        errorPrint(stderr, "taos_stmt_bind_param_batch() failed! reason: %s\n",
-                   taos_stmt_errstr(stmt));
-        return -1;
-    }
+    // walk the prepared rows like the sql path does, a batch that runs past
+    // the end is bound as two windows
+    int32_t  prev = benchPhaseSwitch(pThreadInfo, PHASE_BIND);
+    uint32_t done = 0;
+    while (done < batch) {
+        if (pThreadInfo->bindRow >= g_arguments->prepared_rand) {
+            pThreadInfo->bindRow = 0;
+        }
+        uint64_t left = g_arguments->prepared_rand - pThreadInfo->bindRow;
+        uint32_t n = (batch - done) < left ? (batch - done) : (uint32_t)left;
 
-    for (int c = 0; c < stbInfo->cols->size + 1; c++) {
-        TAOS_MULTI_BIND *param =
-            (TAOS_MULTI_BIND *)(pThreadInfo->bindParams +
-                                sizeof(TAOS_MULTI_BIND) * c);
-        tmfree(param->length);
-    }
+        params[0].buffer = pThreadInfo->bind_ts_array + done;
+        params[0].num = n;
+        for (uint32_t c = 1; c < columnCount + 1; c++) {
+            Field *col = benchArrayGet(stbInfo->cols, c - 1);
+            params[c].buffer =
+                (char *)col->data + pThreadInfo->bindRow * col->length;
+            params[c].num = n;
+        }
 
-    // if msg > 3MB, break
-    if (taos_stmt_add_batch(stmt)) {
-        errorPrint(stderr, "taos_stmt_add_batch() failed! reason: %s\n",
-                   taos_stmt_errstr(stmt));
-        return -1;
+        if (taos_stmt_bind_param_batch(stmt, params)) {
+            errorPrint(stderr,
+                       "taos_stmt_bind_param_batch() failed! reason: %s\n",
+                       taos_stmt_errstr(stmt));
+            benchPhaseSwitch(pThreadInfo, prev);
+            return -1;
+        }
+
+        // if msg > 3MB, break
+        if (taos_stmt_add_batch(stmt)) {
+            errorPrint(stderr, "taos_stmt_add_batch() failed! reason: %s\n",
+                       taos_stmt_errstr(stmt));
+            benchPhaseSwitch(pThreadInfo, prev);
+            return -1;
+        }
+        done += n;
+        pThreadInfo->bindRow += n;
     }
+    benchPhaseSwitch(pThreadInfo, prev);
     return batch;
 }
 
-void generateSmlJsonTags(tools_cJSON *tagsList, SSuperTable *stbInfo,
-                            uint64_t start_table_from, int tbSeq) {
+// build one table's tag object and return its compact text, rows only copy
+// it so the tree is walked once per table instead of once per row
+char *generateSmlJsonTags(SSuperTable *stbInfo, uint64_t start_table_from,
+                          int tbSeq) {
+    uint64_t saved[4];
+    benchRandKeyed(childTblTagKey(stbInfo, tbSeq + start_table_from), saved);
     tools_cJSON * tags = tools_cJSON_CreateObject();
     char *  tbName = benchCalloc(1, TSDB_TABLE_NAME_LEN, true);
     snprintf(tbName, TSDB_TABLE_NAME_LEN, "%s%" PRIu64 "",
@@ -945,71 +1671,87 @@ void generateSmlJsonTags(tools_cJSON *tagsList, SSuperTable *stbInfo,
         }
         tools_cJSON_AddItemToObject(tags, tagName, tagObj);
     }
-    tools_cJSON_AddItemToArray(tagsList, tags);
+    benchRandRestore(saved);
+    char *text = tools_cJSON_PrintUnformatted(tags);
+    tools_cJSON_Delete(tags);
     tmfree(tagName);
     tmfree(tbName);
+    return text;
+}
+
+// upper bound of one row written by generateSmlJsonCols, without the tags
+uint32_t calcSmlJsonColLen(SSuperTable *stbInfo) {
+    Field *col = benchArrayGet(stbInfo->cols, 0);
+    return (uint32_t)strlen(stbInfo->stbName) + col->length + 160;
+}
+
+static FORCE_INLINE char *appendStr(char *p, const char *s, size_t len) {
+    memcpy(p, s, len);
+    return p + len;
 }
 
-void generateSmlJsonCols(tools_cJSON *array, tools_cJSON *tag, SSuperTable *stbInfo,
-                            uint32_t time_precision, int64_t timestamp) {
-    tools_cJSON * record = tools_cJSON_CreateObject();
-    tools_cJSON * ts = tools_cJSON_CreateObject();
-    tools_cJSON_AddNumberToObject(ts, "value", (double)timestamp);
+#define APPEND_LITERAL(p, s) appendStr((p), (s), sizeof(s) - 1)
+
+// write one OpenTSDB json record straight into pstr, the caller adds the
+// array brackets and separators
+uint32_t generateSmlJsonCols(char *pstr, const char *tags, SSuperTable *stbInfo,
+                             uint32_t time_precision, int64_t timestamp) {
+    char *p = pstr;
+    p = APPEND_LITERAL(p, "{\"timestamp\":{\"value\":");
+    p += benchInt64ToStr(timestamp, p);
     if (time_precision == TSDB_SML_TIMESTAMP_MILLI_SECONDS) {
-        tools_cJSON_AddStringToObject(ts, "type", "ms");
+        p = APPEND_LITERAL(p, ",\"type\":\"ms\"");
     } else if (time_precision == TSDB_SML_TIMESTAMP_MICRO_SECONDS) {
-        tools_cJSON_AddStringToObject(ts, "type", "us");
+        p = APPEND_LITERAL(p, ",\"type\":\"us\"");
     } else if (time_precision == TSDB_SML_TIMESTAMP_NANO_SECONDS) {
-        tools_cJSON_AddStringToObject(ts, "type", "ns");
+        p = APPEND_LITERAL(p, ",\"type\":\"ns\"");
     }
-    tools_cJSON *value = tools_cJSON_CreateObject();
+    p = APPEND_LITERAL(p, "},\"value\":{\"value\":");
     Field* col = benchArrayGet(stbInfo->cols, 0);
+    const char *type;
     switch (col->type) {
         case TSDB_DATA_TYPE_BOOL:
-            tools_cJSON_AddBoolToObject(value, "value", (taosRandom() % 2) & 1);
-            tools_cJSON_AddStringToObject(value, "type", "bool");
+            if ((taosRandom() % 2) & 1) {
+                p = APPEND_LITERAL(p, "true");
+            } else {
+                p = APPEND_LITERAL(p, "false");
+            }
+            type = "bool";
             break;
         case TSDB_DATA_TYPE_FLOAT:
-            tools_cJSON_AddNumberToObject(
-                value, "value",
-                (float)(col->min +
-                        (taosRandom() % (col->max - col->min)) +
-                        taosRandom() % 1000 / 1000.0));
-            tools_cJSON_AddStringToObject(value, "type", "float");
+            p += sprintf(p, "%.7g",
+                         (float)(col->min +
+                                 (taosRandom() % (col->max - col->min)) +
+                                 taosRandom() % 1000 / 1000.0));
+            type = "float";
             break;
         case TSDB_DATA_TYPE_DOUBLE:
-            tools_cJSON_AddNumberToObject(
-                value, "value",
-                (double)(col->min +
-                         (taosRandom() % (col->max - col->min)) +
-                         taosRandom() % 1000000 / 1000000.0));
-            tools_cJSON_AddStringToObject(value, "type", "double");
+            p += sprintf(p, "%.15g",
+                         (double)(col->min +
+                                  (taosRandom() % (col->max - col->min)) +
+                                  taosRandom() % 1000000 / 1000000.0));
+            type = "double";
             break;
         case TSDB_DATA_TYPE_BINARY:
-        case TSDB_DATA_TYPE_NCHAR: {
-            char *buf = (char *)benchCalloc(col->length + 1, 1, false);
-            rand_string(buf, col->length, g_arguments->chinese);
-            if (col->type == TSDB_DATA_TYPE_BINARY) {
-                tools_cJSON_AddStringToObject(value, "value", buf);
-                tools_cJSON_AddStringToObject(value, "type", "binary");
-            } else {
-                tools_cJSON_AddStringToObject(value, "value", buf);
-                tools_cJSON_AddStringToObject(value, "type", "nchar");
-            }
-            tmfree(buf);
+        case TSDB_DATA_TYPE_NCHAR:
+            // the generated characters never need json escaping
+            *p++ = '"';
+            p += rand_string(p, col->length, g_arguments->chinese);
+            *p++ = '"';
+            type = col->type == TSDB_DATA_TYPE_BINARY ? "binary" : "nchar";
             break;
-        }
         default:
-            tools_cJSON_AddNumberToObject(
-                    value, "value",
-                    (double)col->min +
-                    (taosRandom() % (col->max - col->min)));
-            tools_cJSON_AddStringToObject(value, "type", taos_convert_datatype_to_string(col->type));
+            p += benchInt64ToStr(
+                col->min + (taosRandom() % (col->max - col->min)), p);
+            type = taos_convert_datatype_to_string(col->type);
             break;
     }
-    tools_cJSON_AddItemToObject(record, "timestamp", ts);
-    tools_cJSON_AddItemToObject(record, "value", value);
-    tools_cJSON_AddItemToObject(record, "tags", tag);
-    tools_cJSON_AddStringToObject(record, "metric", stbInfo->stbName);
-    tools_cJSON_AddItemToArray(array, record);
+    p = APPEND_LITERAL(p, ",\"type\":\"");
+    p = appendStr(p, type, strlen(type));
+    p = APPEND_LITERAL(p, "\"},\"tags\":");
+    p = appendStr(p, tags, strlen(tags));
+    p = APPEND_LITERAL(p, ",\"metric\":\"");
+    p = appendStr(p, stbInfo->stbName, strlen(stbInfo->stbName));
+    p = APPEND_LITERAL(p, "\"}");
+    return (uint32_t)(p - pstr);
 }
@@ -320,6 +320,198 @@ int createDatabase(int db_index) {
     return 0;
 }
 
+#define CREATE_RETRY_MAX 10
+// mnode transaction conflict, concurrent DDL only has to be resent
+#define CREATE_CONFLICT_CODE ((int32_t)0x800003D3)
+
+// one batch of create table statements, owned by the creating thread, in
+// flight or waiting to be reaped by it
+typedef struct SCreateSlot_S {
+    char *                buffer;
+    int32_t               len;
+    uint32_t              tables;
+    uint32_t              retries;
+    int32_t               code;
+    int64_t               startTs;
+    int64_t               endTs;
+    char                  errstr[SQL_BUFF_LEN];
+    struct SCreatePool_S *pool;
+    struct SCreateSlot_S *next;
+} SCreateSlot;
+
+typedef struct SCreatePool_S {
+    threadInfo *    pThreadInfo;
+    SSuperTable *   stbInfo;
+    SCreateSlot *   slots;
+    SCreateSlot *   freeSlots;
+    SCreateSlot *   doneSlots;
+    uint32_t        size;
+    uint32_t        inflight;
+    uint32_t        bufLen;
+    uint64_t        batchTarget;  // tables per batch, adapted to latency
+    uint64_t        batchMax;     // tables a full batch buffer held
+    bool            failed;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} SCreatePool;
+
+static void finishCreateBatch(SCreateSlot *slot, TAOS_RES *res) {
+    SCreatePool *pool = slot->pool;
+    slot->endTs = toolsGetTimestampUs();
+    slot->code = taos_errno(res);
+    if (slot->code) {
+        tstrncpy(slot->errstr, taos_errstr(res), sizeof(slot->errstr));
+    }
+    taos_free_result(res);
+    pthread_mutex_lock(&pool->mutex);
+    slot->next = pool->doneSlots;
+    pool->doneSlots = slot;
+    pool->inflight--;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void createBatchCallback(void *param, TAOS_RES *res, int code) {
+    finishCreateBatch((SCreateSlot *)param, res);
+}
+
+static void submitCreateBatch(SCreatePool *pool, SCreateSlot *slot) {
+    threadInfo *pThreadInfo = pool->pThreadInfo;
+    pthread_mutex_lock(&pool->mutex);
+    pool->inflight++;
+    pthread_mutex_unlock(&pool->mutex);
+    slot->startTs = toolsGetTimestampUs();
+    if (pool->stbInfo->create_table_inflight > 0) {
+        taos_query_a(pThreadInfo->taos, slot->buffer, createBatchCallback,
+                     slot);
+    } else {
+        finishCreateBatch(slot, taos_query(pThreadInfo->taos, slot->buffer));
+    }
+}
+
+// additive increase while batches come back under the target latency up
+// to what fits in a buffer, halve them as soon as one exceeds it
+static void adaptCreateBatch(SCreatePool *pool, uint64_t delay) {
+    uint64_t target = (uint64_t)pool->stbInfo->create_table_target_ms * 1000;
+    if (target == 0) {
+        return;
+    }
+    if (delay > target) {
+        pool->batchTarget = pool->batchTarget > 1 ? pool->batchTarget / 2 : 1;
+    } else if (delay < target * 3 / 4) {
+        pool->batchTarget += pool->batchTarget / 4 + 1;
+        if (pool->batchTarget > pool->batchMax) {
+            pool->batchTarget = pool->batchMax;
+        }
+    }
+}
+
+// handle finished batches until a slot is free, or until nothing is in
+// flight when draining; conflicts are resent, other errors fail the thread
+static int reapCreateBatches(SCreatePool *pool, bool drain) {
+    threadInfo *pThreadInfo = pool->pThreadInfo;
+    while (true) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->doneSlots == NULL &&
+               (drain ? pool->inflight > 0 : pool->freeSlots == NULL)) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        }
+        SCreateSlot *done = pool->doneSlots;
+        pool->doneSlots = NULL;
+        pthread_mutex_unlock(&pool->mutex);
+        if (done == NULL) {
+            return pool->failed ? -1 : 0;
+        }
+        while (done) {
+            SCreateSlot *slot = done;
+            done = slot->next;
+            if (slot->code == 0) {
+                uint64_t delay = slot->endTs - slot->startTs;
+                pThreadInfo->tables_created += slot->tables;
+                benchHistRecord(&pThreadInfo->delayHist, delay);
+                adaptCreateBatch(pool, delay);
+            } else if (!pool->failed && !g_arguments->terminate &&
+                       slot->retries < CREATE_RETRY_MAX &&
+                       slot->code == CREATE_CONFLICT_CODE) {
+                slot->retries++;
+                pThreadInfo->create_retries++;
+                toolsMsleep(10 * slot->retries);
+                submitCreateBatch(pool, slot);
+                continue;
+            } else if (!pool->failed) {
+                errorPrint(stderr, "Failed to execute <%s>, reason: %s\n",
+                           slot->buffer, slot->errstr);
+                pool->failed = true;
+            }
+            slot->len = 0;
+            slot->tables = 0;
+            slot->retries = 0;
+            pthread_mutex_lock(&pool->mutex);
+            slot->next = pool->freeSlots;
+            pool->freeSlots = slot;
+            pthread_mutex_unlock(&pool->mutex);
+        }
+    }
+}
+
+static SCreateSlot *takeCreateSlot(SCreatePool *pool) {
+    if (reapCreateBatches(pool, false)) {
+        return NULL;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    SCreateSlot *slot = pool->freeSlots;
+    pool->freeSlots = slot->next;
+    pthread_mutex_unlock(&pool->mutex);
+    return slot;
+}
+
+static void initCreatePool(SCreatePool *pool, threadInfo *pThreadInfo,
+                           SSuperTable *stbInfo) {
+    pool->pThreadInfo = pThreadInfo;
+    pool->stbInfo = stbInfo;
+    pool->size = stbInfo->create_table_inflight > 0
+                     ? stbInfo->create_table_inflight
+                     : 1;
+    pool->bufLen = TSDB_MAX_SQL_LEN;
+    if (stbInfo->create_table_batch_bytes > 0 &&
+        stbInfo->create_table_batch_bytes < TSDB_MAX_SQL_LEN) {
+        pool->bufLen = stbInfo->create_table_batch_bytes;
+    }
+    // one statement always has to fit
+    uint32_t minLen = stbInfo->lenOfTags + 2 * EXTRA_SQL_LEN +
+                      (uint32_t)strlen(stbInfo->colsOfCreateChildTable);
+    if (pool->bufLen < minLen) {
+        pool->bufLen = minLen;
+    }
+    // lowered to what fits once a batch fills its buffer
+    pool->batchMax =
+        pThreadInfo->end_table_to - pThreadInfo->start_table_from + 1;
+    pool->batchTarget =
+        stbInfo->batchCreateTableNum > 0 ? stbInfo->batchCreateTableNum : 1;
+    if (pool->batchTarget > pool->batchMax) {
+        pool->batchTarget = pool->batchMax;
+    }
+    pool->slots = benchCalloc(pool->size, sizeof(SCreateSlot), false);
+    for (uint32_t i = 0; i < pool->size; i++) {
+        SCreateSlot *slot = pool->slots + i;
+        slot->pool = pool;
+        slot->buffer = benchCalloc(1, pool->bufLen, false);
+        slot->next = pool->freeSlots;
+        pool->freeSlots = slot;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+}
+
+static void destroyCreatePool(SCreatePool *pool) {
+    for (uint32_t i = 0; i < pool->size; i++) {
+        tmfree(pool->slots[i].buffer);
+    }
+    tmfree(pool->slots);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond);
+}
+
 static void *createTable(void *sarg) {
     int32_t *code = benchCalloc(1, sizeof(int32_t), false);
     *code = -1;
@@ -330,9 +522,9 @@ static void *createTable(void *sarg) {
     prctl(PR_SET_NAME, "createTable");
 #endif
     uint64_t lastPrintTime = toolsGetTimestampMs();
-    pThreadInfo->buffer = benchCalloc(1, TSDB_MAX_SQL_LEN, false);
-    int len = 0;
-    int batchNum = 0;
+    SCreatePool pool = {0};
+    initCreatePool(&pool, pThreadInfo, stbInfo);
+    SCreateSlot *slot = takeCreateSlot(&pool);
     infoPrint(stdout,
               "thread[%d] start creating table from %" PRIu64 " to %" PRIu64
               "\n",
@@ -344,55 +536,56 @@ static void *createTable(void *sarg) {
         if (g_arguments->terminate) {
             goto create_table_end;
         }
+        char *buffer = slot->buffer;
+        int   size = pool.bufLen;
         if (!stbInfo->use_metric || stbInfo->tags->size == 0) {
             if (stbInfo->childTblCount == 1) {
-                snprintf(pThreadInfo->buffer, TSDB_MAX_SQL_LEN,
+                slot->len = snprintf(buffer, size,
                          stbInfo->escape_character
                          ? "CREATE TABLE IF NOT EXISTS %s.`%s` %s;"
                          : "CREATE TABLE IF NOT EXISTS %s.%s %s;",
                          database->dbName, stbInfo->stbName,
                          stbInfo->colsOfCreateChildTable);
             } else {
-                snprintf(pThreadInfo->buffer, TSDB_MAX_SQL_LEN,
+                slot->len = snprintf(buffer, size,
                          stbInfo->escape_character
                          ? "CREATE TABLE IF NOT EXISTS %s.`%s%" PRIu64 "` %s;"
                          : "CREATE TABLE IF NOT EXISTS %s.%s%" PRIu64 " %s;",
                          database->dbName, stbInfo->childTblPrefix, i,
                          stbInfo->colsOfCreateChildTable);
             }
-            batchNum++;
+            slot->tables++;
         } else {
-            if (0 == len) {
-                batchNum = 0;
-                memset(pThreadInfo->buffer, 0, TSDB_MAX_SQL_LEN);
-                len += snprintf(pThreadInfo->buffer + len,
-                                TSDB_MAX_SQL_LEN - len, "CREATE TABLE ");
+            if (0 == slot->len) {
+                slot->len += snprintf(buffer, size, "CREATE TABLE ");
             }
 
-            len += snprintf(
-                pThreadInfo->buffer + len, TSDB_MAX_SQL_LEN - len,
+            slot->len += snprintf(
+                buffer + slot->len, size - slot->len,
                 stbInfo->escape_character ? "if not exists %s.`%s%" PRIu64
                                             "` using %s.`%s` tags (%s) "
                                           : "if not exists %s.%s%" PRIu64
                                             " using %s.%s tags (%s) ",
                 database->dbName, stbInfo->childTblPrefix, i, database->dbName,
-                stbInfo->stbName, stbInfo->tagDataBuf + i * stbInfo->lenOfTags);
-            batchNum++;
-            if ((batchNum < stbInfo->batchCreateTableNum) &&
-                ((TSDB_MAX_SQL_LEN - len) >=
-                 (stbInfo->lenOfTags + EXTRA_SQL_LEN))) {
+                stbInfo->stbName, getChildTblTags(stbInfo, i));
+            slot->tables++;
+            if (i < pThreadInfo->end_table_to &&
+                slot->tables < pool.batchTarget &&
+                (size - slot->len) >= (stbInfo->lenOfTags + EXTRA_SQL_LEN)) {
                 continue;
             }
+            if (i < pThreadInfo->end_table_to &&
+                slot->tables < pool.batchTarget) {
+                pool.batchMax = slot->tables;
+                pool.batchTarget = slot->tables;
+            }
         }
 
-        len = 0;
-
-        if (0 != queryDbExec(pThreadInfo->taos, pThreadInfo->buffer,
-                             NO_INSERT_TYPE, false, false)) {
+        submitCreateBatch(&pool, slot);
+        slot = takeCreateSlot(&pool);
+        if (slot == NULL) {
             goto create_table_end;
         }
-        pThreadInfo->tables_created += batchNum;
-        batchNum = 0;
         uint64_t currentPrintTime = toolsGetTimestampMs();
         if (currentPrintTime - lastPrintTime > PRINT_STAT_INTERVAL) {
             infoPrint(stdout,
@@ -402,21 +595,32 @@ static void *createTable(void *sarg) {
         }
     }
 
-    if (0 != len) {
-        if (0 != queryDbExec(pThreadInfo->taos, pThreadInfo->buffer,
-                             NO_INSERT_TYPE, false, false)) {
-            goto create_table_end;
-        }
-        pThreadInfo->tables_created += batchNum;
+    if (0 == reapCreateBatches(&pool, true)) {
         debugPrint(stdout, "thread[%d] already created %" PRId64 " tables\n",
                    pThreadInfo->threadID, pThreadInfo->tables_created);
+        *code = 0;
     }
-    *code = 0;
 create_table_end:
-    tmfree(pThreadInfo->buffer);
+    // stop resending and wait out whatever is still in flight
+    pool.failed = true;
+    reapCreateBatches(&pool, true);
+    destroyCreatePool(&pool);
+    freeTagCache();
     return code;
 }
 
+static void printCreateReport(FILE *fp, SSuperTable *stbInfo,
+                              uint64_t created, uint64_t retries,
+                              int64_t spent, SLatencyHist *batchHist) {
+    if (spent == 0) spent = 1;
+    infoPrint(fp,
+              "created %" PRIu64 " table(s) of %s in %.4f seconds, %.2f "
+              "tables/second, %" PRIu64 " batch(es) resent after conflict\n",
+              created, stbInfo->stbName, spent / 1E6, created * 1E6 / spent,
+              retries);
+    benchHistPrint(fp, "create table batch delay", batchHist, 1000.0, "ms");
+}
+
 static int startMultiThreadCreateChildTable(int db_index, int stb_index) {
     int          threads = g_arguments->table_threads;
     SDataBase *  database = benchArrayGet(g_arguments->databases, db_index);
@@ -436,6 +640,7 @@ static int startMultiThreadCreateChildTable(int db_index, int stb_index) {
     }
 
     int64_t b = ntables % threads;
+    int64_t start = toolsGetTimestampUs();
 
     for (int64_t i = 0; i < threads; i++) {
         threadInfo *pThreadInfo = infos + i;
@@ -447,13 +652,14 @@ static int startMultiThreadCreateChildTable(int db_index, int stb_index) {
 
         pThreadInfo->stb_index = stb_index;
         pThreadInfo->db_index = db_index;
-        pThreadInfo->taos = select_one_from_pool(database->dbName);
+        pThreadInfo->taos = select_thread_conn(i, 0, database->dbName);
         pThreadInfo->start_table_from = tableFrom;
         pThreadInfo->ntables = i < b ? a + 1 : a;
         pThreadInfo->end_table_to = i < b ? tableFrom + a : tableFrom + a - 1;
         tableFrom = pThreadInfo->end_table_to + 1;
         pThreadInfo->minDelay = UINT64_MAX;
         pThreadInfo->tables_created = 0;
+        benchHistInit(&(pThreadInfo->delayHist), g_arguments->latency_max);
         pthread_create(pids + i, NULL, createTable, pThreadInfo);
     }
 
@@ -465,11 +671,25 @@ static int startMultiThreadCreateChildTable(int db_index, int stb_index) {
         }
         tmfree(result);
     }
+    int64_t spent = toolsGetTimestampUs() - start;
 
+    SLatencyHist batchHist;
+    benchHistInit(&batchHist, g_arguments->latency_max);
+    uint64_t created = 0, retries = 0;
     for (int i = 0; i < threads; i++) {
         threadInfo *pThreadInfo = infos + i;
-        g_arguments->g_actualChildTables += pThreadInfo->tables_created;
+        created += pThreadInfo->tables_created;
+        retries += pThreadInfo->create_retries;
+        benchHistMerge(&batchHist, &(pThreadInfo->delayHist));
+        benchHistDestroy(&(pThreadInfo->delayHist));
+    }
+    g_arguments->g_actualChildTables += created;
+    printCreateReport(stdout, stbInfo, created, retries, spent, &batchHist);
+    if (g_arguments->fpOfInsertResult) {
+        printCreateReport(g_arguments->fpOfInsertResult, stbInfo, created,
+                          retries, spent, &batchHist);
     }
+    benchHistDestroy(&batchHist);
 
     free(pids);
     free(infos);
@@ -505,6 +725,10 @@ static int createChildTables() {
                         stbInfo->childTblCount;
                 continue;
             }
+            // replay by tag creates its tables from the data
+            if (stbInfo->childTblCount == 0) {
+                continue;
+            }
             debugPrint(stdout, "colsOfCreateChildTable: %s\n",
                        stbInfo->colsOfCreateChildTable);
 
@@ -544,6 +768,7 @@ static int createChildTables() {
 }
 
 void postFreeResource() {
+    freeTagCache();
     tmfree(g_arguments->base64_buf);
     tmfclose(g_arguments->fpOfInsertResult);
     for (int i = 0; i < g_arguments->databases->size; i++) {
@@ -553,7 +778,11 @@ void postFreeResource() {
             SSuperTable * stbInfo = benchArrayGet(database->superTbls, j);
             tmfree(stbInfo->colsOfCreateChildTable);
             tmfree(stbInfo->sampleDataBuf);
+            tmfree(stbInfo->sampleRows);
+            tmfree(stbInfo->sampleCols);
             tmfree(stbInfo->tagDataBuf);
+            tmfree(stbInfo->tagRows);
+            benchArrayDestroy(stbInfo->replayFiles);
             tmfree(stbInfo->partialColumnNameBuf);
             for (int k = 0; k < stbInfo->tags->size; ++k) {
                 Field * tag = benchArrayGet(stbInfo->tags, k);
@@ -564,16 +793,14 @@ void postFreeResource() {
             for (int k = 0; k < stbInfo->cols->size; ++k) {
                 Field * col = benchArrayGet(stbInfo->cols, k);
                 tmfree(col->data);
-            }
-            benchArrayDestroy(stbInfo->cols);
-            if (g_arguments->test_mode == INSERT_TEST &&
-                    stbInfo->insertRows != 0) {
-                for (int64_t k = 0; k < stbInfo->childTblCount;
-                     ++k) {
-                    tmfree(stbInfo->childTblName[k]);
+                if (col->gen) {
+                    tmfree(col->gen->cdf);
+                    tmfree(col->gen);
                 }
             }
-            tmfree(stbInfo->childTblName);
+            benchArrayDestroy(stbInfo->cols);
+            freeNameStore(&stbInfo->childTblNames);
+            tmfree(stbInfo->tblVgroups);
         }
         benchArrayDestroy(database->superTbls);
     }
@@ -583,24 +810,109 @@ void postFreeResource() {
     tmfree(g_arguments->pool);
 }
 
-static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
+// append one record to the json batch streamed into pThreadInfo->buffer
+static void appendSmlJsonRow(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                             uint64_t tableSeq, uint32_t precision,
+                             int64_t timestamp) {
+    char *pstr = pThreadInfo->buffer + pThreadInfo->sml_len;
+    *pstr++ = pThreadInfo->sml_len ? ',' : '[';
+    pstr += generateSmlJsonCols(
+        pstr,
+        pThreadInfo->sml_json_tags[tableSeq - pThreadInfo->start_table_from],
+        stbInfo, precision, timestamp);
+    pThreadInfo->sml_len = pstr - pThreadInfo->buffer;
+}
+
+// append one line or telnet record to the batch in pThreadInfo->buffer, the
+// table's tags were rendered once and the field set comes from the prepared
+// rows. Records end with '\0' for taos_schemaless_insert and with '\n' for
+// rest, where the buffer is the request body as is
+static void appendSmlLine(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                          uint64_t tableSeq, int64_t pos, int64_t timestamp,
+                          int32_t index) {
+    SRowFragment *tags =
+        pThreadInfo->sml_tags + (tableSeq - pThreadInfo->start_table_from);
+    SRowFragment *row = stbInfo->sampleRows + pos;
+    char *        pstr = pThreadInfo->buffer + pThreadInfo->sml_len;
+    pThreadInfo->lines[index] = pstr;
+    if (stbInfo->lineProtocol == TSDB_SML_LINE_PROTOCOL) {
+        // "measurement,tagset " fields timestamp
+        memcpy(pstr, tags->data, tags->len);
+        pstr += tags->len;
+        memcpy(pstr, row->data, row->len);
+        pstr += row->len;
+        *pstr++ = ' ';
+        pstr += benchInt64ToStr(timestamp, pstr);
+    } else {
+        // [put ]metric timestamp value " tagset"
+        if (stbInfo->iface == SML_REST_IFACE && stbInfo->tcpTransfer) {
+            memcpy(pstr, "put ", 4);
+            pstr += 4;
+        }
+        size_t nameLen = strlen(stbInfo->stbName);
+        memcpy(pstr, stbInfo->stbName, nameLen);
+        pstr += nameLen;
+        *pstr++ = ' ';
+        pstr += benchInt64ToStr(timestamp, pstr);
+        *pstr++ = ' ';
+        memcpy(pstr, row->data, row->len);
+        pstr += row->len;
+        memcpy(pstr, tags->data, tags->len);
+        pstr += tags->len;
+    }
+    *pstr++ = stbInfo->iface == SML_REST_IFACE ? '\n' : '\0';
+    *pstr = '\0';
+    pThreadInfo->sml_len = pstr - pThreadInfo->buffer;
+}
+
+static void closeSmlJsonBatch(threadInfo *pThreadInfo) {
+    char *pstr = pThreadInfo->buffer + pThreadInfo->sml_len;
+    if (0 == pThreadInfo->sml_len) {
+        *pstr++ = '[';
+    }
+    *pstr++ = ']';
+    *pstr = '\0';
+    pThreadInfo->lines[0] = pThreadInfo->buffer;
+}
+
+// queryDbExec for one insert request, which also hands back its error code
+static int64_t execSqlInsert(TAOS *taos, char *sql, bool noCheck,
+                             int32_t *code) {
+    TAOS_RES *res = taos_query(taos, sql);
+    int64_t   affectedRows = 0;
+    *code = taos_errno(res);
+    if (*code != 0) {
+        errorPrint(stderr, "Failed to execute <%s>, reason: %s\n", sql,
+                   taos_errstr(res));
+        affectedRows = -1;
+    } else if (!noCheck) {
+        affectedRows = taos_affected_rows(res);
+    }
+    taos_free_result(res);
+    return affectedRows;
+}
+
+// code is left 0 on success, else the error of this very request
+static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k, int32_t *code) {
     SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
     SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
     int32_t      affectedRows = 0;
     TAOS_RES *   res = NULL;
-    int32_t      code;
     uint16_t     iface = stbInfo->iface;
 
+    *code = 0;
     switch (iface) {
         case TAOSC_IFACE:
 
-            affectedRows = queryDbExec(pThreadInfo->taos, pThreadInfo->buffer,
-                                       INSERT_TYPE, false, stbInfo->no_check_for_affected_rows);
+            affectedRows = (int32_t)execSqlInsert(
+                pThreadInfo->taos, pThreadInfo->buffer,
+                stbInfo->no_check_for_affected_rows, code);
             break;
 
         case REST_IFACE:
 
-            if (0 != postProceSql(pThreadInfo->buffer, pThreadInfo)) {
+            *code = postProceSql(pThreadInfo->buffer, pThreadInfo);
+            if (0 != *code) {
                 affectedRows = -1;
             } else {
                 affectedRows = k;
@@ -608,7 +920,8 @@ static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
             break;
 
         case STMT_IFACE:
-            if (taos_stmt_execute(pThreadInfo->stmt)) {
+            *code = taos_stmt_execute(pThreadInfo->stmt);
+            if (*code) {
                 errorPrint(stderr,
                            "failed to execute insert statement. reason: %s\n",
                            taos_stmt_errstr(pThreadInfo->stmt));
@@ -621,7 +934,7 @@ static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
             break;
         case SML_IFACE:
             if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                pThreadInfo->lines[0] = tools_cJSON_Print(pThreadInfo->json_array);
+                closeSmlJsonBatch(pThreadInfo);
             }
             res = taos_schemaless_insert(
                 pThreadInfo->taos, pThreadInfo->lines,
@@ -630,11 +943,11 @@ static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
                 stbInfo->lineProtocol == TSDB_SML_LINE_PROTOCOL
                     ? database->dbCfg.sml_precision
                     : TSDB_SML_TIMESTAMP_NOT_CONFIGURED);
-            code = taos_errno(res);
+            *code = taos_errno(res);
             if (!stbInfo->no_check_for_affected_rows) {
                 affectedRows = taos_affected_rows(res);
             }
-            if (code != TSDB_CODE_SUCCESS) {
+            if (*code != TSDB_CODE_SUCCESS) {
                 errorPrint(
                     stderr,
                     "failed to execute schemaless insert. content: %s, reason: "
@@ -645,29 +958,17 @@ static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
             break;
         case SML_REST_IFACE: {
             if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                pThreadInfo->lines[0] = tools_cJSON_Print(pThreadInfo->json_array);
-                if (0 != postProceSql(pThreadInfo->lines[0], pThreadInfo)) {
+                closeSmlJsonBatch(pThreadInfo);
+                *code = postProceSql(pThreadInfo->lines[0], pThreadInfo);
+                if (0 != *code) {
                     affectedRows = -1;
                 } else {
                     affectedRows = k;
                 }
             } else {
-                int len = 0;
-                for (int i = 0; i < k; ++i) {
-                    if (strlen(pThreadInfo->lines[i]) != 0) {
-                        if (stbInfo->lineProtocol == TSDB_SML_TELNET_PROTOCOL &&
-                            stbInfo->tcpTransfer) {
-                            len += sprintf(pThreadInfo->buffer + len,
-                                           "put %s\n", pThreadInfo->lines[i]);
-                        } else {
-                            len += sprintf(pThreadInfo->buffer + len, "%s\n",
-                                           pThreadInfo->lines[i]);
-                        }
-                    } else {
-                        break;
-                    }
-                }
-                if (0 != postProceSql(pThreadInfo->buffer, pThreadInfo)) {
+                // the line batch already is the request body
+                *code = postProceSql(pThreadInfo->buffer, pThreadInfo);
+                if (0 != *code) {
                     affectedRows = -1;
                 } else {
                     affectedRows = k;
@@ -679,8 +980,592 @@ static int32_t execInsert(threadInfo *pThreadInfo, uint32_t k) {
     return affectedRows;
 }
 
+// upper bound of one "db.tb [(cols)] [using stb tags (...)] values " header
+static uint32_t calcTableHeaderLen(SDataBase *database, SSuperTable *stbInfo) {
+    uint32_t len = (uint32_t)strlen(database->dbName) + TSDB_TABLE_NAME_LEN + 16;
+    if (stbInfo->partialColumnNum != stbInfo->cols->size) {
+        len += (uint32_t)strlen(stbInfo->partialColumnNameBuf) + 3;
+    }
+    if (stbInfo->autoCreateTable) {
+        len += (uint32_t)strlen(stbInfo->stbName) + stbInfo->lenOfTags + 20;
+    }
+    return len;
+}
+
+// upper bound of one "(ts,row)" value tuple
+static FORCE_INLINE uint32_t calcSqlRowLen(SSuperTable *stbInfo) {
+    return stbInfo->lenOfCols + TIMESTAMP_BUFF_LEN + 3;
+}
+
+static uint32_t formatTableHeader(SDataBase *database, SSuperTable *stbInfo,
+                                  uint64_t tableSeq, char *buf, uint32_t size) {
+    char  nameBuf[TSDB_TABLE_NAME_LEN];
+    char *tableName;
+    int   len;
+    getChildTblName(stbInfo, tableSeq, nameBuf, &tableName);
+    if (stbInfo->partialColumnNum == stbInfo->cols->size) {
+        if (stbInfo->autoCreateTable) {
+            len = snprintf(buf, size, "%s.%s using `%s` tags (%s) values ",
+                           database->dbName, tableName, stbInfo->stbName,
+                           getChildTblTags(stbInfo, tableSeq));
+        } else {
+            len = snprintf(buf, size, "%s.%s values ", database->dbName,
+                           tableName);
+        }
+    } else {
+        if (stbInfo->autoCreateTable) {
+            len = snprintf(buf, size,
+                           "%s.%s (%s) using `%s` tags (%s) values ",
+                           database->dbName, tableName,
+                           stbInfo->partialColumnNameBuf, stbInfo->stbName,
+                           getChildTblTags(stbInfo, tableSeq));
+        } else {
+            len = snprintf(buf, size, "%s.%s (%s) values ", database->dbName,
+                           tableName, stbInfo->partialColumnNameBuf);
+        }
+    }
+    if (len < 0) {
+        return 0;
+    }
+    return (uint32_t)len < size ? (uint32_t)len : size - 1;
+}
+
+// render the "db.tb values " header of every table owned by the thread once
+// into one arena, so the interlace loop only has to memcpy them. Not used
+// with auto create, whose tags are rendered per batch instead of kept
+static void prepareTableHeaders(threadInfo *pThreadInfo, SDataBase *database,
+                                SSuperTable *stbInfo) {
+    uint64_t ntables =
+        pThreadInfo->end_table_to - pThreadInfo->start_table_from + 1;
+    uint32_t maxLen = calcTableHeaderLen(database, stbInfo);
+    char *   tmp = benchCalloc(1, maxLen, false);
+    uint64_t total = 0;
+    pThreadInfo->tblHeaders = benchCalloc(ntables, sizeof(SRowFragment), false);
+    for (uint64_t i = 0; i < ntables; ++i) {
+        pThreadInfo->tblHeaders[i].len = formatTableHeader(
+            database, stbInfo, pThreadInfo->start_table_from + i, tmp, maxLen);
+        total += pThreadInfo->tblHeaders[i].len;
+    }
+    tmfree(tmp);
+    pThreadInfo->tblHeaderBuf = benchCalloc(1, total + 1, false);
+    char *pstr = pThreadInfo->tblHeaderBuf;
+    for (uint64_t i = 0; i < ntables; ++i) {
+        SRowFragment *header = pThreadInfo->tblHeaders + i;
+        header->data = pstr;
+        formatTableHeader(database, stbInfo, pThreadInfo->start_table_from + i,
+                          pstr, header->len + 1);
+        pstr += header->len;
+    }
+}
+
+static FORCE_INLINE uint32_t appendSqlRow(char *pstr, SSuperTable *stbInfo,
+                                          uint64_t tableSeq, int64_t pos,
+                                          int64_t timestamp) {
+    if (stbInfo->columnGen) {
+        return renderColumnGenRow(pstr, stbInfo, tableSeq, pos, timestamp);
+    }
+    SRowFragment *row = stbInfo->sampleRows + pos;
+    char *        p = pstr;
+    *p++ = '(';
+    if (!stbInfo->useSampleTs || stbInfo->random_data_source) {
+        p += benchInt64ToStr(timestamp, p);
+        if (row->len > 0) {
+            *p++ = ',';
+        }
+    }
+    memcpy(p, row->data, row->len);
+    p += row->len;
+    *p++ = ')';
+    return (uint32_t)(p - pstr);
+}
+
+// how far the next timestamp steps back, 0 unless the row is disordered
+static FORCE_INLINE int64_t disorderOffset(SSuperTable *stbInfo) {
+    if (stbInfo->disorderRatio > 0 &&
+        benchRandBelow(100) < (uint32_t)stbInfo->disorderRatio) {
+        return benchRandBelow(stbInfo->disorderRange);
+    }
+    return 0;
+}
+
+// in fixed-rate mode block until the intended send time of the next request,
+// which is where its corrected latency starts, then schedule the one after
+static int64_t waitForSendSlot(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                               int32_t generated) {
+    if (pThreadInfo->rate_step_us <= 0) {
+        return 0;
+    }
+    int64_t intendedTs = (int64_t)pThreadInfo->rate_next_us;
+    int32_t prev = benchPhaseSwitch(pThreadInfo, PHASE_THROTTLE);
+    toolsUsleepUntil(intendedTs);
+    benchPhaseSwitch(pThreadInfo, prev);
+    if (stbInfo->insert_rate_unit == RATE_UNIT_ROWS) {
+        pThreadInfo->rate_next_us += pThreadInfo->rate_step_us * generated;
+    } else {
+        pThreadInfo->rate_next_us += pThreadInfo->rate_step_us;
+    }
+    return intendedTs;
+}
+
+// payload size of one request for the stats sampler, stmt binds count as 0
+static uint64_t requestBytes(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                             const char *buffer, int32_t generated) {
+    switch (stbInfo->iface) {
+        case TAOSC_IFACE:
+        case REST_IFACE:
+            return strlen(buffer);
+        case SML_IFACE:
+        case SML_REST_IFACE:
+            return pThreadInfo->sml_len;
+        default:
+            return 0;
+    }
+}
+
+static void recordInsertDelay(threadInfo *pThreadInfo, int64_t startTs,
+                              int64_t endTs, int64_t intendedTs) {
+    uint64_t delay = endTs - startTs;
+    performancePrint(stdout, "insert execution time is %10.2f ms\n",
+                     delay / 1000.0);
+    if (delay > pThreadInfo->maxDelay) pThreadInfo->maxDelay = delay;
+    if (delay < pThreadInfo->minDelay) pThreadInfo->minDelay = delay;
+    benchHistRecord(&pThreadInfo->delayHist, delay);
+    pThreadInfo->cntDelay++;
+    pThreadInfo->totalDelay += delay;
+
+    if (intendedTs > 0) {
+        // includes the time the request waited behind a stalled server
+        benchHistRecord(&pThreadInfo->correctedDelayHist, endTs - intendedTs);
+    }
+}
+
+// one in-flight request and the sql buffer it owns until completion
+typedef struct SAsyncSlot_S {
+    char *               buffer;
+    TAOS *               taos;  // taos_query_a connection
+    struct SAsyncPool_S *pool;
+    int32_t              generated;
+    uint64_t             bytes;
+    int64_t              startTs;
+    int64_t              intendedTs;
+    struct SAsyncSlot_S *next;
+} SAsyncSlot;
+
+// per-thread pool of insert requests sent off the generating thread, either
+// by taos_query_a (async_inflight), by a sender thread (pipeline_buffers) or
+// by the epoll rest engine (rest_connections). The worker fills the current
+// slot while the others are in flight and completions return them to the
+// free list.
+typedef struct SAsyncPool_S {
+    threadInfo *    pThreadInfo;
+    SSuperTable *   stbInfo;
+#ifdef LINUX
+    SRestEngine *   engine;
+#endif
+    SAsyncSlot *    slots;
+    SAsyncSlot *    current;
+    SAsyncSlot *    freeSlots;
+    SAsyncSlot *    sendHead;
+    SAsyncSlot *    sendTail;
+    uint32_t        size;
+    uint32_t        inflight;
+    bool            failed;
+    bool            pipelined;
+    bool            closing;
+    pthread_t       sender;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    pthread_cond_t  sendCond;
+} SAsyncPool;
+
+// return a finished request's slot, affectedRows < 0 marks a failure
+static void completeAsyncSlot(SAsyncSlot *slot, int64_t affectedRows,
+                              int64_t endTs, int32_t code) {
+    SAsyncPool *pool = slot->pool;
+    threadInfo *pThreadInfo = pool->pThreadInfo;
+    benchStatsInflight(pThreadInfo->stats, -1);
+    benchStatsRecord(pThreadInfo->stats, slot->generated, slot->bytes,
+                     endTs - slot->startTs, affectedRows < 0);
+    benchMetricsRecord(pThreadInfo->metrics, slot->generated,
+                       affectedRows < 0 ? 0 : affectedRows,
+                       endTs - slot->startTs, affectedRows < 0 ? code : 0);
+    pthread_mutex_lock(&pool->mutex);
+    if (affectedRows < 0) {
+        pool->failed = true;
+    } else {
+        pThreadInfo->totalAffectedRows += affectedRows;
+        recordInsertDelay(pThreadInfo, slot->startTs, endTs, slot->intendedTs);
+    }
+    slot->next = pool->freeSlots;
+    pool->freeSlots = slot;
+    pool->inflight--;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void asyncInsertCallback(void *param, TAOS_RES *res, int code) {
+    SAsyncSlot *slot = (SAsyncSlot *)param;
+    int64_t     endTs = toolsGetTimestampUs();
+    int64_t     affectedRows = 0;
+
+    code = taos_errno(res);
+    if (code != 0) {
+        errorPrint(stderr, "failed to execute async insert, reason: %s\n",
+                   taos_errstr(res));
+        affectedRows = -1;
+    } else if (!slot->pool->stbInfo->no_check_for_affected_rows) {
+        affectedRows = taos_affected_rows(res);
+    }
+    taos_free_result(res);
+    completeAsyncSlot(slot, affectedRows, endTs, code);
+}
+
+#ifdef LINUX
+static void restInsertDone(void *param, int32_t code, int64_t startTs,
+                           int64_t endTs) {
+    SAsyncSlot *slot = (SAsyncSlot *)param;
+    slot->startTs = startTs;
+    completeAsyncSlot(slot, code == 0 ? slot->generated : -1, endTs,
+                      code ? code : -1);
+}
+#endif
+
+// sends the filled buffers in order while the worker generates the next one
+static void *pipelineSender(void *arg) {
+    SAsyncPool * pool = (SAsyncPool *)arg;
+    threadInfo * pThreadInfo = pool->pThreadInfo;
+    SSuperTable *stbInfo = pool->stbInfo;
+#ifdef LINUX
+    prctl(PR_SET_NAME, "pipelineSender");
+#endif
+    while (true) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->sendHead == NULL && !pool->closing) {
+            pthread_cond_wait(&pool->sendCond, &pool->mutex);
+        }
+        SAsyncSlot *slot = pool->sendHead;
+        if (slot == NULL) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        pool->sendHead = slot->next;
+        if (pool->sendHead == NULL) {
+            pool->sendTail = NULL;
+        }
+        bool failed = pool->failed;
+        pthread_mutex_unlock(&pool->mutex);
+
+        int64_t affectedRows = -1;
+        int32_t code = -1;
+        if (!failed) {
+            slot->startTs = toolsGetTimestampUs();
+            if (stbInfo->iface == REST_IFACE) {
+                code = postProceSql(slot->buffer, pThreadInfo);
+                if (0 == code) {
+                    affectedRows = slot->generated;
+                }
+            } else {
+                affectedRows = execSqlInsert(
+                    pThreadInfo->taos, slot->buffer,
+                    stbInfo->no_check_for_affected_rows, &code);
+            }
+        }
+        completeAsyncSlot(slot, affectedRows, toolsGetTimestampUs(),
+                          code ? code : -1);
+    }
+    return NULL;
+}
+
+static void initAsyncPool(threadInfo *pThreadInfo, SSuperTable *stbInfo) {
+    SAsyncPool *pool = benchCalloc(1, sizeof(SAsyncPool), false);
+    pool->pThreadInfo = pThreadInfo;
+    pool->stbInfo = stbInfo;
+    pool->pipelined =
+        stbInfo->async_inflight == 0 && stbInfo->rest_connections == 0;
+    if (stbInfo->rest_connections > 0) {
+        pool->size = stbInfo->rest_connections + 1;
+    } else {
+        pool->size = pool->pipelined ? stbInfo->pipeline_buffers
+                                     : stbInfo->async_inflight + 1;
+    }
+    pool->slots = benchCalloc(pool->size, sizeof(SAsyncSlot), false);
+    // slot 0 reuses the thread buffer, the rest are extra in-flight copies
+    pool->slots[0].buffer = pThreadInfo->buffer;
+    SDataBase *database =
+        benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
+    for (uint32_t i = 0; i < pool->size; i++) {
+        SAsyncSlot *slot = pool->slots + i;
+        slot->pool = pool;
+        slot->taos = pThreadInfo->taos;
+        // spread in-flight requests over the thread's own connections
+        if (stbInfo->async_inflight > 0 &&
+            g_arguments->connections_per_thread > 1 && i > 0) {
+            slot->taos = select_thread_conn(pThreadInfo->threadID, i,
+                                            database->dbName);
+            if (slot->taos == NULL) {
+                pool->failed = true;
+                slot->taos = pThreadInfo->taos;
+            }
+        }
+        if (i > 0) {
+            slot->buffer = benchCalloc(1, pThreadInfo->max_sql_len, false);
+            slot->next = pool->freeSlots;
+            pool->freeSlots = slot;
+        }
+    }
+    pool->current = pool->slots;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_cond_init(&pool->sendCond, NULL);
+    if (pool->pipelined) {
+        pthread_create(&pool->sender, NULL, pipelineSender, pool);
+    }
+#ifdef LINUX
+    if (stbInfo->rest_connections > 0) {
+        pool->engine = restEngineCreate(pThreadInfo, stbInfo->rest_connections,
+                                        restInsertDone);
+        if (pool->engine == NULL) {
+            pool->failed = true;
+        }
+    }
+#endif
+    pThreadInfo->asyncPool = pool;
+}
+
+// wait for every request still in flight, then give the thread its own
+// buffer back
+static void destroyAsyncPool(threadInfo *pThreadInfo) {
+    SAsyncPool *pool = pThreadInfo->asyncPool;
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->inflight > 0) {
+        pthread_cond_wait(&pool->cond, &pool->mutex);
+    }
+    pool->closing = true;
+    pthread_cond_signal(&pool->sendCond);
+    pthread_mutex_unlock(&pool->mutex);
+    if (pool->pipelined) {
+        pthread_join(pool->sender, NULL);
+    }
+#ifdef LINUX
+    if (pool->engine) {
+        restEngineDestroy(pool->engine);
+    }
+#endif
+    pThreadInfo->buffer = pool->slots[0].buffer;
+    for (uint32_t i = 1; i < pool->size; i++) {
+        tmfree(pool->slots[i].buffer);
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond);
+    pthread_cond_destroy(&pool->sendCond);
+    tmfree(pool->slots);
+    tmfree(pool);
+    pThreadInfo->asyncPool = NULL;
+}
+
+// hand the current buffer over for sending and switch to a free one,
+// blocking only when every buffer is already in flight
+static int64_t submitAsyncInsert(threadInfo *pThreadInfo, int32_t generated,
+                                 int64_t intendedTs) {
+    SAsyncPool *pool = pThreadInfo->asyncPool;
+    SAsyncSlot *slot = pool->current;
+
+    debugPrint(stdout, "pThreadInfo->buffer: %s\n", slot->buffer);
+    slot->generated = generated;
+    slot->intendedTs = intendedTs;
+    if (pThreadInfo->stats) {
+        slot->bytes = requestBytes(pThreadInfo, pool->stbInfo, slot->buffer,
+                                   generated);
+    }
+    slot->next = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->failed) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    // counted only once the request is bound to be sent, and before the
+    // sender or a callback can take it off again
+    benchStatsInflight(pThreadInfo->stats, 1);
+    pool->inflight++;
+    if (pool->pipelined) {
+        if (pool->sendTail) {
+            pool->sendTail->next = slot;
+        } else {
+            pool->sendHead = slot;
+        }
+        pool->sendTail = slot;
+        pthread_cond_signal(&pool->sendCond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+#ifdef LINUX
+    if (pool->engine) {
+        restEngineSubmit(pool->engine, slot->buffer, slot);
+    } else
+#endif
+    if (!pool->pipelined) {
+        slot->startTs = toolsGetTimestampUs();
+        taos_query_a(slot->taos, slot->buffer, asyncInsertCallback, slot);
+    }
+
+    int32_t prev = benchPhaseSwitch(pThreadInfo, PHASE_THROTTLE);
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->freeSlots == NULL && !pool->failed) {
+        pthread_cond_wait(&pool->cond, &pool->mutex);
+    }
+    benchPhaseSwitch(pThreadInfo, prev);
+    if (pool->failed) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    slot = pool->freeSlots;
+    pool->freeSlots = slot->next;
+    pthread_mutex_unlock(&pool->mutex);
+
+    pool->current = slot;
+    pThreadInfo->buffer = slot->buffer;
+    return 0;
+}
+
+static int64_t sendBatch(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                         int32_t generated) {
+    int64_t intendedTs = waitForSendSlot(pThreadInfo, stbInfo, generated);
+    if (pThreadInfo->asyncPool) {
+        return submitAsyncInsert(pThreadInfo, generated, intendedTs);
+    }
+    uint64_t bytes = 0;
+    if (pThreadInfo->stats) {
+        bytes = requestBytes(pThreadInfo, stbInfo, pThreadInfo->buffer,
+                             generated);
+        benchStatsInflight(pThreadInfo->stats, 1);
+    }
+    // only measure insert
+    int32_t prev = benchPhaseSwitch(pThreadInfo, PHASE_WAIT);
+    int64_t startTs = toolsGetTimestampUs();
+    int32_t code = 0;
+    int64_t affectedRows = execInsert(pThreadInfo, generated, &code);
+    int64_t endTs = toolsGetTimestampUs();
+    benchPhaseSwitch(pThreadInfo, prev);
+    benchStatsInflight(pThreadInfo->stats, -1);
+    benchStatsRecord(pThreadInfo->stats, generated, bytes, endTs - startTs,
+                     affectedRows < 0);
+    benchMetricsRecord(pThreadInfo->metrics, generated,
+                       affectedRows < 0 ? 0 : affectedRows, endTs - startTs,
+                       affectedRows < 0 ? (code ? code : -1) : 0);
+    // every builder rewrites and terminates what it sends, so the buffers
+    // are reused without clearing them
+    switch (stbInfo->iface) {
+        case TAOSC_IFACE:
+        case REST_IFACE:
+            debugPrint(stdout, "pThreadInfo->buffer: %s\n",
+                       pThreadInfo->buffer);
+            break;
+        case SML_REST_IFACE:
+        case SML_IFACE:
+            if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL ||
+                stbInfo->iface == SML_REST_IFACE) {
+                debugPrint(stdout, "pThreadInfo->buffer: %s\n",
+                           pThreadInfo->buffer);
+            } else {
+                for (int j = 0; j < generated; ++j) {
+                    debugPrint(stdout, "pThreadInfo->lines[%d]: %s\n", j,
+                               pThreadInfo->lines[j]);
+                }
+            }
+            pThreadInfo->sml_len = 0;
+            break;
+        default:
+            break;
+    }
+    if (affectedRows < 0) {
+        return -1;
+    }
+    if (stbInfo->iface == STMT_IFACE) {
+        pThreadInfo->totalAffectedRows = affectedRows;
+    } else {
+        pThreadInfo->totalAffectedRows += affectedRows;
+    }
+    recordInsertDelay(pThreadInfo, startTs, endTs, intendedTs);
+    return affectedRows;
+}
+
+// time spent building the batch is everything since the previous send
+// returned, the send itself may overlap it when pipelined
+static int64_t insertBatch(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                           int32_t generated) {
+    pThreadInfo->totalGenDelay +=
+        toolsGetTimestampUs() - pThreadInfo->batchStartTs;
+    int64_t affectedRows = sendBatch(pThreadInfo, stbInfo, generated);
+    pThreadInfo->batchStartTs = toolsGetTimestampUs();
+    return affectedRows;
+}
+
+// ntables is what the name store holds, which child_table_exists with a
+// limit or offset makes differ from childtable_count
+void initTableScheduler(STableScheduler *scheduler,
+                               SSuperTable *stbInfo, uint64_t ntables) {
+    scheduler->next = 0;
+    scheduler->tables = ntables;
+    scheduler->chunkSize = stbInfo->steal_chunk;
+    scheduler->chunks =
+        (scheduler->tables + scheduler->chunkSize - 1) / scheduler->chunkSize;
+    if (stbInfo->interlaceRows == 0) {
+        scheduler->units = scheduler->chunks;
+    } else if (stbInfo->non_stop) {
+        scheduler->units = 0;
+    } else {
+        uint64_t rounds = (stbInfo->insertRows + stbInfo->interlaceRows - 1) /
+                          stbInfo->interlaceRows;
+        scheduler->units = scheduler->chunks * rounds;
+    }
+    pthread_mutex_init(&scheduler->mutex, NULL);
+}
+
+// point the thread's table range at the next unit, returns false and leaves
+// an empty range once everything has been handed out
+bool takeTableUnit(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                   int32_t *interlaceRows) {
+    STableScheduler *scheduler = pThreadInfo->scheduler;
+    pthread_mutex_lock(&scheduler->mutex);
+    if (g_arguments->terminate ||
+        (scheduler->units && scheduler->next >= scheduler->units)) {
+        pthread_mutex_unlock(&scheduler->mutex);
+        pThreadInfo->start_table_from = 1;
+        pThreadInfo->end_table_to = 0;
+        return false;
+    }
+    uint64_t unit = scheduler->next++;
+    pthread_mutex_unlock(&scheduler->mutex);
+
+    uint64_t chunk = unit % scheduler->chunks;
+    uint64_t round = unit / scheduler->chunks;
+    pThreadInfo->start_table_from = chunk * scheduler->chunkSize;
+    pThreadInfo->end_table_to = pThreadInfo->start_table_from +
+                                scheduler->chunkSize - 1;
+    if (pThreadInfo->end_table_to >= scheduler->tables) {
+        pThreadInfo->end_table_to = scheduler->tables - 1;
+    }
+    pThreadInfo->unitsTaken++;
+    if (stbInfo->interlaceRows > 0) {
+        uint64_t done = round * stbInfo->interlaceRows;
+        pThreadInfo->start_time =
+            stbInfo->startTimestamp + done * stbInfo->timestamp_step;
+        *interlaceRows = stbInfo->interlaceRows;
+        if (!stbInfo->non_stop && stbInfo->insertRows - done < *interlaceRows) {
+            *interlaceRows = (int32_t)(stbInfo->insertRows - done);
+        }
+    }
+    return true;
+}
+
 static void *syncWriteInterlace(void *sarg) {
     threadInfo * pThreadInfo = (threadInfo *)sarg;
+    benchRandSeed(pThreadInfo->threadID + 1);
+    benchMetricsThread(1);
     SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
     SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
     infoPrint(stdout,
@@ -696,12 +1581,25 @@ static void *syncWriteInterlace(void *sarg) {
     uint32_t batchPerTblTimes = g_arguments->reqPerReq / interlaceRows;
 
     uint64_t   lastPrintTime = toolsGetTimestampMs();
-    uint64_t   startTs = toolsGetTimestampMs();
-    uint64_t   endTs = toolsGetTimestampMs();
-    delayNode *current_delay_node;
     int32_t    generated = 0;
     int        len = 0;
+    pThreadInfo->st = toolsGetTimestampUs();
+    pThreadInfo->batchStartTs = pThreadInfo->st;
+    pThreadInfo->rate_next_us = (double)pThreadInfo->st;
+    benchPhaseStart(pThreadInfo);
+    if (pThreadInfo->scheduler) {
+        if (!takeTableUnit(pThreadInfo, stbInfo, &interlaceRows)) {
+            insertRows = 0;
+        }
+    } else if ((stbInfo->iface == TAOSC_IFACE || stbInfo->iface == REST_IFACE) &&
+               !stbInfo->autoCreateTable) {
+        prepareTableHeaders(pThreadInfo, database, stbInfo);
+    }
     uint64_t   tableSeq = pThreadInfo->start_table_from;
+    if (stbInfo->async_inflight > 0 || stbInfo->pipeline_buffers > 1 ||
+        stbInfo->rest_connections > 0) {
+        initAsyncPool(pThreadInfo, stbInfo);
+    }
     while (insertRows > 0) {
         generated = 0;
         if (insertRows <= interlaceRows) {
@@ -712,69 +1610,44 @@ static void *syncWriteInterlace(void *sarg) {
                 goto free_of_interlace;
             }
             int64_t timestamp = pThreadInfo->start_time;
-            char *  tableName = stbInfo->childTblName[tableSeq];
+            char    nameBuf[TSDB_TABLE_NAME_LEN];
+            char *  tableName;
+            getChildTblName(stbInfo, tableSeq, nameBuf, &tableName);
             switch (stbInfo->iface) {
                 case REST_IFACE:
                 case TAOSC_IFACE: {
                     if (i == 0) {
-                        len = snprintf(pThreadInfo->buffer,
-                                       strlen(STR_INSERT_INTO) + 1, "%s",
-                                       STR_INSERT_INTO);
+                        len = strlen(STR_INSERT_INTO);
+                        memcpy(pThreadInfo->buffer, STR_INSERT_INTO, len);
                     }
-                    if (stbInfo->partialColumnNum == stbInfo->cols->size) {
-                        if (stbInfo->autoCreateTable) {
-                            len += snprintf(
-                                pThreadInfo->buffer + len,
-                                pThreadInfo->max_sql_len - len,
-                                "%s.%s using `%s` tags (%s) values ",
-                                database->dbName, tableName, stbInfo->stbName,
-                                stbInfo->tagDataBuf +
-                                    stbInfo->lenOfTags * tableSeq);
-                        } else {
-                            len += snprintf(pThreadInfo->buffer + len,
-                                            pThreadInfo->max_sql_len - len,
-                                            "%s.%s values", database->dbName,
-                                            tableName);
-                        }
+                    if (pThreadInfo->tblHeaders) {
+                        SRowFragment *header =
+                            pThreadInfo->tblHeaders +
+                            (tableSeq - pThreadInfo->start_table_from);
+                        memcpy(pThreadInfo->buffer + len, header->data,
+                               header->len);
+                        len += header->len;
                     } else {
-                        if (stbInfo->autoCreateTable) {
-                            len += snprintf(
-                                pThreadInfo->buffer + len,
-                                pThreadInfo->max_sql_len - len,
-                                "%s.%s (%s) using `%s` tags (%s) values ",
-                                database->dbName, tableName,
-                                stbInfo->partialColumnNameBuf, stbInfo->stbName,
-                                stbInfo->tagDataBuf +
-                                    stbInfo->lenOfTags * tableSeq);
-                        } else {
-                            len += snprintf(pThreadInfo->buffer + len,
-                                            pThreadInfo->max_sql_len - len,
-                                            "%s.%s (%s) values",
-                                            database->dbName, tableName,
-                                            stbInfo->partialColumnNameBuf);
-                        }
+                        // auto create tags are rendered per batch, nothing
+                        // is kept per table
+                        len += formatTableHeader(
+                            database, stbInfo, tableSeq,
+                            pThreadInfo->buffer + len,
+                            (uint32_t)(pThreadInfo->max_sql_len - len));
                     }
 
                     for (int64_t j = 0; j < interlaceRows; ++j) {
-                        len += snprintf(
-                            pThreadInfo->buffer + len,
-                            pThreadInfo->max_sql_len - len, "(%" PRId64 ",%s)",
-                            timestamp,
-                            stbInfo->sampleDataBuf + pos * stbInfo->lenOfCols);
+                        len += appendSqlRow(pThreadInfo->buffer + len, stbInfo,
+                                            tableSeq, pos, timestamp);
                         generated++;
                         pos++;
                         if (pos >= g_arguments->prepared_rand) {
                             pos = 0;
                         }
                         timestamp += stbInfo->timestamp_step;
-                        if (stbInfo->disorderRatio > 0) {
-                            int rand_num = taosRandom() % 100;
-                            if (rand_num < stbInfo->disorderRatio) {
-                                timestamp -=
-                                    (taosRandom() % stbInfo->disorderRange);
-                            }
-                        }
+                        timestamp -= disorderOffset(stbInfo);
                     }
+                    pThreadInfo->buffer[len] = '\0';
                     break;
                 }
                 case STMT_IFACE: {
@@ -792,50 +1665,24 @@ static void *syncWriteInterlace(void *sarg) {
                 }
                 case SML_REST_IFACE:
                 case SML_IFACE: {
+                    if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
+                        benchPhaseSwitch(pThreadInfo, PHASE_JSON);
+                    }
                     for (int64_t j = 0; j < interlaceRows; ++j) {
                         if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                            tools_cJSON *tag = tools_cJSON_Duplicate(
-                                tools_cJSON_GetArrayItem(
-                                    pThreadInfo->sml_json_tags,
-                                    (int)tableSeq -
-                                        pThreadInfo->start_table_from),
-                                true);
-                            generateSmlJsonCols(
-                                pThreadInfo->json_array, tag, stbInfo,
-                                database->dbCfg.sml_precision, timestamp);
-                        } else if (stbInfo->lineProtocol ==
-                                   TSDB_SML_LINE_PROTOCOL) {
-                            snprintf(
-                                pThreadInfo->lines[generated],
-                                stbInfo->lenOfCols + stbInfo->lenOfTags,
-                                "%s %s %" PRId64 "",
-                                pThreadInfo
-                                    ->sml_tags[(int)tableSeq -
-                                               pThreadInfo->start_table_from],
-                                stbInfo->sampleDataBuf +
-                                    pos * stbInfo->lenOfCols,
-                                timestamp);
+                            appendSmlJsonRow(pThreadInfo, stbInfo, tableSeq,
+                                             database->dbCfg.sml_precision,
+                                             timestamp);
                         } else {
-                            snprintf(
-                                pThreadInfo->lines[generated],
-                                stbInfo->lenOfCols + stbInfo->lenOfTags,
-                                "%s %" PRId64 " %s %s", stbInfo->stbName,
-                                timestamp,
-                                stbInfo->sampleDataBuf +
-                                    pos * stbInfo->lenOfCols,
-                                pThreadInfo
-                                    ->sml_tags[(int)tableSeq -
-                                               pThreadInfo->start_table_from]);
+                            appendSmlLine(pThreadInfo, stbInfo, tableSeq, pos,
+                                          timestamp, generated);
                         }
                         generated++;
                         timestamp += stbInfo->timestamp_step;
-                        if (stbInfo->disorderRatio > 0) {
-                            int rand_num = taosRandom() % 100;
-                            if (rand_num < stbInfo->disorderRatio) {
-                                timestamp -=
-                                    (taosRandom() % stbInfo->disorderRange);
-                            }
-                        }
+                        timestamp -= disorderOffset(stbInfo);
+                    }
+                    if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
+                        benchPhaseSwitch(pThreadInfo, PHASE_BUILD);
                     }
                     break;
                 }
@@ -843,11 +1690,18 @@ static void *syncWriteInterlace(void *sarg) {
             tableSeq++;
             pThreadInfo->totalInsertRows += interlaceRows;
             if (tableSeq > pThreadInfo->end_table_to) {
-                tableSeq = pThreadInfo->start_table_from;
-                pThreadInfo->start_time +=
-                    interlaceRows * stbInfo->timestamp_step;
-                if (!stbInfo->non_stop) {
-                    insertRows -= interlaceRows;
+                if (pThreadInfo->scheduler) {
+                    if (!takeTableUnit(pThreadInfo, stbInfo, &interlaceRows)) {
+                        insertRows = 0;
+                    }
+                    tableSeq = pThreadInfo->start_table_from;
+                } else {
+                    tableSeq = pThreadInfo->start_table_from;
+                    pThreadInfo->start_time +=
+                        interlaceRows * stbInfo->timestamp_step;
+                    if (!stbInfo->non_stop) {
+                        insertRows -= interlaceRows;
+                    }
                 }
                 if (stbInfo->insert_interval > 0) {
                     performancePrint(stdout, "sleep %" PRIu64 " ms\n",
@@ -858,66 +1712,10 @@ static void *syncWriteInterlace(void *sarg) {
             }
         }
 
-        startTs = toolsGetTimestampUs();
-
-        int64_t affectedRows = execInsert(pThreadInfo, generated);
-
-        endTs = toolsGetTimestampUs();
-        switch (stbInfo->iface) {
-            case TAOSC_IFACE:
-            case REST_IFACE:
-                debugPrint(stdout, "pThreadInfo->buffer: %s\n",
-                           pThreadInfo->buffer);
-                memset(pThreadInfo->buffer, 0, pThreadInfo->max_sql_len);
-                pThreadInfo->totalAffectedRows += affectedRows;
-                break;
-            case SML_REST_IFACE:
-                memset(pThreadInfo->buffer, 0,
-                       g_arguments->reqPerReq * (pThreadInfo->max_sql_len + 1));
-            case SML_IFACE:
-                if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                    debugPrint(stdout, "pThreadInfo->lines[0]: %s\n",
-                               pThreadInfo->lines[0]);
-                    tools_cJSON_Delete(pThreadInfo->json_array);
-                    pThreadInfo->json_array = tools_cJSON_CreateArray();
-                    tmfree(pThreadInfo->lines[0]);
-                } else {
-                    for (int j = 0; j < generated; ++j) {
-                        debugPrint(stdout, "pThreadInfo->lines[%d]: %s\n", j,
-                                   pThreadInfo->lines[j]);
-                        memset(pThreadInfo->lines[j], 0,
-                               pThreadInfo->max_sql_len);
-                    }
-                }
-                pThreadInfo->totalAffectedRows += affectedRows;
-                break;
-            case STMT_IFACE:
-                pThreadInfo->totalAffectedRows = affectedRows;
-                break;
-        }
-        if (affectedRows < 0) {
+        if (insertBatch(pThreadInfo, stbInfo, generated) < 0) {
             g_fail = true;
             goto free_of_interlace;
         }
-        uint64_t delay = endTs - startTs;
-        performancePrint(stdout, "insert execution time is %10.2f ms\n",
-                         delay / 1000.0);
-
-        if (delay > pThreadInfo->maxDelay) pThreadInfo->maxDelay = delay;
-        if (delay < pThreadInfo->minDelay) pThreadInfo->minDelay = delay;
-        current_delay_node = benchCalloc(1, sizeof(delayNode), false);
-        current_delay_node->value = delay;
-        if (pThreadInfo->delayList.size == 0) {
-            pThreadInfo->delayList.head = current_delay_node;
-            pThreadInfo->delayList.tail = current_delay_node;
-            pThreadInfo->delayList.size++;
-        } else {
-            pThreadInfo->delayList.tail->next = current_delay_node;
-            pThreadInfo->delayList.tail = current_delay_node;
-            pThreadInfo->delayList.size++;
-        }
-        pThreadInfo->cntDelay++;
-        pThreadInfo->totalDelay += delay;
 
         int64_t currentPrintTime = toolsGetTimestampMs();
         if (currentPrintTime - lastPrintTime > 30 * 1000) {
@@ -937,6 +1735,14 @@ static void *syncWriteInterlace(void *sarg) {
         }
     }
 free_of_interlace:
+    // draining the requests still in flight is server time
+    benchPhaseSwitch(pThreadInfo, PHASE_WAIT);
+    destroyAsyncPool(pThreadInfo);
+    benchPhaseStop(pThreadInfo);
+    pThreadInfo->et = toolsGetTimestampUs();
+    tmfree(pThreadInfo->tblHeaders);
+    tmfree(pThreadInfo->tblHeaderBuf);
+    freeTagCache();
     if (0 == pThreadInfo->totalDelay) pThreadInfo->totalDelay = 1;
     if (stbInfo->no_check_for_affected_rows) {
         infoPrint(stdout,
@@ -954,11 +1760,23 @@ free_of_interlace:
                   (double)(pThreadInfo->totalAffectedRows /
                            ((double)pThreadInfo->totalDelay / 1000000.0)));
     }
+    benchMetricsThread(-1);
     return NULL;
 }
 
+static uint64_t nextProgressiveTable(threadInfo *pThreadInfo,
+                                     SSuperTable *stbInfo, uint64_t tableSeq) {
+    if (tableSeq < pThreadInfo->end_table_to || !pThreadInfo->scheduler) {
+        return tableSeq + 1;
+    }
+    takeTableUnit(pThreadInfo, stbInfo, NULL);
+    return pThreadInfo->start_table_from;
+}
+
 void *syncWriteProgressive(void *sarg) {
     threadInfo * pThreadInfo = (threadInfo *)sarg;
+    benchRandSeed(pThreadInfo->threadID + 1);
+    benchMetricsThread(1);
     SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
     SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
     infoPrint(stdout,
@@ -967,17 +1785,41 @@ void *syncWriteProgressive(void *sarg) {
               pThreadInfo->threadID, pThreadInfo->start_table_from,
               pThreadInfo->end_table_to);
     uint64_t   lastPrintTime = toolsGetTimestampMs();
-    uint64_t   startTs = toolsGetTimestampMs();
-    uint64_t   endTs;
-    delayNode *current_delay_node;
-
-    char *  pstr = pThreadInfo->buffer;
-    int32_t pos = 0;
+    pThreadInfo->st = toolsGetTimestampUs();
+    pThreadInfo->batchStartTs = pThreadInfo->st;
+    pThreadInfo->rate_next_us = (double)pThreadInfo->st;
+    benchPhaseStart(pThreadInfo);
+
+    char *       pstr = pThreadInfo->buffer;
+    int32_t      pos = 0;
+    SRowFragment header = {0};
+    uint32_t     headerLen = 0;
+    uint32_t     maxRowLen = calcSqlRowLen(stbInfo);
+    if (stbInfo->iface == TAOSC_IFACE || stbInfo->iface == REST_IFACE) {
+        headerLen = calcTableHeaderLen(database, stbInfo);
+        pThreadInfo->tblHeaderBuf = benchCalloc(1, headerLen, false);
+        header.data = pThreadInfo->tblHeaderBuf;
+    }
+    if (stbInfo->async_inflight > 0 || stbInfo->pipeline_buffers > 1 ||
+        stbInfo->rest_connections > 0) {
+        initAsyncPool(pThreadInfo, stbInfo);
+    }
+    if (pThreadInfo->scheduler) {
+        takeTableUnit(pThreadInfo, stbInfo, NULL);
+    }
     for (uint64_t tableSeq = pThreadInfo->start_table_from;
-         tableSeq <= pThreadInfo->end_table_to; tableSeq++) {
-        char *   tableName = stbInfo->childTblName[tableSeq];
+         tableSeq <= pThreadInfo->end_table_to;
+         tableSeq = nextProgressiveTable(pThreadInfo, stbInfo, tableSeq)) {
+        char     nameBuf[TSDB_TABLE_NAME_LEN];
+        char *   tableName;
+        getChildTblName(stbInfo, tableSeq, nameBuf, &tableName);
         int64_t  timestamp = pThreadInfo->start_time;
         uint64_t len = 0;
+        // once per table, the tags only when the table is auto created
+        if (header.data) {
+            header.len = formatTableHeader(database, stbInfo, tableSeq,
+                                           header.data, headerLen);
+        }
         if (stbInfo->iface == STMT_IFACE && stbInfo->autoCreateTable) {
             taos_stmt_close(pThreadInfo->stmt);
             pThreadInfo->stmt = taos_stmt_init(pThreadInfo->taos);
@@ -995,73 +1837,30 @@ void *syncWriteProgressive(void *sarg) {
             switch (stbInfo->iface) {
                 case TAOSC_IFACE:
                 case REST_IFACE: {
-                    if (stbInfo->partialColumnNum == stbInfo->cols->size) {
-                        if (stbInfo->autoCreateTable) {
-                            len =
-                                snprintf(pstr, MAX_SQL_LEN,
-                                         "%s %s.%s using %s tags (%s) values ",
-                                         STR_INSERT_INTO, database->dbName,
-                                         tableName, stbInfo->stbName,
-                                         stbInfo->tagDataBuf +
-                                             stbInfo->lenOfTags * tableSeq);
-                        } else {
-                            len = snprintf(pstr, MAX_SQL_LEN,
-                                           "%s %s.%s values ", STR_INSERT_INTO,
-                                           database->dbName, tableName);
-                        }
-                    } else {
-                        if (stbInfo->autoCreateTable) {
-                            len = snprintf(
-                                pstr, MAX_SQL_LEN,
-                                "%s %s.%s (%s) using %s tags (%s) values ",
-                                STR_INSERT_INTO, database->dbName, tableName,
-                                stbInfo->partialColumnNameBuf, stbInfo->stbName,
-                                stbInfo->tagDataBuf +
-                                    stbInfo->lenOfTags * tableSeq);
-                        } else {
-                            len = snprintf(pstr, MAX_SQL_LEN,
-                                           "%s %s.%s (%s) values ",
-                                           STR_INSERT_INTO, database->dbName,
-                                           tableName,
-                                           stbInfo->partialColumnNameBuf);
-                        }
-                    }
+                    pstr = pThreadInfo->buffer;
+                    len = strlen(STR_INSERT_INTO);
+                    memcpy(pstr, STR_INSERT_INTO, len);
+                    memcpy(pstr + len, header.data, header.len);
+                    len += header.len;
 
                     for (int j = 0; j < g_arguments->reqPerReq; ++j) {
-                        if (stbInfo && stbInfo->useSampleTs &&
-                            !stbInfo->random_data_source) {
-                            len +=
-                                snprintf(pstr + len,
-                                         MAX_SQL_LEN - len, "(%s)",
-                                         stbInfo->sampleDataBuf +
-                                             pos * stbInfo->lenOfCols);
-                        } else {
-                            len += snprintf(pstr + len,
-                                            MAX_SQL_LEN - len,
-                                            "(%" PRId64 ",%s)", timestamp,
-                                            stbInfo->sampleDataBuf +
-                                                pos * stbInfo->lenOfCols);
-                        }
+                        len += appendSqlRow(pstr + len, stbInfo, tableSeq,
+                                            pos, timestamp);
                         pos++;
                         if (pos >= g_arguments->prepared_rand) {
                             pos = 0;
                         }
                         timestamp += stbInfo->timestamp_step;
-                        if (stbInfo->disorderRatio > 0) {
-                            int rand_num = taosRandom() % 100;
-                            if (rand_num < stbInfo->disorderRatio) {
-                                timestamp -=
-                                    (taosRandom() % stbInfo->disorderRange);
-                            }
-                        }
+                        timestamp -= disorderOffset(stbInfo);
                         generated++;
-                        if (len > (MAX_SQL_LEN - stbInfo->lenOfCols)) {
+                        if (len + maxRowLen >= pThreadInfo->max_sql_len) {
                             break;
                         }
                         if (i + generated >= stbInfo->insertRows) {
                             break;
                         }
                     }
+                    pstr[len] = '\0';
                     break;
                 }
                 case STMT_IFACE: {
@@ -1084,58 +1883,32 @@ void *syncWriteProgressive(void *sarg) {
                 }
                 case SML_REST_IFACE:
                 case SML_IFACE: {
+                    if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
+                        benchPhaseSwitch(pThreadInfo, PHASE_JSON);
+                    }
                     for (int j = 0; j < g_arguments->reqPerReq; ++j) {
                         if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                            tools_cJSON *tag = tools_cJSON_Duplicate(
-                                tools_cJSON_GetArrayItem(
-                                    pThreadInfo->sml_json_tags,
-                                    (int)tableSeq -
-                                        pThreadInfo->start_table_from),
-                                true);
-                            generateSmlJsonCols(
-                                pThreadInfo->json_array, tag, stbInfo,
-                                database->dbCfg.sml_precision, timestamp);
-                        } else if (stbInfo->lineProtocol ==
-                                   TSDB_SML_LINE_PROTOCOL) {
-                            snprintf(
-                                pThreadInfo->lines[j],
-                                stbInfo->lenOfCols + stbInfo->lenOfTags,
-                                "%s %s %" PRId64 "",
-                                pThreadInfo
-                                    ->sml_tags[(int)tableSeq -
-                                               pThreadInfo->start_table_from],
-                                stbInfo->sampleDataBuf +
-                                    pos * stbInfo->lenOfCols,
-                                timestamp);
+                            appendSmlJsonRow(pThreadInfo, stbInfo, tableSeq,
+                                             database->dbCfg.sml_precision,
+                                             timestamp);
                         } else {
-                            snprintf(
-                                pThreadInfo->lines[j],
-                                stbInfo->lenOfCols + stbInfo->lenOfTags,
-                                "%s %" PRId64 " %s %s", stbInfo->stbName,
-                                timestamp,
-                                stbInfo->sampleDataBuf +
-                                    pos * stbInfo->lenOfCols,
-                                pThreadInfo
-                                    ->sml_tags[(int)tableSeq -
-                                               pThreadInfo->start_table_from]);
+                            appendSmlLine(pThreadInfo, stbInfo, tableSeq, pos,
+                                          timestamp, j);
                         }
                         pos++;
                         if (pos >= g_arguments->prepared_rand) {
                             pos = 0;
                         }
                         timestamp += stbInfo->timestamp_step;
-                        if (stbInfo->disorderRatio > 0) {
-                            int rand_num = taosRandom() % 100;
-                            if (rand_num < stbInfo->disorderRatio) {
-                                timestamp -=
-                                    (taosRandom() % stbInfo->disorderRange);
-                            }
-                        }
+                        timestamp -= disorderOffset(stbInfo);
                         generated++;
                         if (i + generated >= stbInfo->insertRows) {
                             break;
                         }
                     }
+                    if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
+                        benchPhaseSwitch(pThreadInfo, PHASE_BUILD);
+                    }
                     break;
                 }
                 default:
@@ -1145,63 +1918,10 @@ void *syncWriteProgressive(void *sarg) {
                 i += generated;
             }
             pThreadInfo->totalInsertRows += generated;
-            // only measure insert
-            startTs = toolsGetTimestampUs();
-            int32_t affectedRows = execInsert(pThreadInfo, generated);
-            endTs = toolsGetTimestampUs();
-            if (affectedRows < 0) {
+            if (insertBatch(pThreadInfo, stbInfo, generated) < 0) {
                 g_fail = true;
                 goto free_of_progressive;
             }
-            switch (stbInfo->iface) {
-                case REST_IFACE:
-                case TAOSC_IFACE:
-                    memset(pThreadInfo->buffer, 0, pThreadInfo->max_sql_len);
-                    pThreadInfo->totalAffectedRows += affectedRows;
-                    break;
-                case SML_REST_IFACE:
-                    memset(pThreadInfo->buffer, 0,
-                           g_arguments->reqPerReq *
-                               (pThreadInfo->max_sql_len + 1));
-                case SML_IFACE:
-                    if (stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
-                        tools_cJSON_Delete(pThreadInfo->json_array);
-                        pThreadInfo->json_array = tools_cJSON_CreateArray();
-                        tmfree(pThreadInfo->lines[0]);
-                    } else {
-                        for (int j = 0; j < generated; ++j) {
-                            debugPrint(stdout, "pThreadInfo->lines[%d]: %s\n",
-                                       j, pThreadInfo->lines[j]);
-                            memset(pThreadInfo->lines[j], 0,
-                                   pThreadInfo->max_sql_len);
-                        }
-                    }
-                    pThreadInfo->totalAffectedRows += affectedRows;
-                    break;
-                case STMT_IFACE:
-                    pThreadInfo->totalAffectedRows = affectedRows;
-                    break;
-            }
-
-            uint64_t delay = endTs - startTs;
-            performancePrint(stdout, "insert execution time is %10.f ms\n",
-                             delay / 1000.0);
-
-            if (delay > pThreadInfo->maxDelay) pThreadInfo->maxDelay = delay;
-            if (delay < pThreadInfo->minDelay) pThreadInfo->minDelay = delay;
-            pThreadInfo->cntDelay++;
-            current_delay_node = benchCalloc(1, sizeof(delayNode), false);
-            current_delay_node->value = delay;
-            if (pThreadInfo->delayList.size == 0) {
-                pThreadInfo->delayList.head = current_delay_node;
-                pThreadInfo->delayList.tail = current_delay_node;
-                pThreadInfo->delayList.size++;
-            } else {
-                pThreadInfo->delayList.tail->next = current_delay_node;
-                pThreadInfo->delayList.tail = current_delay_node;
-                pThreadInfo->delayList.size++;
-            }
-            pThreadInfo->totalDelay += delay;
 
             int64_t currentPrintTime = toolsGetTimestampMs();
             if (currentPrintTime - lastPrintTime > 30 * 1000) {
@@ -1223,6 +1943,12 @@ void *syncWriteProgressive(void *sarg) {
         }  // insertRows
     }      // tableSeq
 free_of_progressive:
+    benchPhaseSwitch(pThreadInfo, PHASE_WAIT);
+    destroyAsyncPool(pThreadInfo);
+    benchPhaseStop(pThreadInfo);
+    pThreadInfo->et = toolsGetTimestampUs();
+    tmfree(pThreadInfo->tblHeaderBuf);
+    freeTagCache();
     if (0 == pThreadInfo->totalDelay) pThreadInfo->totalDelay = 1;
     if (stbInfo->no_check_for_affected_rows) {
         infoPrint(stdout,
@@ -1240,9 +1966,1052 @@ free_of_progressive:
                   (double)(pThreadInfo->totalAffectedRows /
                            ((double)pThreadInfo->totalDelay / 1000000.0)));
     }
+    benchMetricsThread(-1);
+    return NULL;
+}
+
+static void printRateReport(FILE *fp, SSuperTable *stbInfo, double achieved) {
+    const char *unit =
+        stbInfo->insert_rate_unit == RATE_UNIT_ROWS ? "rows" : "requests";
+    infoPrint(fp,
+            "insert rate, target: %" PRIu64 " %s/second, achieved: %.2f "
+            "%s/second (%.2f%%)\n",
+            stbInfo->insert_rate, unit, achieved, unit,
+            achieved * 100.0 / (double)stbInfo->insert_rate);
+}
+
+// latency measured from each request's intended send time, so a server stall
+// shows up in the percentiles instead of just lowering the send rate
+static void printCorrectedDelay(FILE *fp, SLatencyHist *hist) {
+    benchHistPrint(fp, "insert delay corrected for coordinated omission",
+                   hist, 1000.0, "ms");
+}
+
+// interlace batches hold reqPerReq / interlaceRows tables of interlaceRows
+// rows each, progressive batches stop before overflowing MAX_SQL_LEN
+static uint64_t calcInsertSqlLen(SDataBase *database, SSuperTable *stbInfo) {
+    if (stbInfo->interlaceRows == 0) {
+        return MAX_SQL_LEN;
+    }
+    uint64_t tables = g_arguments->reqPerReq / stbInfo->interlaceRows + 1;
+    return strlen(STR_INSERT_INTO) +
+           tables * calcTableHeaderLen(database, stbInfo) +
+           (uint64_t)g_arguments->reqPerReq * calcSqlRowLen(stbInfo) + 1;
+}
+
+// generation and send time summed over threads, whatever exceeds the
+// threads' wall time was overlapped by the pipeline
+static void printGenerationReport(FILE *fp, uint64_t genDelay,
+                                  uint64_t sendDelay, uint64_t workTime) {
+    uint64_t hidden = 0;
+    if (genDelay + sendDelay > workTime) {
+        hidden = genDelay + sendDelay - workTime;
+        if (hidden > genDelay) hidden = genDelay;
+    }
+    infoPrint(fp,
+              "generation time: %.2fs, send time: %.2fs, generation hidden "
+              "behind sends: %.2fs (%.2f%%)\n\n",
+              genDelay / 1E6, sendDelay / 1E6, hidden / 1E6,
+              genDelay ? hidden * 100.0 / genDelay : 0.0);
+}
+
+// request body volume before and after rest_compression
+static void printCompressionReport(FILE *fp, uint64_t bodyBytes,
+                                   uint64_t wireBytes, uint64_t cpuUs,
+                                   double seconds) {
+    infoPrint(fp,
+              "request bodies: %.2fMB (%.2fMB/s) uncompressed, %.2fMB "
+              "(%.2fMB/s) sent, ratio: %.2f, compression cpu time: %.2fs\n\n",
+              bodyBytes / 1048576.0, bodyBytes / 1048576.0 / seconds,
+              wireBytes / 1048576.0, wireBytes / 1048576.0 / seconds,
+              wireBytes ? (double)bodyBytes / wireBytes : 0.0, cpuUs / 1E6);
+}
+
+static const char *g_phaseNames[PHASE_NUM] = {
+    "build", "stmt bind", "json print", "throttle",
+    "compress", "send", "server wait"};
+
+static void printPhaseRow(FILE *fp, const char *name, const uint64_t *ns) {
+    uint64_t wall = 0;
+    for (int p = 0; p < PHASE_NUM; p++) {
+        wall += ns[p];
+    }
+    char line[256];
+    int  len = snprintf(line, sizeof(line), "%8s", name);
+    for (int p = 0; p < PHASE_NUM; p++) {
+        len += snprintf(line + len, sizeof(line) - len, " %11.2f%%",
+                        wall ? ns[p] * 100.0 / wall : 0.0);
+    }
+    infoPrint(fp, "%s\n", line);
+}
+
+// share of wall time per client-side phase, per thread and overall, to
+// tell whether a configuration is limited by the client or the server
+static void printPhaseReport(FILE *fp, threadInfo *infos, int threads) {
+    uint64_t total[PHASE_NUM] = {0};
+    char     line[256];
+    int      len = snprintf(line, sizeof(line), "%8s", "thread");
+    for (int p = 0; p < PHASE_NUM; p++) {
+        len += snprintf(line + len, sizeof(line) - len, " %12s",
+                        g_phaseNames[p]);
+    }
+    infoPrint(fp, "%s\n", "insert phases, percent of thread wall time:");
+    infoPrint(fp, "%s\n", line);
+    for (int i = 0; i < threads; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%d", infos[i].threadID);
+        printPhaseRow(fp, name, infos[i].phaseNs);
+        for (int p = 0; p < PHASE_NUM; p++) {
+            total[p] += infos[i].phaseNs[p];
+        }
+    }
+    printPhaseRow(fp, "total", total);
+
+    uint64_t wall = 0;
+    for (int p = 0; p < PHASE_NUM; p++) {
+        wall += total[p];
+    }
+    if (wall == 0) {
+        wall = 1;
+    }
+    uint64_t client = wall - total[PHASE_WAIT] - total[PHASE_THROTTLE];
+    infoPrint(fp,
+              "client side: %.2f%%, server wait: %.2f%%, throttled: %.2f%%, "
+              "%s bound\n\n",
+              client * 100.0 / wall, total[PHASE_WAIT] * 100.0 / wall,
+              total[PHASE_THROTTLE] * 100.0 / wall,
+              client > total[PHASE_WAIT] ? "client" : "server");
+}
+
+// how evenly rows and busy time ended up spread over the insert threads
+static void printThreadBalance(FILE *fp, threadInfo *infos, int threads,
+                               bool stealing) {
+    uint64_t minRows = UINT64_MAX, maxRows = 0, totalRows = 0;
+    uint64_t minBusy = UINT64_MAX, maxBusy = 0;
+    for (int i = 0; i < threads; i++) {
+        threadInfo *pThreadInfo = infos + i;
+        uint64_t    busy = pThreadInfo->et - pThreadInfo->st;
+        if (stealing) {
+            infoPrint(fp,
+                      "thread[%d] inserted rows: %" PRIu64 ", table chunks: "
+                      "%" PRIu64 ", busy: %.2fs\n",
+                      pThreadInfo->threadID, pThreadInfo->totalInsertRows,
+                      pThreadInfo->unitsTaken, busy / 1E6);
+        }
+        totalRows += pThreadInfo->totalInsertRows;
+        if (pThreadInfo->totalInsertRows < minRows)
+            minRows = pThreadInfo->totalInsertRows;
+        if (pThreadInfo->totalInsertRows > maxRows)
+            maxRows = pThreadInfo->totalInsertRows;
+        if (busy < minBusy) minBusy = busy;
+        if (busy > maxBusy) maxBusy = busy;
+    }
+    double avgRows = (double)totalRows / threads;
+    infoPrint(fp,
+              "thread balance, rows min: %" PRIu64 ", avg: %.0f, max: %" PRIu64
+              " (max/avg %.2f), busy min: %.2fs, max: %.2fs\n\n",
+              minRows, avgRows, maxRows, avgRows > 0 ? maxRows / avgRows : 0.0,
+              minBusy / 1E6, maxBusy / 1E6);
+}
+
+// a stored name with its position, sorted by name to look tables up
+typedef struct SNamedIndex_S {
+    const char *name;
+    uint64_t    index;
+} SNamedIndex;
+
+static int compareNamedIndex(const void *a, const void *b) {
+    return strcmp(((SNamedIndex *)a)->name, ((SNamedIndex *)b)->name);
+}
+
+static int compareKeyName(const void *key, const void *elem) {
+    return strcmp((const char *)key, ((SNamedIndex *)elem)->name);
+}
+
+// position of a server side table name among the insert targets, or -1
+static int64_t findChildTable(SNameStore *store, SNamedIndex *byName,
+                              uint64_t ntables, const char *name, int len) {
+    char key[TSDB_TABLE_NAME_LEN + 3];
+    int  klen = 0;
+    if (len <= 0 || len >= TSDB_TABLE_NAME_LEN) {
+        return -1;
+    }
+    if (store->escape) {
+        key[klen++] = '`';
+    }
+    memcpy(key + klen, name, len);
+    klen += len;
+    if (store->escape) {
+        key[klen++] = '`';
+    }
+    key[klen] = '\0';
+    if (store->arena) {
+        SNamedIndex *hit = bsearch(key, byName, ntables, sizeof(SNamedIndex),
+                                   compareKeyName);
+        return hit ? (int64_t)hit->index : -1;
+    }
+    // generated names are the prefix followed by the index
+    char *digits = key + store->prefixLen;
+    if (klen <= store->prefixLen ||
+        0 != memcmp(key, store->prefix, store->prefixLen) ||
+        !isdigit((unsigned char)digits[0]) ||
+        (digits[0] == '0' && isdigit((unsigned char)digits[1]))) {
+        return -1;
+    }
+    char *   end;
+    uint64_t index = strtoull(digits, &end, 10);
+    if (*end != (store->escape ? '`' : '\0') || index >= ntables) {
+        return -1;
+    }
+    return (int64_t)index;
+}
+
+// learn the vgroup of every child table from the server and sort the name
+// store by it, so that a contiguous table range lives in a single vgroup
+static int routeTablesByVgroup(SDataBase *database, SSuperTable *stbInfo,
+                               uint64_t ntables) {
+    SNameStore * store = &stbInfo->childTblNames;
+    int32_t *    vgroups = benchCalloc(ntables, sizeof(int32_t), false);
+    uint64_t *   order = benchCalloc(ntables, sizeof(uint64_t), false);
+    uint64_t *   counts = NULL;
+    SNamedIndex *byName = NULL;
+    int          ret = -1;
+    for (uint64_t i = 0; i < ntables; i++) {
+        vgroups[i] = -1;
+    }
+    if (store->arena) {
+        byName = benchCalloc(ntables, sizeof(SNamedIndex), false);
+        for (uint64_t i = 0; i < ntables; i++) {
+            byName[i].name = store->arena + store->offsets[i];
+            byName[i].index = i;
+        }
+        qsort(byName, ntables, sizeof(SNamedIndex), compareNamedIndex);
+    }
+
+    TAOS *taos = select_one_from_pool(NULL);
+    char  cmd[SQL_BUFF_LEN];
+    snprintf(cmd, SQL_BUFF_LEN,
+             "select table_name, vgroup_id from information_schema.ins_tables"
+             " where db_name='%s' and stable_name='%s'",
+             database->dbName, stbInfo->stbName);
+    TAOS_RES *res = taos_query(taos, cmd);
+    if (taos_errno(res)) {
+        errorPrint(stderr, "failed to get vgroups of child tables: %s. "
+                   "reason: %s\n", cmd, taos_errstr(res));
+        taos_free_result(res);
+        goto route_end;
+    }
+    int32_t  maxVgroup = -1;
+    uint64_t found = 0;
+    TAOS_ROW row;
+    while ((row = taos_fetch_row(res)) != NULL) {
+        int *lengths = taos_fetch_lengths(res);
+        if (row[0] == NULL || row[1] == NULL) {
+            continue;
+        }
+        int64_t pos =
+            findChildTable(store, byName, ntables, row[0], lengths[0]);
+        if (pos < 0) {
+            continue;
+        }
+        vgroups[pos] = *(int32_t *)row[1];
+        if (vgroups[pos] > maxVgroup) {
+            maxVgroup = vgroups[pos];
+        }
+        found++;
+    }
+    taos_free_result(res);
+    if (found < ntables) {
+        infoPrint(stdout,
+                  "%" PRIu64 " of %" PRIu64 " child table(s) of %s not found "
+                  "on the server, they are routed together\n",
+                  ntables - found, ntables, stbInfo->stbName);
+    }
+
+    // counting sort by vgroup, tables of unknown vgroup go last
+    counts = benchCalloc(maxVgroup + 2, sizeof(uint64_t), false);
+    for (uint64_t i = 0; i < ntables; i++) {
+        counts[vgroups[i] < 0 ? maxVgroup + 1 : vgroups[i]]++;
+    }
+    uint64_t next = 0;
+    for (int32_t v = 0; v <= maxVgroup + 1; v++) {
+        uint64_t count = counts[v];
+        counts[v] = next;
+        next += count;
+    }
+    for (uint64_t i = 0; i < ntables; i++) {
+        order[counts[vgroups[i] < 0 ? maxVgroup + 1 : vgroups[i]]++] = i;
+    }
+    stbInfo->tblVgroups = benchCalloc(ntables, sizeof(int32_t), true);
+    for (uint64_t i = 0; i < ntables; i++) {
+        stbInfo->tblVgroups[i] = vgroups[order[i]];
+    }
+    ret = reorderNameStore(stbInfo, order, ntables);
+
+route_end:
+    tmfree(byName);
+    tmfree(counts);
+    tmfree(order);
+    tmfree(vgroups);
+    return ret;
+}
+
+// split the vgroup sorted tables into thread ranges: with at least as many
+// threads as vgroups each vgroup gets threads of its own in proportion to
+// its tables, otherwise every thread takes whole vgroups; returns the
+// number of threads used
+static int planVgroupRanges(SSuperTable *stbInfo, uint64_t ntables,
+                            int threads, uint64_t *from, uint64_t *to) {
+    uint64_t *groupStart = benchCalloc(ntables, sizeof(uint64_t), false);
+    uint64_t  groups = 0;
+    for (uint64_t i = 0; i < ntables; i++) {
+        if (i == 0 || stbInfo->tblVgroups[i] != stbInfo->tblVgroups[i - 1]) {
+            groupStart[groups++] = i;
+        }
+    }
+    int used = 0;
+    if ((uint64_t)threads >= groups) {
+        uint64_t *shares = benchCalloc(groups, sizeof(uint64_t), false);
+        for (uint64_t g = 0; g < groups; g++) {
+            shares[g] = 1;
+        }
+        for (uint64_t extra = threads - groups; extra > 0; extra--) {
+            int64_t best = -1;
+            double  bestLoad = 0;
+            for (uint64_t g = 0; g < groups; g++) {
+                uint64_t end = g + 1 < groups ? groupStart[g + 1] : ntables;
+                uint64_t count = end - groupStart[g];
+                double   load = (double)count / shares[g];
+                if (shares[g] < count && load > bestLoad) {
+                    best = (int64_t)g;
+                    bestLoad = load;
+                }
+            }
+            if (best < 0) {
+                break;
+            }
+            shares[best]++;
+        }
+        for (uint64_t g = 0; g < groups; g++) {
+            uint64_t end = g + 1 < groups ? groupStart[g + 1] : ntables;
+            uint64_t count = end - groupStart[g];
+            uint64_t a = count / shares[g], b = count % shares[g];
+            uint64_t tableFrom = groupStart[g];
+            for (uint64_t k = 0; k < shares[g]; k++) {
+                from[used] = tableFrom;
+                to[used] = tableFrom + (k < b ? a : a - 1);
+                tableFrom = to[used++] + 1;
+            }
+        }
+        tmfree(shares);
+    } else {
+        uint64_t acc = 0;
+        from[0] = 0;
+        for (uint64_t g = 0; g < groups; g++) {
+            uint64_t end = g + 1 < groups ? groupStart[g + 1] : ntables;
+            acc += end - groupStart[g];
+            uint64_t groupsLeft = groups - g - 1;
+            uint64_t threadsLeft = threads - used - 1;
+            if (threadsLeft > 0 && groupsLeft >= threadsLeft &&
+                (acc >= ntables * (used + 1) / threads ||
+                 groupsLeft == threadsLeft)) {
+                to[used++] = end - 1;
+                from[used] = end;
+            }
+        }
+        to[used++] = ntables - 1;
+    }
+    tmfree(groupStart);
+    return used;
+}
+
+// rows written per vgroup, threads spanning several vgroups are summed up
+// on their own
+static void printVgroupReport(FILE *fp, threadInfo *infos, int threads,
+                              int64_t spent) {
+    if (spent == 0) spent = 1;
+    for (int i = 0; i < threads; i++) {
+        int32_t vgroup = infos[i].vgroup;
+        bool    seen = false;
+        for (int k = 0; k < i && !seen; k++) {
+            seen = infos[k].vgroup == vgroup;
+        }
+        if (seen) {
+            continue;
+        }
+        uint64_t rows = 0;
+        int      count = 0;
+        for (int k = i; k < threads; k++) {
+            if (infos[k].vgroup == vgroup) {
+                rows += infos[k].totalInsertRows;
+                count++;
+            }
+        }
+        if (vgroup < 0) {
+            infoPrint(fp,
+                      "several or unknown vgroups: %" PRIu64 " rows with %d "
+                      "thread(s), %.2f records/second\n",
+                      rows, count, rows * 1E6 / spent);
+        } else {
+            infoPrint(fp,
+                      "vgroup %d: %" PRIu64 " rows with %d thread(s), %.2f "
+                      "records/second\n",
+                      vgroup, rows, count, rows * 1E6 / spent);
+        }
+    }
+}
+
+// one sql batch for a replay worker, rows of consecutive lines for the same
+// table share its "db.tb values " header
+typedef struct SReplayBatch_S {
+    char *                 data;
+    uint32_t               len;
+    uint32_t               rows;
+    char                   table[TSDB_TABLE_NAME_LEN + 2];
+    struct SReplayBatch_S *next;
+} SReplayBatch;
+
+// hands batches from the replay reader to one worker. The reader fills a
+// free batch and queues it, the worker sends it and returns it to the free
+// list, so a worker never holds more than replay_queue batches
+typedef struct SReplayQueue_S {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    SReplayBatch *  batches;
+    uint32_t        count;
+    SReplayBatch *  head;
+    SReplayBatch *  tail;
+    SReplayBatch *  freeBatches;
+    SReplayBatch *  filling;  // reader side only
+    bool            done;
+} SReplayQueue;
+
+typedef struct SReplayReader_S {
+    SDataBase *   database;
+    SSuperTable * stbInfo;
+    SReplayQueue *queues;
+    int           workers;
+    char *        readBuf;
+    Field *       tag;         // the tag set from the partition value
+    uint32_t      headerLen;   // header bound without the tag value
+    double        usPerUnit;   // wall clock us per timestamp unit
+    bool          needTs;
+    bool          started;
+    int64_t       firstTs;
+    int64_t       tsOffset;
+    int64_t       startUs;
+    int64_t       maxLagUs;
+    uint64_t      rows;
+    uint64_t      skipped;
+    uint64_t      bytes;
+    int64_t       lastPrintMs;
+} SReplayReader;
+
+static void initReplayQueue(SReplayQueue *queue, uint32_t count) {
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    queue->count = count;
+    queue->batches = benchCalloc(count, sizeof(SReplayBatch), true);
+    for (uint32_t i = 0; i < count; i++) {
+        queue->batches[i].data = benchCalloc(1, MAX_SQL_LEN, false);
+        queue->batches[i].next = queue->freeBatches;
+        queue->freeBatches = queue->batches + i;
+    }
+}
+
+static void destroyReplayQueue(SReplayQueue *queue) {
+    for (uint32_t i = 0; i < queue->count; i++) {
+        tmfree(queue->batches[i].data);
+    }
+    tmfree(queue->batches);
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->cond);
+}
+
+static SReplayBatch *takeReplayBatch(SReplayQueue *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->freeBatches == NULL) {
+        pthread_cond_wait(&queue->cond, &queue->mutex);
+    }
+    SReplayBatch *batch = queue->freeBatches;
+    queue->freeBatches = batch->next;
+    pthread_mutex_unlock(&queue->mutex);
+    batch->len = (uint32_t)strlen(STR_INSERT_INTO);
+    memcpy(batch->data, STR_INSERT_INTO, batch->len);
+    batch->data[batch->len] = '\0';
+    batch->rows = 0;
+    batch->table[0] = '\0';
+    batch->next = NULL;
+    return batch;
+}
+
+static void queueReplayBatch(SReplayQueue *queue) {
+    SReplayBatch *batch = queue->filling;
+    queue->filling = NULL;
+    if (batch == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->tail) {
+        queue->tail->next = batch;
+    } else {
+        queue->head = batch;
+    }
+    queue->tail = batch;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static void finishReplayQueue(SReplayQueue *queue) {
+    queueReplayBatch(queue);
+    pthread_mutex_lock(&queue->mutex);
+    queue->done = true;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+// NULL once the reader is done and the queue is drained
+static SReplayBatch *popReplayBatch(SReplayQueue *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->head == NULL && !queue->done) {
+        pthread_cond_wait(&queue->cond, &queue->mutex);
+    }
+    SReplayBatch *batch = queue->head;
+    if (batch) {
+        queue->head = batch->next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return batch;
+}
+
+static void releaseReplayBatch(SReplayQueue *queue, SReplayBatch *batch) {
+    pthread_mutex_lock(&queue->mutex);
+    batch->next = queue->freeBatches;
+    queue->freeBatches = batch;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static void *replayWorker(void *sarg) {
+    threadInfo *  pThreadInfo = (threadInfo *)sarg;
+    SReplayQueue *queue = pThreadInfo->replayQueue;
+    SDataBase *   database =
+        benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
+    SSuperTable *stbInfo =
+        benchArrayGet(database->superTbls, pThreadInfo->stb_index);
+    benchMetricsThread(1);
+    pThreadInfo->st = toolsGetTimestampUs();
+    pThreadInfo->batchStartTs = pThreadInfo->st;
+    pThreadInfo->rate_next_us = (double)pThreadInfo->st;
+    benchPhaseStart(pThreadInfo);
+    SReplayBatch *batch;
+    while ((batch = popReplayBatch(queue)) != NULL) {
+        // after a failure the queue is still drained so the reader never
+        // blocks on it
+        if (!g_fail) {
+            pThreadInfo->buffer = batch->data;
+            pThreadInfo->totalInsertRows += batch->rows;
+            if (insertBatch(pThreadInfo, stbInfo, batch->rows) < 0) {
+                g_fail = true;
+            }
+        }
+        releaseReplayBatch(queue, batch);
+    }
+    benchPhaseStop(pThreadInfo);
+    pThreadInfo->et = toolsGetTimestampUs();
+    pThreadInfo->buffer = NULL;
+    benchMetricsThread(-1);
     return NULL;
 }
 
+static void flushReplayQueues(SReplayReader *reader) {
+    for (int i = 0; i < reader->workers; i++) {
+        queueReplayBatch(reader->queues + i);
+    }
+}
+
+static int skipReplayLine(SReplayReader *reader, const char *file,
+                          uint64_t lineNo, const char *reason) {
+    if (0 == reader->skipped++) {
+        infoPrint(stdout, "%s line %" PRIu64 " skipped: %s\n", file, lineNo,
+                  reason);
+    }
+    return 0;
+}
+
+// route one csv line to the worker owning its table and append it to that
+// worker's batch as "(ts,values)", without the partition value
+static FORCE_INLINE bool isStringField(Field *field) {
+    return field->type == TSDB_DATA_TYPE_BINARY ||
+           field->type == TSDB_DATA_TYPE_NCHAR;
+}
+
+// write a csv value as one single quoted sql string, the quotes and
+// backslashes inside it escaped so the data cannot end the literal. An
+// unquoted NULL stays a null value
+static uint32_t appendSqlString(char *dst, const char *v, uint32_t len) {
+    char *p = dst;
+    if (len >= 2 && (*v == '\'' || *v == '"') && v[len - 1] == *v) {
+        v++;
+        len -= 2;
+    } else if (len == 4 && 0 == strncasecmp(v, "null", 4)) {
+        memcpy(dst, v, len);
+        return len;
+    }
+    *p++ = '\'';
+    for (uint32_t i = 0; i < len; i++) {
+        if (v[i] == '\'' || v[i] == '"' || v[i] == '\\') {
+            *p++ = '\\';
+        }
+        *p++ = v[i];
+    }
+    *p++ = '\'';
+    return (uint32_t)(p - dst);
+}
+
+static int replayLine(SReplayReader *reader, uint32_t fileIndex,
+                      const char *file, uint64_t lineNo, const char *line,
+                      uint32_t len) {
+    SSuperTable *stbInfo = reader->stbInfo;
+    int32_t      partCol = stbInfo->replayPartitionCol;
+    int32_t      tsCol = partCol == 0 ? 1 : 0;
+    const char * end = line + len;
+    const char * part = NULL;
+    const char * partEnd = NULL;
+    const char * ts = NULL;
+    const char * tsEnd = NULL;
+    int32_t      col = 0;
+    for (const char *p = line;; col++) {
+        const char *next = csvValueEnd(p, end);
+        if (next == NULL || (next < end && *next != ',')) {
+            return skipReplayLine(reader, file, lineNo, "malformed quote");
+        }
+        if (col == partCol) {
+            part = p;
+            partEnd = next;
+        } else if (col == tsCol) {
+            ts = p;
+            tsEnd = next;
+        }
+        if (next == end) {
+            break;
+        }
+        p = next + 1;
+    }
+    if (ts == NULL || (partCol >= 0 && part == NULL)) {
+        return skipReplayLine(reader, file, lineNo, "too few values");
+    }
+
+    char     name[TSDB_TABLE_NAME_LEN + 2];
+    uint32_t nameLen = 0;
+    if (partCol < 0) {
+        char  nameBuf[TSDB_TABLE_NAME_LEN];
+        char *tableName;
+        nameLen = getChildTblName(stbInfo, fileIndex % stbInfo->childTblCount,
+                                  nameBuf, &tableName);
+        memcpy(name, tableName, nameLen + 1);
+    } else {
+        const char *v = part;
+        uint32_t    vlen = (uint32_t)(partEnd - part);
+        if (vlen >= 2 && (*v == '\'' || *v == '"')) {
+            v++;
+            vlen -= 2;
+        }
+        const char *prefix = stbInfo->replayByTag ? stbInfo->childTblPrefix : "";
+        uint32_t    prefixLen = (uint32_t)strlen(prefix);
+        if (vlen == 0 || prefixLen + vlen + 2 >= TSDB_TABLE_NAME_LEN) {
+            return skipReplayLine(reader, file, lineNo,
+                                  "partition value is not a table name");
+        }
+        if (stbInfo->escape_character) {
+            name[nameLen++] = '`';
+        }
+        memcpy(name + nameLen, prefix, prefixLen);
+        nameLen += prefixLen;
+        for (uint32_t i = 0; i < vlen; i++) {
+            char c = v[i];
+            // tag values may hold anything, names only take these
+            if (stbInfo->replayByTag && !isalnum((unsigned char)c)) {
+                c = '_';
+            }
+            name[nameLen++] = c;
+        }
+        if (stbInfo->escape_character) {
+            name[nameLen++] = '`';
+        }
+        name[nameLen] = '\0';
+    }
+
+    int64_t tsValue = 0;
+    if (reader->needTs) {
+        char  token[TIMESTAMP_BUFF_LEN];
+        char *tokenEnd;
+        if (tsEnd - ts == 0 || tsEnd - ts >= TIMESTAMP_BUFF_LEN) {
+            return skipReplayLine(reader, file, lineNo,
+                                  "timestamp is not an integer");
+        }
+        memcpy(token, ts, tsEnd - ts);
+        token[tsEnd - ts] = '\0';
+        tsValue = strtoll(token, &tokenEnd, 10);
+        if (*tokenEnd != '\0') {
+            return skipReplayLine(reader, file, lineNo,
+                                  "timestamp is not an integer");
+        }
+        if (!reader->started) {
+            reader->started = true;
+            reader->firstTs = tsValue;
+            reader->startUs = toolsGetTimestampUs();
+            if (stbInfo->replayShiftTs) {
+                reader->tsOffset =
+                    toolsGetTimestamp(reader->database->dbCfg.precision) -
+                    tsValue;
+            }
+        }
+        if (stbInfo->replaySpeed > 0) {
+            int64_t due = reader->startUs +
+                          (int64_t)((tsValue - reader->firstTs) *
+                                    reader->usPerUnit / stbInfo->replaySpeed);
+            int64_t now = toolsGetTimestampUs();
+            if (due > now + 1000) {
+                // rows waiting in half filled batches are due already
+                flushReplayQueues(reader);
+                toolsUsleepUntil(due);
+            } else if (now - due > reader->maxLagUs) {
+                reader->maxLagUs = now - due;
+            }
+        }
+    }
+
+    const char *tagValue = part;
+    uint32_t    tagLen = (uint32_t)(partEnd - part);
+    // escaping at most doubles a value and adds its two quotes
+    uint32_t need =
+        reader->headerLen + nameLen + len * 3 + TIMESTAMP_BUFF_LEN + 4;
+    if (stbInfo->replayByTag) {
+        need += tagLen * 2 + 2;
+    }
+    if (need >= MAX_SQL_LEN - sizeof(STR_INSERT_INTO)) {
+        return skipReplayLine(reader, file, lineNo, "row too long");
+    }
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (uint32_t i = 0; i < nameLen; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 0x100000001B3ULL;
+    }
+    SReplayQueue *queue = reader->queues + hash % reader->workers;
+    SReplayBatch *batch = queue->filling;
+    if (batch && (batch->rows >= g_arguments->reqPerReq ||
+                  batch->len + need >= MAX_SQL_LEN)) {
+        queueReplayBatch(queue);
+        batch = NULL;
+    }
+    if (batch == NULL) {
+        batch = takeReplayBatch(queue);
+        queue->filling = batch;
+    }
+
+    char *dst = batch->data + batch->len;
+    if (strcmp(batch->table, name) != 0) {
+        SDataBase *database = reader->database;
+        if (batch->rows > 0) {
+            *dst++ = ' ';
+        }
+        if (stbInfo->replayByTag) {
+            dst += sprintf(dst, "%s.%s using `%s` (`%s`) tags (",
+                           database->dbName, name, stbInfo->stbName,
+                           reader->tag->name);
+            if (isStringField(reader->tag)) {
+                dst += appendSqlString(dst, tagValue, tagLen);
+            } else {
+                memcpy(dst, tagValue, tagLen);
+                dst += tagLen;
+            }
+            dst += sprintf(dst, ") values ");
+        } else {
+            dst += sprintf(dst, "%s.%s values ", database->dbName, name);
+        }
+        memcpy(batch->table, name, nameLen + 1);
+    }
+    *dst++ = '(';
+    int32_t value = 0;
+    col = 0;
+    for (const char *p = line;; col++) {
+        const char *next = csvValueEnd(p, end);
+        if (col != partCol) {
+            // value 0 is the timestamp, the others follow the columns
+            Field *field = NULL;
+            if (value > 0) {
+                *dst++ = ',';
+                if (value <= stbInfo->cols->size) {
+                    field = benchArrayGet(stbInfo->cols, value - 1);
+                }
+            }
+            value++;
+            if (col == tsCol && stbInfo->replayShiftTs) {
+                dst += benchInt64ToStr(tsValue + reader->tsOffset, dst);
+            } else if (field && isStringField(field)) {
+                dst += appendSqlString(dst, p, (uint32_t)(next - p));
+            } else {
+                memcpy(dst, p, next - p);
+                dst += next - p;
+            }
+        }
+        if (next == end) {
+            break;
+        }
+        p = next + 1;
+    }
+    *dst++ = ')';
+    *dst = '\0';
+    batch->len = (uint32_t)(dst - batch->data);
+    batch->rows++;
+    reader->rows++;
+    return 0;
+}
+
+// stream one file through a fixed read buffer, a line is parsed once it is
+// complete and the unparsed tail moves to the front for the next read
+static int replayFile(SReplayReader *reader, uint32_t fileIndex,
+                      const char *file) {
+    FILE *fp = fopen(file, "rb");
+    if (fp == NULL) {
+        errorPrint(stderr, "Failed to open replay file: %s, reason:%s\n", file,
+                   strerror(errno));
+        return -1;
+    }
+    infoPrint(stdout, "replay %s into stable<%s>\n", file,
+              reader->stbInfo->stbName);
+    char *   buf = reader->readBuf;
+    size_t   have = 0;
+    uint64_t lineNo = 0;
+    int      code = 0;
+    while (!g_fail) {
+        have += fread(buf + have, 1, REPLAY_READ_BUF - have, fp);
+        bool  last = feof(fp) || ferror(fp);
+        char *p = buf;
+        char *end = buf + have;
+        while (p < end) {
+            char *nl = memchr(p, '\n', end - p);
+            if (nl == NULL && !last) {
+                break;
+            }
+            char *   lineEnd = nl ? nl : end;
+            uint32_t len = (uint32_t)(lineEnd - p);
+            lineNo++;
+            if (len > 0 && p[len - 1] == '\r') {
+                len--;
+            }
+            if (len > 0 &&
+                replayLine(reader, fileIndex, file, lineNo, p, len)) {
+                code = -1;
+                goto free_of_replay_file;
+            }
+            p = nl ? nl + 1 : end;
+        }
+        if (p == buf && have == REPLAY_READ_BUF) {
+            errorPrint(stderr, "%s line %" PRIu64 " is longer than %d bytes\n",
+                       file, lineNo + 1, REPLAY_READ_BUF);
+            code = -1;
+            break;
+        }
+        reader->bytes += p - buf;
+        have = end - p;
+        memmove(buf, p, have);
+        if (ferror(fp)) {
+            errorPrint(stderr, "Failed to read replay file: %s, reason:%s\n",
+                       file, strerror(errno));
+            code = -1;
+            break;
+        }
+        if (last) {
+            break;
+        }
+        int64_t now = toolsGetTimestampMs();
+        if (now - reader->lastPrintMs > PRINT_STAT_INTERVAL) {
+            infoPrint(stdout,
+                      "replay has currently read rows: %" PRIu64
+                      ", %.2fMB, skipped: %" PRIu64 "\n",
+                      reader->rows, reader->bytes / 1048576.0,
+                      reader->skipped);
+            reader->lastPrintMs = now;
+        }
+    }
+free_of_replay_file:
+    fclose(fp);
+    return code;
+}
+
+// stream replay_files into the stable: this thread reads and routes rows by
+// table so the rows of a table stay in order, nthreads workers insert them
+static int startReplayInsert(int db_index, int stb_index) {
+    SDataBase *  database = benchArrayGet(g_arguments->databases, db_index);
+    SSuperTable *stbInfo = benchArrayGet(database->superTbls, stb_index);
+    if (stbInfo->iface != TAOSC_IFACE) {
+        errorPrint(stderr, "%s", "replay_files only supports taosc insertion\n");
+        return -1;
+    }
+    if (stbInfo->replayByTag &&
+        (stbInfo->replayPartitionCol < 0 || stbInfo->tags->size == 0)) {
+        errorPrint(stderr, "%s",
+                   "replay_partition_by tag needs replay_partition_col and a "
+                   "stable with tags\n");
+        return -1;
+    }
+    if (stbInfo->replayPartitionCol < 0) {
+        if (stbInfo->childTblCount == 0) {
+            errorPrint(stderr, "%s",
+                       "replay_files without replay_partition_col need child "
+                       "tables to write into\n");
+            return -1;
+        }
+        initNameStore(&stbInfo->childTblNames, stbInfo->childTblPrefix,
+                      stbInfo->escape_character);
+    }
+    if (stbInfo->async_inflight > 0 || stbInfo->pipeline_buffers > 1 ||
+        stbInfo->rest_connections > 0) {
+        infoPrint(stdout, "%s",
+                  "replay inserts synchronously from its worker threads, "
+                  "async_inflight and pipeline_buffers are ignored\n");
+        stbInfo->async_inflight = 0;
+        stbInfo->pipeline_buffers = 0;
+        stbInfo->rest_connections = 0;
+    }
+
+    SReplayReader reader = {0};
+    reader.database = database;
+    reader.stbInfo = stbInfo;
+    reader.workers = g_arguments->nthreads > 0 ? g_arguments->nthreads : 1;
+    reader.needTs = stbInfo->replayShiftTs || stbInfo->replaySpeed > 0;
+    reader.lastPrintMs = toolsGetTimestampMs();
+    switch (database->dbCfg.precision) {
+        case TSDB_TIME_PRECISION_MICRO:
+            reader.usPerUnit = 1;
+            break;
+        case TSDB_TIME_PRECISION_NANO:
+            reader.usPerUnit = 0.001;
+            break;
+        default:
+            reader.usPerUnit = 1000;
+            break;
+    }
+    reader.headerLen = (uint32_t)strlen(database->dbName) + 16;
+    if (stbInfo->replayByTag) {
+        reader.tag = benchArrayGet(stbInfo->tags, 0);
+        reader.headerLen += (uint32_t)(strlen(stbInfo->stbName) +
+                                       strlen(reader.tag->name) + 32);
+    }
+    reader.readBuf = benchCalloc(1, REPLAY_READ_BUF, false);
+    reader.queues = benchCalloc(reader.workers, sizeof(SReplayQueue), true);
+    pthread_t * pids = benchCalloc(reader.workers, sizeof(pthread_t), true);
+    threadInfo *infos = benchCalloc(reader.workers, sizeof(threadInfo), true);
+    for (int i = 0; i < reader.workers; i++) {
+        threadInfo *pThreadInfo = infos + i;
+        initReplayQueue(reader.queues + i, stbInfo->replayQueue);
+        pThreadInfo->replayQueue = reader.queues + i;
+        pThreadInfo->threadID = i;
+        pThreadInfo->db_index = db_index;
+        pThreadInfo->stb_index = stb_index;
+        pThreadInfo->minDelay = UINT64_MAX;
+        pThreadInfo->stats = benchStatsRegister(stbInfo->stbName);
+        pThreadInfo->metrics = benchMetricsRegister(stbInfo->stbName);
+        pThreadInfo->taos = select_thread_conn(i, 0, database->dbName);
+        benchHistInit(&(pThreadInfo->delayHist), g_arguments->latency_max);
+        if (stbInfo->insert_rate > 0) {
+            benchHistInit(&(pThreadInfo->correctedDelayHist),
+                          g_arguments->latency_max);
+            pThreadInfo->rate_step_us =
+                1000000.0 * reader.workers / (double)stbInfo->insert_rate;
+        }
+    }
+    infoPrint(stdout,
+              "replay buffers: %.2fMB in %d worker(s) * %u batch(es)\n",
+              (double)reader.workers * stbInfo->replayQueue * MAX_SQL_LEN /
+                  1048576,
+              reader.workers, stbInfo->replayQueue);
+    prompt(0);
+
+    int64_t start = toolsGetTimestampUs();
+    for (int i = 0; i < reader.workers; i++) {
+        pthread_create(pids + i, NULL, replayWorker, infos + i);
+    }
+    for (uint32_t f = 0; f < stbInfo->replayFiles->size && !g_fail; f++) {
+        // agents take whole files in turn
+        if (g_arguments->agent_count > 1 &&
+            f % g_arguments->agent_count != g_arguments->agent_index) {
+            continue;
+        }
+        char **file = benchArrayGet(stbInfo->replayFiles, f);
+        if (replayFile(&reader, f, *file)) {
+            g_fail = true;
+        }
+    }
+    for (int i = 0; i < reader.workers; i++) {
+        finishReplayQueue(reader.queues + i);
+    }
+    for (int i = 0; i < reader.workers; i++) {
+        pthread_join(pids[i], NULL);
+    }
+    int64_t end = toolsGetTimestampUs();
+
+    SLatencyHist delayHist;
+    uint64_t     totalInsertRows = 0;
+    uint64_t     totalAffectedRows = 0;
+    benchHistInit(&delayHist, g_arguments->latency_max);
+    for (int i = 0; i < reader.workers; i++) {
+        threadInfo *pThreadInfo = infos + i;
+        totalInsertRows += pThreadInfo->totalInsertRows;
+        totalAffectedRows += pThreadInfo->totalAffectedRows;
+        benchHistMerge(&delayHist, &(pThreadInfo->delayHist));
+        benchHistDestroy(&(pThreadInfo->delayHist));
+        benchHistDestroy(&(pThreadInfo->correctedDelayHist));
+        destroyReplayQueue(reader.queues + i);
+    }
+    if (g_arguments->phase_timers) {
+        printPhaseReport(stdout, infos, reader.workers);
+        if (g_arguments->fpOfInsertResult) {
+            printPhaseReport(g_arguments->fpOfInsertResult, infos,
+                             reader.workers);
+        }
+    }
+    tmfree(reader.readBuf);
+    tmfree(reader.queues);
+    tmfree(pids);
+    tmfree(infos);
+
+    double seconds = (end - start) / 1000000.0;
+    if (seconds <= 0) seconds = 1E-6;
+    FILE *fps[] = {stdout, g_arguments->fpOfInsertResult};
+    for (int i = 0; i < 2 && fps[i]; i++) {
+        infoPrint(fps[i],
+                  "Spent %.4f seconds to replay rows: %" PRIu64
+                  ", affected rows: %" PRIu64 ", skipped lines: %" PRIu64
+                  " with %d thread(s) into %s %.2f records/second, "
+                  "%.2fMB/s read\n",
+                  seconds, totalInsertRows, totalAffectedRows, reader.skipped,
+                  reader.workers, database->dbName, totalInsertRows / seconds,
+                  reader.bytes / 1048576.0 / seconds);
+        if (stbInfo->replaySpeed > 0) {
+            infoPrint(fps[i],
+                      "replay at %.2fx recorded pace fell behind by up to "
+                      "%.3f seconds\n",
+                      stbInfo->replaySpeed, reader.maxLagUs / 1000000.0);
+        }
+        benchHistPrint(fps[i], "insert delay", &delayHist, 1000.0, "ms");
+    }
+    char label[SQL_BUFF_LEN];
+    snprintf(label, sizeof(label), "replay %s.%s", database->dbName,
+             stbInfo->stbName);
+    if (benchHistDump(&delayHist, label)) {
+        g_fail = true;
+    }
+    benchAgentReport(database->dbName, stbInfo->stbName, totalInsertRows,
+                     totalAffectedRows, end - start, &delayHist);
+    benchHistDestroy(&delayHist);
+    return g_fail ? -1 : 0;
+}
+
 static int startMultiThreadInsertData(int db_index, int stb_index) {
     SDataBase *  database = benchArrayGet(g_arguments->databases, db_index);
     SSuperTable *stbInfo = benchArrayGet(database->superTbls, stb_index);
@@ -1251,6 +3020,9 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         errorPrint(stderr, "%s", "schemaless cannot work without stable\n");
         return -1;
     }
+    if (stbInfo->replayFiles) {
+        return startReplayInsert(db_index, stb_index);
+    }
 
     if (stbInfo->interlaceRows > g_arguments->reqPerReq) {
         infoPrint(
@@ -1277,6 +3049,83 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         g_arguments->reqPerReq = stbInfo->insertRows;
     }
 
+    if (stbInfo->async_inflight > 0 && stbInfo->iface != TAOSC_IFACE) {
+        infoPrint(stdout, "%s",
+                  "async_inflight only applies to taosc insertion, will "
+                  "insert synchronously\n");
+        stbInfo->async_inflight = 0;
+    }
+
+    if (stbInfo->pipeline_buffers > 1) {
+        if (stbInfo->iface != TAOSC_IFACE && stbInfo->iface != REST_IFACE) {
+            infoPrint(stdout, "%s",
+                      "pipeline_buffers only applies to taosc and rest "
+                      "insertion, will generate and send in one thread\n");
+            stbInfo->pipeline_buffers = 0;
+        } else if (stbInfo->async_inflight > 0) {
+            infoPrint(stdout, "%s",
+                      "pipeline_buffers is ignored when async_inflight is "
+                      "set\n");
+            stbInfo->pipeline_buffers = 0;
+        }
+    }
+
+    if (stbInfo->rest_connections > 0) {
+#ifdef LINUX
+        if (stbInfo->iface != REST_IFACE) {
+            infoPrint(stdout, "%s",
+                      "rest_connections only applies to rest insertion, "
+                      "will be ignored\n");
+            stbInfo->rest_connections = 0;
+        } else {
+            stbInfo->async_inflight = 0;
+            stbInfo->pipeline_buffers = 0;
+        }
+#else
+        infoPrint(stdout, "%s",
+                  "rest_connections needs epoll and is only supported on "
+                  "linux, will be ignored\n");
+        stbInfo->rest_connections = 0;
+#endif
+    }
+
+    if (stbInfo->vgroup_routing) {
+        if (g_arguments->taosc_version != 3) {
+            infoPrint(stdout, "%s",
+                      "vgroup_routing needs information_schema of TDengine "
+                      "3.0, will be ignored\n");
+            stbInfo->vgroup_routing = false;
+        } else if (stbInfo->autoCreateTable || stbInfo->iface == SML_IFACE ||
+                   stbInfo->iface == SML_REST_IFACE ||
+                   !stbInfo->use_metric || stbInfo->tags->size == 0) {
+            infoPrint(stdout, "%s",
+                      "vgroup_routing needs child tables created before "
+                      "insertion, will be ignored\n");
+            stbInfo->vgroup_routing = false;
+        } else if (stbInfo->steal_chunk > 0) {
+            infoPrint(stdout, "%s",
+                      "steal_chunk is ignored when vgroup_routing is set\n");
+            stbInfo->steal_chunk = 0;
+        }
+    }
+
+    if ((stbInfo->vgroup_routing || stbInfo->steal_chunk > 0) &&
+        g_arguments->agent_count > 1) {
+        infoPrint(stdout, "%s",
+                  "vgroup_routing and steal_chunk plan over all tables, "
+                  "agents split tables evenly between threads instead\n");
+        stbInfo->vgroup_routing = false;
+        stbInfo->steal_chunk = 0;
+    }
+
+    if (stbInfo->steal_chunk > 0 &&
+        (stbInfo->iface == SML_IFACE || stbInfo->iface == SML_REST_IFACE)) {
+        infoPrint(stdout, "%s",
+                  "steal_chunk does not apply to schemaless insertion, "
+                  "tables will be split evenly between threads\n");
+        stbInfo->steal_chunk = 0;
+    }
+
     if (stbInfo->interlaceRows > 0 && stbInfo->iface == STMT_IFACE &&
         stbInfo->autoCreateTable) {
         infoPrint(stdout, "%s",
@@ -1287,10 +3136,6 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
 
     uint64_t tableFrom = 0;
     uint64_t ntables = stbInfo->childTblCount;
-    stbInfo->childTblName = benchCalloc(stbInfo->childTblCount, sizeof(char *), true);
-    for (int64_t i = 0; i < stbInfo->childTblCount; ++i) {
-        stbInfo->childTblName[i] = benchCalloc(1, TSDB_TABLE_NAME_LEN, true);
-    }
 
     if ((stbInfo->iface != SML_IFACE && stbInfo->iface != SML_REST_IFACE) &&
         stbInfo->childTblExists) {
@@ -1313,9 +3158,10 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                      stbInfo->childTblOffset);
         }
         debugPrint(stdout, "cmd: %s\n", cmd);
+        initNameStore(&stbInfo->childTblNames, NULL,
+                      stbInfo->escape_character);
         TAOS_RES *res = taos_query(taos, cmd);
         int32_t   code = taos_errno(res);
-        int64_t   count = 0;
         if (code) {
             errorPrint(stderr, "failed to get child table name: %s. reason: %s",
                        cmd, taos_errstr(res));
@@ -1326,41 +3172,48 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         TAOS_ROW row = NULL;
         while ((row = taos_fetch_row(res)) != NULL) {
             int *lengths = taos_fetch_lengths(res);
-            if (stbInfo->escape_character) {
-                stbInfo->childTblName[count][0] = '`';
-                strncpy(stbInfo->childTblName[count] + 1, row[0], lengths[0]);
-                stbInfo->childTblName[count][lengths[0] + 1] = '`';
-                stbInfo->childTblName[count][lengths[0] + 2] = '\0';
-            } else {
-                tstrncpy(stbInfo->childTblName[count], row[0], lengths[0] + 1);
+            if (appendNameStore(&stbInfo->childTblNames, row[0],
+                                (uint32_t)lengths[0])) {
+                taos_free_result(res);
+                return -1;
             }
-            debugPrint(stdout, "stbInfo->childTblName[%" PRId64 "]: %s\n",
-                       count, stbInfo->childTblName[count]);
-            count++;
+            debugPrint(stdout, "child table name[%" PRIu64 "]: %.*s\n",
+                       stbInfo->childTblNames.count - 1, lengths[0],
+                       (char *)row[0]);
         }
-        ntables = count;
+        ntables = stbInfo->childTblNames.count;
         taos_free_result(res);
     }
     else if (stbInfo->childTblCount == 1 && stbInfo->tags->size == 0) {
-        if (stbInfo->escape_character) {
-            snprintf(stbInfo->childTblName[0], TSDB_TABLE_NAME_LEN,
-                     "`%s`", stbInfo->stbName);
-        } else {
-            snprintf(stbInfo->childTblName[0], TSDB_TABLE_NAME_LEN,
-                     "%s", stbInfo->stbName);
+        initNameStore(&stbInfo->childTblNames, NULL,
+                      stbInfo->escape_character);
+        if (appendNameStore(&stbInfo->childTblNames, stbInfo->stbName,
+                            (uint32_t)strlen(stbInfo->stbName))) {
+            return -1;
         }
     } else {
-        for (int64_t i = 0; i < stbInfo->childTblCount; ++i) {
-            if (stbInfo->escape_character) {
-                snprintf(stbInfo->childTblName[i], TSDB_TABLE_NAME_LEN,
-                         "`%s%" PRIu64 "`", stbInfo->childTblPrefix, i);
-            } else {
-                snprintf(stbInfo->childTblName[i], TSDB_TABLE_NAME_LEN,
-                         "%s%" PRIu64 "", stbInfo->childTblPrefix, i);
-            }
-        }
+        // formatted on demand from prefix and index, nothing to allocate
+        initNameStore(&stbInfo->childTblNames, stbInfo->childTblPrefix,
+                      stbInfo->escape_character);
         ntables = stbInfo->childTblCount;
     }
+    if (g_arguments->agent_count > 1) {
+        // every agent takes a contiguous slice of the tables
+        uint64_t from = ntables * g_arguments->agent_index /
+                        g_arguments->agent_count;
+        uint64_t to = ntables * (g_arguments->agent_index + 1) /
+                      g_arguments->agent_count;
+        tableFrom = from;
+        ntables = to - from;
+        if (ntables == 0) {
+            infoPrint(stdout, "no table of %s.%s left for agent %u\n",
+                      database->dbName, stbInfo->stbName,
+                      g_arguments->agent_index);
+            benchAgentReport(database->dbName, stbInfo->stbName, 0, 0, 0,
+                             NULL);
+            return 0;
+        }
+    }
     int     threads = g_arguments->nthreads;
     int64_t a = ntables / threads;
     if (a < 1) {
@@ -1371,9 +3224,24 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
     if (threads != 0) {
         b = ntables % threads;
     }
+    uint64_t *rangeFrom = NULL;
+    uint64_t *rangeTo = NULL;
+    if (stbInfo->vgroup_routing && ntables > 0) {
+        if (routeTablesByVgroup(database, stbInfo, ntables)) {
+            return -1;
+        }
+        rangeFrom = benchCalloc(threads, sizeof(uint64_t), false);
+        rangeTo = benchCalloc(threads, sizeof(uint64_t), false);
+        threads = planVgroupRanges(stbInfo, ntables, threads, rangeFrom,
+                                   rangeTo);
+    }
 
     pthread_t * pids = benchCalloc(1, threads * sizeof(pthread_t), true);
     threadInfo *infos = benchCalloc(1, threads * sizeof(threadInfo), true);
+    STableScheduler scheduler;
+    if (stbInfo->steal_chunk > 0) {
+        initTableScheduler(&scheduler, stbInfo, ntables);
+    }
 
     for (int i = 0; i < threads; i++) {
         threadInfo *pThreadInfo = infos + i;
@@ -1390,10 +3258,39 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         pThreadInfo->ntables = i < b ? a + 1 : a;
         pThreadInfo->end_table_to = i < b ? tableFrom + a : tableFrom + a - 1;
         tableFrom = pThreadInfo->end_table_to + 1;
-        delay_list_init(&(pThreadInfo->delayList));
+        pThreadInfo->vgroup = -1;
+        pThreadInfo->stats = benchStatsRegister(stbInfo->stbName);
+        pThreadInfo->metrics = benchMetricsRegister(stbInfo->stbName);
+        if (rangeFrom) {
+            pThreadInfo->start_table_from = rangeFrom[i];
+            pThreadInfo->end_table_to = rangeTo[i];
+            pThreadInfo->ntables = rangeTo[i] - rangeFrom[i] + 1;
+            if (stbInfo->tblVgroups[rangeFrom[i]] ==
+                stbInfo->tblVgroups[rangeTo[i]]) {
+                pThreadInfo->vgroup = stbInfo->tblVgroups[rangeFrom[i]];
+            }
+        }
+        if (stbInfo->steal_chunk > 0) {
+            pThreadInfo->scheduler = &scheduler;
+        }
+        benchHistInit(&(pThreadInfo->delayHist), g_arguments->latency_max);
+        if (stbInfo->insert_rate > 0) {
+            benchHistInit(&(pThreadInfo->correctedDelayHist),
+                          g_arguments->latency_max);
+            // every thread paces an equal share of the target rate
+            pThreadInfo->rate_step_us =
+                1000000.0 * threads / (double)stbInfo->insert_rate;
+        }
         switch (stbInfo->iface) {
             case REST_IFACE: {
-                pThreadInfo->buffer = benchCalloc(1, MAX_SQL_LEN, false);
+                pThreadInfo->max_sql_len = calcInsertSqlLen(database, stbInfo);
+                pThreadInfo->buffer =
+                    benchCalloc(1, pThreadInfo->max_sql_len, false);
+                // the epoll engine opens its own connections
+                if (stbInfo->rest_connections > 0) {
+                    pThreadInfo->sockfd = -1;
+                    break;
+                }
 #ifdef WINDOWS
                 WSADATA wsaData;
                 WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -1419,10 +3316,10 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                 if (retConn < 0) {
                     errorPrint(stderr, "%s\n", "failed to connect");
 #ifdef WINDOWS
-                    closesocket(pThreadInfo->sockfd);
+                    closesocket(sockfd);
                     WSACleanup();
 #else
-                    close(pThreadInfo->sockfd);
+                    close(sockfd);
 #endif
                     return -1;
                 }
@@ -1430,7 +3327,7 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                 break;
             }
             case STMT_IFACE: {
-                pThreadInfo->taos = select_one_from_pool(database->dbName);
+                pThreadInfo->taos = select_thread_conn(i, 0, database->dbName);
                 pThreadInfo->stmt = taos_stmt_init(pThreadInfo->taos);
                 if (NULL == pThreadInfo->stmt) {
                     tmfree(pids);
@@ -1446,11 +3343,7 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                 }
 
                 pThreadInfo->bind_ts = benchCalloc(1, sizeof(int64_t), true);
-                pThreadInfo->bind_ts_array =
-                        benchCalloc(1, sizeof(int64_t) * g_arguments->reqPerReq, true);
-                pThreadInfo->bindParams = benchCalloc(
-                    1, sizeof(TAOS_MULTI_BIND) * (stbInfo->cols->size + 1), true);
-                pThreadInfo->is_null = benchCalloc(1, g_arguments->reqPerReq, true);
+                initStmtBind(pThreadInfo, stbInfo);
 
                 break;
             }
@@ -1479,10 +3372,10 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                 if (retConn < 0) {
                     errorPrint(stderr, "%s\n", "failed to connect");
 #ifdef WINDOWS
-                    closesocket(pThreadInfo->sockfd);
+                    closesocket(sockfd);
                     WSACleanup();
 #else
-                    close(pThreadInfo->sockfd);
+                    close(sockfd);
 #endif
                     free(pids);
                     free(infos);
@@ -1492,63 +3385,72 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
             }
             case SML_IFACE: {
                 if (stbInfo->iface == SML_IFACE) {
-                    pThreadInfo->taos = select_one_from_pool(database->dbName);
+                    pThreadInfo->taos =
+                        select_thread_conn(i, 0, database->dbName);
                 }
                 pThreadInfo->max_sql_len =
                     stbInfo->lenOfCols + stbInfo->lenOfTags;
-                if (stbInfo->iface == SML_REST_IFACE) {
-                    pThreadInfo->buffer =
-                            benchCalloc(1, g_arguments->reqPerReq *
-                                      (1 + pThreadInfo->max_sql_len), true);
-                }
                 if (stbInfo->lineProtocol != TSDB_SML_JSON_PROTOCOL) {
-                    pThreadInfo->sml_tags =
-                        (char **)benchCalloc(pThreadInfo->ntables, sizeof(char *), true);
-                    for (int t = 0; t < pThreadInfo->ntables; t++) {
-                        pThreadInfo->sml_tags[t] =
-                                benchCalloc(1, stbInfo->lenOfTags, true);
-                    }
-
+                    // tags are rendered once per table with the separator
+                    // the record needs: "stb,tagset " or " tagset"
+                    pThreadInfo->sml_tags = benchCalloc(
+                        pThreadInfo->ntables, sizeof(SRowFragment), true);
+                    bool telnet =
+                        stbInfo->lineProtocol == TSDB_SML_TELNET_PROTOCOL;
                     for (int t = 0; t < pThreadInfo->ntables; t++) {
-                        generateRandData(
-                            stbInfo, pThreadInfo->sml_tags[t],
-                            stbInfo->lenOfCols + stbInfo->lenOfTags,
-                            stbInfo->tags, 1, true);
-                        debugPrint(stdout, "pThreadInfo->sml_tags[%d]: %s\n", t,
-                                   pThreadInfo->sml_tags[t]);
+                        SRowFragment *tags = pThreadInfo->sml_tags + t;
+                        char *rendered = getChildTblTags(
+                            stbInfo, pThreadInfo->start_table_from + t);
+                        tags->len = (uint32_t)strlen(rendered);
+                        tags->data = benchCalloc(1, tags->len + 2, true);
+                        memcpy(tags->data + telnet, rendered, tags->len);
+                        if (telnet) {
+                            tags->data[0] = ' ';
+                        } else {
+                            tags->data[tags->len] = ' ';
+                        }
+                        tags->len++;
+                        debugPrint(stdout, "pThreadInfo->sml_tags[%d]: %s\n",
+                                   t, tags->data);
                     }
+                    // one append-only buffer holds the whole batch, lines[]
+                    // points at its records
+                    pThreadInfo->buffer = benchCalloc(
+                        1, g_arguments->reqPerReq *
+                               (pThreadInfo->max_sql_len + TIMESTAMP_BUFF_LEN +
+                                TSDB_TABLE_NAME_LEN + 8) + 1,
+                        true);
+                    pThreadInfo->sml_len = 0;
                     pThreadInfo->lines =
                             benchCalloc(g_arguments->reqPerReq, sizeof(char *), true);
-
-                    for (int j = 0; j < g_arguments->reqPerReq; j++) {
-                        pThreadInfo->lines[j] =
-                                benchCalloc(1, pThreadInfo->max_sql_len, true);
-                    }
                 } else {
-                    pThreadInfo->json_array = tools_cJSON_CreateArray();
-                    pThreadInfo->sml_json_tags = tools_cJSON_CreateArray();
+                    pThreadInfo->sml_json_tags = (char **)benchCalloc(
+                        pThreadInfo->ntables, sizeof(char *), true);
+                    uint64_t maxTagLen = 0;
                     for (int t = 0; t < pThreadInfo->ntables; t++) {
-                        generateSmlJsonTags(
-                                pThreadInfo->sml_json_tags, stbInfo,
-                                pThreadInfo->start_table_from, t);
+                        pThreadInfo->sml_json_tags[t] = generateSmlJsonTags(
+                                stbInfo, pThreadInfo->start_table_from, t);
+                        uint64_t tagLen = strlen(pThreadInfo->sml_json_tags[t]);
+                        if (tagLen > maxTagLen) {
+                            maxTagLen = tagLen;
+                        }
                     }
+                    // rows are streamed into one buffer sized for a full
+                    // request
+                    pThreadInfo->buffer = benchCalloc(
+                        1, g_arguments->reqPerReq *
+                               (maxTagLen + calcSmlJsonColLen(stbInfo) + 1) + 3,
+                        true);
+                    pThreadInfo->sml_len = 0;
                     pThreadInfo->lines = (char **)benchCalloc(1, sizeof(char *), true);
                 }
                 break;
             }
             case TAOSC_IFACE: {
-                pThreadInfo->taos = select_one_from_pool(database->dbName);
-                
-                if (stbInfo->interlaceRows > 0) {
-                    if (stbInfo->autoCreateTable) {
-                        pThreadInfo->max_sql_len = g_arguments->reqPerReq * (stbInfo->lenOfCols + stbInfo->lenOfTags) + 1024;
-                    } else {
-                        pThreadInfo->max_sql_len = g_arguments->reqPerReq * stbInfo->lenOfCols + 1024;
-                    }
-                    pThreadInfo->buffer = benchCalloc(1, pThreadInfo->max_sql_len, true);
-                } else {
-                    pThreadInfo->buffer = benchCalloc(1, MAX_SQL_LEN, true);
-                }
+                pThreadInfo->taos = select_thread_conn(i, 0, database->dbName);
+                pThreadInfo->max_sql_len = calcInsertSqlLen(database, stbInfo);
+                pThreadInfo->buffer =
+                    benchCalloc(1, pThreadInfo->max_sql_len, true);
 
                 break;
             }
@@ -1579,14 +3481,19 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
 
     int64_t end = toolsGetTimestampUs();
 
-    uint64_t  totalDelay = 0;
-    uint64_t  maxDelay = 0;
-    uint64_t  minDelay = UINT64_MAX;
-    uint64_t  cntDelay = 0;
-    uint64_t *total_delay_list;
-    double    avgDelay = 0;
+    SLatencyHist delayHist;
+    SLatencyHist correctedDelayHist;
     uint64_t  totalInsertRows = 0;
     uint64_t  totalAffectedRows = 0;
+    uint64_t  totalGenDelay = 0;
+    uint64_t  totalSendDelay = 0;
+    uint64_t  totalWorkTime = 0;
+    uint64_t  totalBodyBytes = 0;
+    uint64_t  totalWireBytes = 0;
+    uint64_t  totalCompressCpu = 0;
+
+    benchHistInit(&delayHist, g_arguments->latency_max);
+    benchHistInit(&correctedDelayHist, g_arguments->latency_max);
 
     for (int i = 0; i < threads; i++) {
         threadInfo *pThreadInfo = infos + i;
@@ -1596,34 +3503,44 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
                 closesocket(pThreadInfo->sockfd);
                 WSACleanup();
 #else
-                close(pThreadInfo->sockfd);
+                if (pThreadInfo->sockfd >= 0) {
+                    close(pThreadInfo->sockfd);
+                }
 #endif
+                freeHttpBuffers(pThreadInfo);
                 tmfree(pThreadInfo->buffer);
                 break;
             case SML_REST_IFACE:
+#ifdef WINDOWS
+                closesocket(pThreadInfo->sockfd);
+                WSACleanup();
+#else
+                close(pThreadInfo->sockfd);
+#endif
+                freeHttpBuffers(pThreadInfo);
                 tmfree(pThreadInfo->buffer);
             case SML_IFACE:
                 if (stbInfo->lineProtocol != TSDB_SML_JSON_PROTOCOL) {
                     for (int t = 0; t < pThreadInfo->ntables; t++) {
-                        tmfree(pThreadInfo->sml_tags[t]);
-                    }
-                    for (int j = 0; j < g_arguments->reqPerReq; j++) {
-                        tmfree(pThreadInfo->lines[j]);
+                        tmfree(pThreadInfo->sml_tags[t].data);
                     }
                     tmfree(pThreadInfo->sml_tags);
 
                 } else {
-                    tools_cJSON_Delete(pThreadInfo->sml_json_tags);
-                    tools_cJSON_Delete(pThreadInfo->json_array);
+                    for (int t = 0; t < pThreadInfo->ntables; t++) {
+                        tools_cJSON_free(pThreadInfo->sml_json_tags[t]);
+                    }
+                    tmfree(pThreadInfo->sml_json_tags);
+                }
+                if (stbInfo->iface == SML_IFACE) {
+                    tmfree(pThreadInfo->buffer);
                 }
                 tmfree(pThreadInfo->lines);
                 break;
             case STMT_IFACE:
                 taos_stmt_close(pThreadInfo->stmt);
                 tmfree(pThreadInfo->bind_ts);
-                tmfree(pThreadInfo->bind_ts_array);
-                tmfree(pThreadInfo->bindParams);
-                tmfree(pThreadInfo->is_null);
+                freeStmtBind(pThreadInfo);
                 break;
             case TAOSC_IFACE:
                 tmfree(pThreadInfo->buffer);
@@ -1633,38 +3550,45 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         }
         totalAffectedRows += pThreadInfo->totalAffectedRows;
         totalInsertRows += pThreadInfo->totalInsertRows;
-        totalDelay += pThreadInfo->totalDelay;
-        cntDelay += pThreadInfo->cntDelay;
-
-        if (pThreadInfo->maxDelay > maxDelay) {
-            maxDelay = pThreadInfo->maxDelay;
-        }
-
-        if (pThreadInfo->minDelay < minDelay) {
-            minDelay = pThreadInfo->minDelay;
+        totalGenDelay += pThreadInfo->totalGenDelay;
+        totalSendDelay += pThreadInfo->totalDelay;
+        totalWorkTime += pThreadInfo->et - pThreadInfo->st;
+        totalBodyBytes += pThreadInfo->bodyBytes;
+        totalWireBytes += pThreadInfo->wireBytes;
+        totalCompressCpu += pThreadInfo->compressCpuUs;
+        benchHistMerge(&delayHist, &(pThreadInfo->delayHist));
+        benchHistDestroy(&(pThreadInfo->delayHist));
+        benchHistMerge(&correctedDelayHist, &(pThreadInfo->correctedDelayHist));
+        benchHistDestroy(&(pThreadInfo->correctedDelayHist));
+    }
+
+    printThreadBalance(stdout, infos, threads, stbInfo->steal_chunk > 0);
+    if (g_arguments->fpOfInsertResult) {
+        printThreadBalance(g_arguments->fpOfInsertResult, infos, threads,
+                           stbInfo->steal_chunk > 0);
+    }
+    if (g_arguments->phase_timers) {
+        printPhaseReport(stdout, infos, threads);
+        if (g_arguments->fpOfInsertResult) {
+            printPhaseReport(g_arguments->fpOfInsertResult, infos, threads);
         }
     }
-
-    total_delay_list = benchCalloc(cntDelay, sizeof(uint64_t), false);
-    uint64_t index = 0;
-    for (int i = 0; i < threads; ++i) {
-        threadInfo *pThreadInfo = infos + i;
-        delayNode * node = pThreadInfo->delayList.head;
-        for (int j = 0; j < pThreadInfo->delayList.size; ++j) {
-            total_delay_list[index] = node->value;
-            node = node->next;
-            index++;
+    if (stbInfo->steal_chunk > 0) {
+        pthread_mutex_destroy(&scheduler.mutex);
+    }
+    if (stbInfo->vgroup_routing) {
+        printVgroupReport(stdout, infos, threads, end - start);
+        if (g_arguments->fpOfInsertResult) {
+            printVgroupReport(g_arguments->fpOfInsertResult, infos, threads,
+                              end - start);
         }
-        delay_list_destroy(&(pThreadInfo->delayList));
     }
-    qsort(total_delay_list, cntDelay, sizeof(uint64_t), compare);
 
+    tmfree(rangeFrom);
+    tmfree(rangeTo);
     free(pids);
     free(infos);
 
-    if (cntDelay == 0) cntDelay = 1;
-    avgDelay = (double)totalDelay / cntDelay;
-
     int64_t t = end - start;
     if (0 == t) t = 1;
 
@@ -1702,30 +3626,58 @@ static int startMultiThreadInsertData(int db_index, int stb_index) {
         }
     }
 
-    if (minDelay != UINT64_MAX) {
-        infoPrint(
-            stdout,
-            "insert delay, min: %5.2fms, avg: %5.2fms, p90: %5.2fms, p95: "
-            "%5.2fms, p99: %5.2fms, max: %5.2fms\n\n",
-            (double)minDelay / 1000.0, (double)avgDelay / 1000.0,
-            (double)total_delay_list[(int32_t)(cntDelay * 0.9)] / 1000.0,
-            (double)total_delay_list[(int32_t)(cntDelay * 0.95)] / 1000.0,
-            (double)total_delay_list[(int32_t)(cntDelay * 0.99)] / 1000.0,
-            (double)maxDelay / 1000.0);
-
+    benchHistPrint(stdout, "insert delay", &delayHist, 1000.0, "ms");
+    if (g_arguments->fpOfInsertResult) {
+        benchHistPrint(g_arguments->fpOfInsertResult, "insert delay",
+                       &delayHist, 1000.0, "ms");
+    }
+    // overlapping async requests make summed send time meaningless
+    if (stbInfo->async_inflight == 0 && stbInfo->rest_connections == 0) {
+        printGenerationReport(stdout, totalGenDelay, totalSendDelay,
+                              totalWorkTime);
+        if (g_arguments->fpOfInsertResult) {
+            printGenerationReport(g_arguments->fpOfInsertResult, totalGenDelay,
+                                  totalSendDelay, totalWorkTime);
+        }
+    }
+    if (totalBodyBytes > 0) {
+        printCompressionReport(stdout, totalBodyBytes, totalWireBytes,
+                               totalCompressCpu, tInMs);
+        if (g_arguments->fpOfInsertResult) {
+            printCompressionReport(g_arguments->fpOfInsertResult,
+                                   totalBodyBytes, totalWireBytes,
+                                   totalCompressCpu, tInMs);
+        }
+    }
+    char label[SQL_BUFF_LEN];
+    snprintf(label, sizeof(label), "insert %s.%s", database->dbName,
+             stbInfo->stbName);
+    if (benchHistDump(&delayHist, label)) {
+        g_fail = true;
+    }
+    benchAgentReport(database->dbName, stbInfo->stbName, totalInsertRows,
+                     totalAffectedRows, end - start, &delayHist);
+    if (stbInfo->insert_rate > 0) {
+        bool   byRows = stbInfo->insert_rate_unit == RATE_UNIT_ROWS;
+        double achieved =
+            (byRows ? (double)totalInsertRows : (double)delayHist.count) / tInMs;
+        printRateReport(stdout, stbInfo, achieved);
         if (g_arguments->fpOfInsertResult) {
-            fprintf(
-                g_arguments->fpOfInsertResult,
-                "insert delay, min: %5.2fms, avg: %5.2fms, p90: %5.2fms, p95: "
-                "%5.2fms, p99: %5.2fms, max: %5.2fms\n\n",
-                (double)minDelay / 1000.0, (double)avgDelay / 1000.0,
-                (double)total_delay_list[(int32_t)(cntDelay * 0.9)] / 1000.0,
-                (double)total_delay_list[(int32_t)(cntDelay * 0.95)] / 1000.0,
-                (double)total_delay_list[(int32_t)(cntDelay * 0.99)] / 1000.0,
-                (double)maxDelay / 1000.0);
-        }
-    }
-    tmfree(total_delay_list);
+            printRateReport(g_arguments->fpOfInsertResult, stbInfo, achieved);
+        }
+        printCorrectedDelay(stdout, &correctedDelayHist);
+        if (g_arguments->fpOfInsertResult) {
+            printCorrectedDelay(g_arguments->fpOfInsertResult,
+                                &correctedDelayHist);
+        }
+        snprintf(label, sizeof(label), "insert corrected %s.%s",
+                 database->dbName, stbInfo->stbName);
+        if (benchHistDump(&correctedDelayHist, label)) {
+            g_fail = true;
+        }
+    }
+    benchHistDestroy(&correctedDelayHist);
+    benchHistDestroy(&delayHist);
     if (g_fail) {
         return -1;
     }
@@ -1787,9 +3739,12 @@ int insertTestProcess() {
         }
     }
 
-    if (createChildTables()) return -1;
+    // agents find the tables already created by their controller
+    if (g_arguments->agent_count == 0) {
+        if (createChildTables()) return -1;
+    }
 
-    if (g_arguments->taosc_version == 3) {
+    if (g_arguments->taosc_version == 3 && g_arguments->agent_count == 0) {
         for (int i = 0; i < g_arguments->databases->size; ++i) {
             SDataBase * database = benchArrayGet(g_arguments->databases, i);
             for (int j = 0; j < database->streams->size; ++j) {
@@ -1803,12 +3758,19 @@ int insertTestProcess() {
         }
     }
 
+    if (g_arguments->agents) {
+        return benchControllerRun();
+    }
+    if (benchAgentReady()) {
+        return -1;
+    }
+
     // create sub threads for inserting data
     for (int i = 0; i < g_arguments->databases->size; i++) {
         SDataBase * database = benchArrayGet(g_arguments->databases, i);
         for (uint64_t j = 0; j < database->superTbls->size; j++) {
             SSuperTable * stbInfo = benchArrayGet(database->superTbls, j);
-            if (stbInfo->insertRows == 0) {
+            if (stbInfo->insertRows == 0 && stbInfo->replayFiles == NULL) {
                 continue;
             }
             prompt(stbInfo->non_stop);
@@ -15,6 +15,103 @@
 
 #include "bench.h"
 
+static double getGenParam(tools_cJSON *genObj, const char *key, double dflt) {
+    tools_cJSON *param = tools_cJSON_GetObjectItem(genObj, key);
+    if (tools_cJSON_IsNumber(param)) {
+        return param->valuedouble;
+    }
+    return dflt;
+}
+
+// a row count such as a period, dflt when absent, -1 when not positive
+static int getGenPeriod(tools_cJSON *genObj, const char *key, uint64_t dflt,
+                        uint64_t *period) {
+    tools_cJSON *param = tools_cJSON_GetObjectItem(genObj, key);
+    if (param == NULL) {
+        *period = dflt;
+        return 0;
+    }
+    if (!tools_cJSON_IsNumber(param) || param->valuedouble < 1) {
+        errorPrint(stderr, "Invalid value for column gen '%s', it must be a "
+                   "positive number of rows\n", key);
+        return -1;
+    }
+    *period = (uint64_t)param->valuedouble;
+    return 0;
+}
+
+// "gen": {"type": "random_walk|sine|counter|step|zipf", ...} and
+// "null_ratio" on a column, *gen stays NULL when neither is given
+static int getColumnGenInfo(tools_cJSON *column, int64_t min, int64_t max,
+                            SColumnGen **gen) {
+    SColumnGen   spec = {0};
+    bool         found = false;
+    double       mid = ((double)min + (double)max) / 2;
+    double       range = (double)max - (double)min;
+    tools_cJSON *genObj = tools_cJSON_GetObjectItem(column, "gen");
+    if (genObj && !tools_cJSON_IsObject(genObj)) {
+        errorPrint(stderr, "%s", "column gen must be an object\n");
+        return -1;
+    }
+    if (genObj) {
+        tools_cJSON *genType = tools_cJSON_GetObjectItem(genObj, "type");
+        if (!tools_cJSON_IsString(genType)) {
+            errorPrint(stderr, "%s", "column gen requires a type\n");
+            return -1;
+        }
+        if (0 == strcasecmp(genType->valuestring, "random_walk")) {
+            spec.kind = COLUMN_GEN_RANDOM_WALK;
+            spec.start = getGenParam(genObj, "start", mid);
+            spec.step = getGenParam(genObj, "step", range / 100);
+        } else if (0 == strcasecmp(genType->valuestring, "sine")) {
+            spec.kind = COLUMN_GEN_SINE;
+            spec.start = getGenParam(genObj, "base", mid);
+            spec.amplitude = getGenParam(genObj, "amplitude", range / 4);
+            if (getGenPeriod(genObj, "period", 1000, &spec.period)) {
+                return -1;
+            }
+            spec.noise = getGenParam(genObj, "noise", 0);
+        } else if (0 == strcasecmp(genType->valuestring, "counter")) {
+            spec.kind = COLUMN_GEN_COUNTER;
+            spec.start = getGenParam(genObj, "start", (double)min);
+            spec.step = getGenParam(genObj, "step", 1);
+            if (getGenPeriod(genObj, "reset", 0, &spec.period)) {
+                return -1;
+            }
+        } else if (0 == strcasecmp(genType->valuestring, "step")) {
+            spec.kind = COLUMN_GEN_STEP;
+            spec.start = (double)min;
+            spec.amplitude = range;
+            if (getGenPeriod(genObj, "period", 100, &spec.period)) {
+                return -1;
+            }
+        } else if (0 == strcasecmp(genType->valuestring, "zipf")) {
+            spec.kind = COLUMN_GEN_ZIPF;
+            spec.skew = getGenParam(genObj, "skew", 1.0);
+        } else {
+            errorPrint(stderr, "Invalid column gen type: %s\n",
+                       genType->valuestring);
+            return -1;
+        }
+        found = true;
+    }
+    tools_cJSON *nullRatio = tools_cJSON_GetObjectItem(column, "null_ratio");
+    if (tools_cJSON_IsNumber(nullRatio)) {
+        if (nullRatio->valuedouble < 0 || nullRatio->valuedouble > 1) {
+            errorPrint(stderr, "Invalid value for 'null_ratio': %f\n",
+                       nullRatio->valuedouble);
+            return -1;
+        }
+        spec.nullRatio = nullRatio->valuedouble;
+        found = found || spec.nullRatio > 0;
+    }
+    if (found) {
+        *gen = benchCalloc(1, sizeof(SColumnGen), false);
+        memcpy(*gen, &spec, sizeof(SColumnGen));
+    }
+    return 0;
+}
+
 static int getColumnAndTagTypeFromInsertJsonFile(tools_cJSON * superTblObj, SSuperTable *stbInfo) {
     int32_t code = -1;
 
@@ -77,6 +174,11 @@ static int getColumnAndTagTypeFromInsertJsonFile(tools_cJSON * superTblObj, SSup
 
         tools_cJSON *dataValues = tools_cJSON_GetObjectItem(column, "values");
 
+        SColumnGen *gen = NULL;
+        if (getColumnGenInfo(column, min, max, &gen)) {
+            goto PARSE_OVER;
+        }
+
         if (g_arguments->taosc_version == 3) {
             tools_cJSON *sma_value = tools_cJSON_GetObjectItem(column, "sma");
             if (tools_cJSON_IsString(sma_value) &&
@@ -109,6 +211,11 @@ static int getColumnAndTagTypeFromInsertJsonFile(tools_cJSON * superTblObj, SSup
             col->max = max;
             col->min = min;
             col->values = dataValues;
+            if (gen) {
+                col->gen = benchCalloc(1, sizeof(SColumnGen), true);
+                memcpy(col->gen, gen, sizeof(SColumnGen));
+                stbInfo->columnGen = true;
+            }
             if (customName) {
                 if (n >= 1) {
                     sprintf(col->name, "%s_%d", dataName->valuestring, n);
@@ -120,6 +227,7 @@ static int getColumnAndTagTypeFromInsertJsonFile(tools_cJSON * superTblObj, SSup
             }
             index++;
         }
+        tmfree(gen);
     }
 
     index = 0;
@@ -377,6 +485,136 @@ static int getDatabaseInfo(tools_cJSON *dbinfos, int index) {
     return 0;
 }
 
+static int getInsertRateInfo(tools_cJSON *json, uint64_t *rate, uint8_t *unit) {
+    tools_cJSON *insertRate = tools_cJSON_GetObjectItem(json, "insert_rate");
+    if (tools_cJSON_IsNumber(insertRate)) {
+        if (insertRate->valueint < 0) {
+            errorPrint(stderr, "Invalid value for 'insert_rate': %" PRId64 "\n",
+                       (int64_t)insertRate->valueint);
+            return -1;
+        }
+        *rate = insertRate->valueint;
+    }
+    tools_cJSON *rateUnit = tools_cJSON_GetObjectItem(json, "insert_rate_unit");
+    if (tools_cJSON_IsString(rateUnit)) {
+        if (0 == strcasecmp(rateUnit->valuestring, "rows")) {
+            *unit = RATE_UNIT_ROWS;
+        } else if (0 == strcasecmp(rateUnit->valuestring, "requests")) {
+            *unit = RATE_UNIT_REQUESTS;
+        } else {
+            errorPrint(stderr, "Invalid value for 'insert_rate_unit': %s\n",
+                       rateUnit->valuestring);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int getLatencyInfo(tools_cJSON *json) {
+    tools_cJSON *latencyMax = tools_cJSON_GetObjectItem(json, "latency_max_ms");
+    if (tools_cJSON_IsNumber(latencyMax)) {
+        if (latencyMax->valueint <= 0) {
+            errorPrint(stderr,
+                       "Invalid value for 'latency_max_ms': %" PRId64 "\n",
+                       (int64_t)latencyMax->valueint);
+            return -1;
+        }
+        g_arguments->latency_max = (uint64_t)latencyMax->valueint * 1000;
+    }
+    tools_cJSON *dumpFile = tools_cJSON_GetObjectItem(json, "latency_dump_file");
+    if (tools_cJSON_IsString(dumpFile)) {
+        g_arguments->latency_dump_file = dumpFile->valuestring;
+    }
+    return 0;
+}
+
+static int getRestCompression(tools_cJSON *json) {
+    tools_cJSON *compression =
+        tools_cJSON_GetObjectItem(json, "rest_compression");
+    if (tools_cJSON_IsString(compression)) {
+        if (0 == strcasecmp(compression->valuestring, "none")) {
+            g_arguments->rest_compression = REST_COMPRESS_NONE;
+        } else if (0 == strcasecmp(compression->valuestring, "gzip")) {
+            g_arguments->rest_compression = REST_COMPRESS_GZIP;
+        } else if (0 == strcasecmp(compression->valuestring, "deflate")) {
+            g_arguments->rest_compression = REST_COMPRESS_DEFLATE;
+        } else {
+            errorPrint(stderr, "Invalid value for 'rest_compression': %s\n",
+                       compression->valuestring);
+            return -1;
+        }
+    }
+    tools_cJSON *level =
+        tools_cJSON_GetObjectItem(json, "rest_compression_level");
+    if (tools_cJSON_IsNumber(level)) {
+        if (level->valueint < 0 || level->valueint > 9) {
+            errorPrint(stderr,
+                       "Invalid value for 'rest_compression_level': %" PRId64
+                       "\n",
+                       (int64_t)level->valueint);
+            return -1;
+        }
+        g_arguments->rest_compression_level = (int32_t)level->valueint;
+    }
+#ifndef DEFLATE_CODEC
+    if (g_arguments->rest_compression != REST_COMPRESS_NONE) {
+        infoPrint(stdout, "%s",
+                  "built without zlib, rest_compression is ignored\n");
+        g_arguments->rest_compression = REST_COMPRESS_NONE;
+    }
+#endif
+    return 0;
+}
+
+static int getStatsInfo(tools_cJSON *json) {
+    tools_cJSON *interval = tools_cJSON_GetObjectItem(json, "stats_interval_ms");
+    if (tools_cJSON_IsNumber(interval)) {
+        if (interval->valueint < 0) {
+            errorPrint(stderr,
+                       "Invalid value for 'stats_interval_ms': %" PRId64 "\n",
+                       (int64_t)interval->valueint);
+            return -1;
+        }
+        g_arguments->stats_interval_ms = (uint32_t)interval->valueint;
+    }
+    tools_cJSON *statsFile = tools_cJSON_GetObjectItem(json, "stats_file");
+    if (tools_cJSON_IsString(statsFile)) {
+        g_arguments->stats_file = statsFile->valuestring;
+    }
+    tools_cJSON *format = tools_cJSON_GetObjectItem(json, "stats_format");
+    if (tools_cJSON_IsString(format)) {
+        if (0 == strcasecmp(format->valuestring, "csv")) {
+            g_arguments->stats_format = STATS_FORMAT_CSV;
+        } else if (0 == strcasecmp(format->valuestring, "jsonl")) {
+            g_arguments->stats_format = STATS_FORMAT_JSONL;
+        } else {
+            errorPrint(stderr, "Invalid value for 'stats_format': %s\n",
+                       format->valuestring);
+            return -1;
+        }
+    }
+    if (g_arguments->stats_interval_ms > 0 &&
+        g_arguments->stats_file == NULL) {
+        infoPrint(stdout, "%s",
+                  "stats_interval_ms is ignored without stats_file\n");
+    }
+    tools_cJSON *port = tools_cJSON_GetObjectItem(json, "metrics_port");
+    if (tools_cJSON_IsNumber(port)) {
+        if (port->valueint < 0 || port->valueint > 65535) {
+            errorPrint(stderr,
+                       "Invalid value for 'metrics_port': %" PRId64 "\n",
+                       (int64_t)port->valueint);
+            return -1;
+        }
+        g_arguments->metrics_port = (uint16_t)port->valueint;
+    }
+    tools_cJSON *host = tools_cJSON_GetObjectItem(json, "metrics_host");
+    if (tools_cJSON_IsString(host)) {
+        g_arguments->metrics_host = host->valuestring;
+    }
+    return 0;
+}
+
 static int getStableInfo(tools_cJSON *dbinfos, int index) {
     SDataBase *database = benchArrayGet(g_arguments->databases, index);
     tools_cJSON *    dbinfo = tools_cJSON_GetArrayItem(dbinfos, index);
@@ -400,6 +638,10 @@ static int getStableInfo(tools_cJSON *dbinfos, int index) {
         superTable->autoCreateTable = false;
         superTable->no_check_for_affected_rows = false;
         superTable->batchCreateTableNum = DEFAULT_CREATE_BATCH;
+        superTable->create_table_inflight = 0;
+        superTable->create_table_batch_bytes = 0;
+        superTable->create_table_target_ms = 0;
+        superTable->vgroup_routing = false;
         superTable->childTblExists = false;
         superTable->random_data_source = true;
         superTable->iface = TAOSC_IFACE;
@@ -414,6 +656,18 @@ static int getStableInfo(tools_cJSON *dbinfos, int index) {
         superTable->disorderRatio = 0;
         superTable->disorderRange = DEFAULT_DISORDER_RANGE;
         superTable->insert_interval = g_arguments->insert_interval;
+        superTable->insert_rate = g_arguments->insert_rate;
+        superTable->insert_rate_unit = g_arguments->insert_rate_unit;
+        superTable->async_inflight = g_arguments->async_inflight;
+        superTable->pipeline_buffers = g_arguments->pipeline_buffers;
+        superTable->rest_connections = g_arguments->rest_connections;
+        superTable->steal_chunk = g_arguments->steal_chunk;
+        superTable->replayFiles = NULL;
+        superTable->replayPartitionCol = -1;
+        superTable->replayByTag = false;
+        superTable->replayShiftTs = false;
+        superTable->replaySpeed = 0;
+        superTable->replayQueue = DEFAULT_REPLAY_QUEUE;
         superTable->partialColumnNum = 0;
         superTable->comment = NULL;
         superTable->delay = -1;
@@ -444,6 +698,30 @@ static int getStableInfo(tools_cJSON *dbinfos, int index) {
         if (tools_cJSON_IsNumber(batchCreateTbl)) {
             superTable->batchCreateTableNum = batchCreateTbl->valueint;
         }
+        tools_cJSON *vgroupRouting =
+            tools_cJSON_GetObjectItem(stbInfo, "vgroup_routing");
+        if (tools_cJSON_IsString(vgroupRouting) &&
+            (0 == strcasecmp(vgroupRouting->valuestring, "yes"))) {
+            superTable->vgroup_routing = true;
+        }
+        tools_cJSON *createInflight =
+            tools_cJSON_GetObjectItem(stbInfo, "create_table_inflight");
+        if (tools_cJSON_IsNumber(createInflight)) {
+            superTable->create_table_inflight =
+                (uint32_t)createInflight->valueint;
+        }
+        tools_cJSON *createBytes =
+            tools_cJSON_GetObjectItem(stbInfo, "create_table_batch_bytes");
+        if (tools_cJSON_IsNumber(createBytes)) {
+            superTable->create_table_batch_bytes =
+                (uint32_t)createBytes->valueint;
+        }
+        tools_cJSON *createTarget =
+            tools_cJSON_GetObjectItem(stbInfo, "create_table_target_ms");
+        if (tools_cJSON_IsNumber(createTarget)) {
+            superTable->create_table_target_ms =
+                (uint32_t)createTarget->valueint;
+        }
         tools_cJSON *childTblExists =
             tools_cJSON_GetObjectItem(stbInfo, "child_table_exists");
         if (tools_cJSON_IsString(childTblExists) &&
@@ -601,6 +879,69 @@ static int getStableInfo(tools_cJSON *dbinfos, int index) {
         if (tools_cJSON_IsNumber(insertInterval)) {
             superTable->insert_interval = insertInterval->valueint;
         }
+        if (getInsertRateInfo(stbInfo, &superTable->insert_rate,
+                              &superTable->insert_rate_unit)) {
+            return -1;
+        }
+        tools_cJSON *asyncInflight = tools_cJSON_GetObjectItem(stbInfo, "async_inflight");
+        if (tools_cJSON_IsNumber(asyncInflight)) {
+            superTable->async_inflight = (uint32_t)asyncInflight->valueint;
+        }
+        tools_cJSON *pipelineBuffers = tools_cJSON_GetObjectItem(stbInfo, "pipeline_buffers");
+        if (tools_cJSON_IsNumber(pipelineBuffers)) {
+            superTable->pipeline_buffers = (uint32_t)pipelineBuffers->valueint;
+        }
+        tools_cJSON *restConnections = tools_cJSON_GetObjectItem(stbInfo, "rest_connections");
+        if (tools_cJSON_IsNumber(restConnections)) {
+            superTable->rest_connections = (uint32_t)restConnections->valueint;
+        }
+        tools_cJSON *stealChunk = tools_cJSON_GetObjectItem(stbInfo, "steal_chunk");
+        if (tools_cJSON_IsNumber(stealChunk)) {
+            superTable->steal_chunk = (uint32_t)stealChunk->valueint;
+        }
+        tools_cJSON *replayFiles = tools_cJSON_GetObjectItem(stbInfo, "replay_files");
+        if (tools_cJSON_IsString(replayFiles)) {
+            superTable->replayFiles = benchArrayInit(1, sizeof(char *));
+            char **name = benchCalloc(1, sizeof(char *), true);
+            *name = replayFiles->valuestring;
+            benchArrayPush(superTable->replayFiles, name);
+        } else if (tools_cJSON_IsArray(replayFiles)) {
+            int fileCount = tools_cJSON_GetArraySize(replayFiles);
+            superTable->replayFiles = benchArrayInit(fileCount, sizeof(char *));
+            for (int k = 0; k < fileCount; k++) {
+                tools_cJSON *file = tools_cJSON_GetArrayItem(replayFiles, k);
+                if (!tools_cJSON_IsString(file)) {
+                    errorPrint(stderr, "%s",
+                               "replay_files must be a list of file names\n");
+                    return -1;
+                }
+                char **name = benchCalloc(1, sizeof(char *), true);
+                *name = file->valuestring;
+                benchArrayPush(superTable->replayFiles, name);
+            }
+        }
+        tools_cJSON *partitionCol = tools_cJSON_GetObjectItem(stbInfo, "replay_partition_col");
+        if (tools_cJSON_IsNumber(partitionCol)) {
+            superTable->replayPartitionCol = (int32_t)partitionCol->valueint;
+        }
+        tools_cJSON *partitionBy = tools_cJSON_GetObjectItem(stbInfo, "replay_partition_by");
+        if (tools_cJSON_IsString(partitionBy) &&
+            (0 == strcasecmp(partitionBy->valuestring, "tag"))) {
+            superTable->replayByTag = true;
+        }
+        tools_cJSON *replayTs = tools_cJSON_GetObjectItem(stbInfo, "replay_timestamp");
+        if (tools_cJSON_IsString(replayTs) &&
+            (0 == strcasecmp(replayTs->valuestring, "now"))) {
+            superTable->replayShiftTs = true;
+        }
+        tools_cJSON *replaySpeed = tools_cJSON_GetObjectItem(stbInfo, "replay_speed");
+        if (tools_cJSON_IsNumber(replaySpeed) && replaySpeed->valuedouble > 0) {
+            superTable->replaySpeed = replaySpeed->valuedouble;
+        }
+        tools_cJSON *replayQueue = tools_cJSON_GetObjectItem(stbInfo, "replay_queue");
+        if (tools_cJSON_IsNumber(replayQueue) && replayQueue->valueint > 0) {
+            superTable->replayQueue = (uint32_t)replayQueue->valueint;
+        }
         tools_cJSON *pCoumnNum = tools_cJSON_GetObjectItem(stbInfo, "partial_col_num");
         if (tools_cJSON_IsNumber(pCoumnNum)) {
             superTable->partialColumnNum = pCoumnNum->valueint;
@@ -622,6 +963,16 @@ static int getStableInfo(tools_cJSON *dbinfos, int index) {
         if (getColumnAndTagTypeFromInsertJsonFile(stbInfo, superTable)) {
             return -1;
         }
+        // stmt binds and schemaless lines reuse prepared rows for every
+        // table, they cannot follow per-table generators
+        if (superTable->columnGen && superTable->iface != TAOSC_IFACE &&
+            superTable->iface != REST_IFACE) {
+            errorPrint(stderr,
+                       "column gen and null_ratio of stable<%s> only apply "
+                       "to taosc and rest insertion\n",
+                       superTable->stbName);
+            return -1;
+        }
     }
     return 0;
 }
@@ -725,6 +1076,13 @@ static int getMetaFromInsertJsonFile(tools_cJSON *json) {
         g_arguments->connection_pool = (uint32_t)threadspool->valueint;
     }
 
+    tools_cJSON *connPerThread =
+        tools_cJSON_GetObjectItem(json, "connections_per_thread");
+    if (tools_cJSON_IsNumber(connPerThread)) {
+        g_arguments->connections_per_thread =
+            (uint32_t)connPerThread->valueint;
+    }
+
     if (init_taos_list()) goto PARSE_OVER;
 
     tools_cJSON *numRecPerReq = tools_cJSON_GetObjectItem(json, "num_of_records_per_req");
@@ -738,6 +1096,16 @@ static int getMetaFromInsertJsonFile(tools_cJSON *json) {
         g_arguments->prepared_rand = prepareRand->valueint;
     }
 
+    tools_cJSON *randomSeed = tools_cJSON_GetObjectItem(json, "random_seed");
+    if (randomSeed && randomSeed->type == tools_cJSON_Number) {
+        if (randomSeed->valueint < 0) {
+            errorPrint(stderr, "Invalid value for 'random_seed': %" PRId64 "\n",
+                       (int64_t)randomSeed->valueint);
+            goto PARSE_OVER;
+        }
+        g_arguments->random_seed = (uint64_t)randomSeed->valueint;
+    }
+
     tools_cJSON *chineseOpt = tools_cJSON_GetObjectItem(json, "chinese");  // yes, no,
     if (chineseOpt && chineseOpt->type == tools_cJSON_String &&
         chineseOpt->valuestring != NULL) {
@@ -751,6 +1119,77 @@ static int getMetaFromInsertJsonFile(tools_cJSON *json) {
         g_arguments->insert_interval = top_insertInterval->valueint;
     }
 
+    if (getInsertRateInfo(json, &g_arguments->insert_rate,
+                          &g_arguments->insert_rate_unit)) {
+        goto PARSE_OVER;
+    }
+
+    tools_cJSON *asyncInflight = tools_cJSON_GetObjectItem(json, "async_inflight");
+    if (tools_cJSON_IsNumber(asyncInflight)) {
+        g_arguments->async_inflight = (uint32_t)asyncInflight->valueint;
+    }
+
+    tools_cJSON *pipelineBuffers = tools_cJSON_GetObjectItem(json, "pipeline_buffers");
+    if (tools_cJSON_IsNumber(pipelineBuffers)) {
+        g_arguments->pipeline_buffers = (uint32_t)pipelineBuffers->valueint;
+    }
+
+    tools_cJSON *stealChunk = tools_cJSON_GetObjectItem(json, "steal_chunk");
+    if (tools_cJSON_IsNumber(stealChunk)) {
+        g_arguments->steal_chunk = (uint32_t)stealChunk->valueint;
+    }
+
+    tools_cJSON *restConnections = tools_cJSON_GetObjectItem(json, "rest_connections");
+    if (tools_cJSON_IsNumber(restConnections)) {
+        g_arguments->rest_connections = (uint32_t)restConnections->valueint;
+    }
+
+    tools_cJSON *agents = tools_cJSON_GetObjectItem(json, "agents");
+    if (tools_cJSON_IsArray(agents) && tools_cJSON_GetArraySize(agents) > 0) {
+        int agentCount = tools_cJSON_GetArraySize(agents);
+        g_arguments->agents = benchArrayInit(agentCount, sizeof(char *));
+        for (int i = 0; i < agentCount; i++) {
+            tools_cJSON *agent = tools_cJSON_GetArrayItem(agents, i);
+            if (!tools_cJSON_IsString(agent) ||
+                strchr(agent->valuestring, ':') == NULL) {
+                errorPrint(stderr, "%s",
+                           "agents must be a list of \"host:port\"\n");
+                goto PARSE_OVER;
+            }
+            char **addr = benchCalloc(1, sizeof(char *), true);
+            *addr = agent->valuestring;
+            benchArrayPush(g_arguments->agents, addr);
+        }
+    }
+
+    if (getRestCompression(json)) {
+        goto PARSE_OVER;
+    }
+
+    tools_cJSON *tagCache = tools_cJSON_GetObjectItem(json, "tag_cache");
+    if (tools_cJSON_IsNumber(tagCache)) {
+        if (tagCache->valueint < 0) {
+            errorPrint(stderr, "Invalid value for 'tag_cache': %" PRId64 "\n",
+                       (int64_t)tagCache->valueint);
+            goto PARSE_OVER;
+        }
+        g_arguments->tag_cache = (uint32_t)tagCache->valueint;
+    }
+
+    tools_cJSON *phaseTimers = tools_cJSON_GetObjectItem(json, "phase_timers");
+    if (tools_cJSON_IsString(phaseTimers) &&
+        (0 == strcasecmp(phaseTimers->valuestring, "yes"))) {
+        g_arguments->phase_timers = true;
+    }
+
+    if (getLatencyInfo(json)) {
+        goto PARSE_OVER;
+    }
+
+    if (getStatsInfo(json)) {
+        goto PARSE_OVER;
+    }
+
     tools_cJSON *answerPrompt =
         tools_cJSON_GetObjectItem(json, "confirm_parameter_prompt");  // yes, no,
     if (answerPrompt && answerPrompt->type == tools_cJSON_String &&
@@ -857,6 +1296,19 @@ static int getMetaFromQueryJsonFile(tools_cJSON *json) {
         g_queryInfo.response_buffer = RESP_BUF_LEN;
     }
 
+    tools_cJSON *restConnections = tools_cJSON_GetObjectItem(json, "rest_connections");
+    if (tools_cJSON_IsNumber(restConnections)) {
+        g_arguments->rest_connections = (uint32_t)restConnections->valueint;
+    }
+
+    if (getLatencyInfo(json)) {
+        goto PARSE_OVER;
+    }
+
+    if (getStatsInfo(json)) {
+        goto PARSE_OVER;
+    }
+
     tools_cJSON *dbs = tools_cJSON_GetObjectItem(json, "databases");
     if (tools_cJSON_IsString(dbs)) {
         dataBase->dbName = dbs->valuestring;
@@ -964,8 +1416,6 @@ static int getMetaFromQueryJsonFile(tools_cJSON *json) {
                 benchArrayPush(g_queryInfo.specifiedQueryInfo.sqls, sql);
                 sql = benchArrayGet(g_queryInfo.specifiedQueryInfo.sqls, g_queryInfo.specifiedQueryInfo.sqls->size - 1);
                 sql->command = benchCalloc(1, strlen(buf), true);
-                sql->delay_list = benchCalloc(g_queryInfo.specifiedQueryInfo.queryTimes *
-                        g_queryInfo.specifiedQueryInfo.concurrent, sizeof(int64_t), true);
                 tstrncpy(sql->command, buf, strlen(buf));
                 debugPrint(stdout, "read file buffer: %s\n", sql->command);
                 memset(buf, 0, BUFFER_SIZE);
@@ -992,9 +1442,6 @@ static int getMetaFromQueryJsonFile(tools_cJSON *json) {
                     SSQL * sql = benchCalloc(1, sizeof(SSQL), true);
                     benchArrayPush(g_queryInfo.specifiedQueryInfo.sqls, sql);
                     sql = benchArrayGet(g_queryInfo.specifiedQueryInfo.sqls, g_queryInfo.specifiedQueryInfo.sqls->size -1);
-                    sql->delay_list = benchCalloc(g_queryInfo.specifiedQueryInfo.queryTimes *
-                        g_queryInfo.specifiedQueryInfo.concurrent, sizeof(int64_t), true);
-                    
                     tools_cJSON *sqlStr = tools_cJSON_GetObjectItem(sqlObj, "sql");
                     if (tools_cJSON_IsString(sqlStr)) {
                         sql->command = benchCalloc(1, strlen(sqlStr->valuestring) + 1, true);
@@ -1208,15 +1655,25 @@ int getInfoFromJsonFile() {
     }
 
     content[len] = 0;
+    code = getInfoFromJsonContent(content, file);
+PARSE_OVER:
+    free(content);
+    fclose(fp);
+    return code;
+}
+
+// name only labels the messages, agents get the content from the controller
+int getInfoFromJsonContent(char *content, const char *name) {
+    int32_t code = -1;
     root = tools_cJSON_Parse(content);
     if (root == NULL) {
         errorPrint(stderr, "failed to cjson parse %s, invalid json format\n",
-                   file);
-        goto PARSE_OVER;
+                   name);
+        return code;
     }
 
     char *pstr = tools_cJSON_Print(root);
-    infoPrint(stdout, "%s\n%s\n", file, pstr);
+    infoPrint(stdout, "%s\n%s\n", name, pstr);
     tmfree(pstr);
 
     tools_cJSON *filetype = tools_cJSON_GetObjectItem(root, "filetype");
@@ -1230,7 +1687,7 @@ int getInfoFromJsonFile() {
         } else {
             errorPrint(stderr, "%s",
                        "failed to read json, filetype not support\n");
-            goto PARSE_OVER;
+            return code;
         }
     } else {
         g_arguments->test_mode = INSERT_TEST;
@@ -1242,8 +1699,5 @@ int getInfoFromJsonFile() {
         memset(&g_queryInfo, 0, sizeof(SQueryMetaInfo));
         code = getMetaFromQueryJsonFile(root);
     }
-PARSE_OVER:
-    free(content);
-    fclose(fp);
     return code;
 }
@@ -48,12 +48,16 @@ int main(int argc, char* argv[]) {
     benchSetSignal(SIGINT, benchQueryInterruptHandler);
 #endif
     commandLineParseArgument(argc, argv);
-    if (g_arguments->metaFile) {
+    if (g_arguments->agent_listen) {
+        // the configuration comes from the controller
+        if (benchAgentAccept()) exit(EXIT_FAILURE);
+    } else if (g_arguments->metaFile) {
         g_arguments->g_totalChildTables = 0;
         if (getInfoFromJsonFile()) exit(EXIT_FAILURE);
     } else {
         modify_argument();
     }
+    benchRandInit();
 
     g_arguments->fpOfInsertResult = fopen(g_arguments->output_file, "a");
     if (NULL == g_arguments->fpOfInsertResult) {
@@ -61,8 +65,13 @@ int main(int argc, char* argv[]) {
                    g_arguments->output_file);
     }
     infoPrint(stdout, "taos client version: %s\n", taos_get_client_info());
+    if (benchStatsStart()) exit(EXIT_FAILURE);
+    if (benchMetricsStart()) exit(EXIT_FAILURE);
     if (g_arguments->test_mode == INSERT_TEST) {
-        if (insertTestProcess()) exit(EXIT_FAILURE);
+        if (insertTestProcess()) {
+            benchAgentFinish(true);
+            exit(EXIT_FAILURE);
+        }
     } else if (g_arguments->test_mode == QUERY_TEST) {
         if (queryTestProcess(g_arguments)) {
             exit(EXIT_FAILURE);
@@ -73,6 +82,9 @@ int main(int argc, char* argv[]) {
     if (g_arguments->aggr_func) {
         queryAggrFunc(g_arguments, g_arguments->pool);
     }
+    benchMetricsStop();
+    benchStatsStop();
+    benchAgentFinish(false);
     postFreeResource();
     return 0;
 }
\ No newline at end of file
@@ -85,6 +85,12 @@ static struct argp_option options[] = {
      "Random data source size, default is 10000."},
     {"connection_pool", 'H', "NUMBER", 0,
      "size of the pre-connected client in connection pool, default is 8"},
+    {"random-seed", 'e', "NUMBER", 0,
+     "Seed of the random data generator, default is derived from the clock."},
+    {"agent", 'K', "[HOST:]PORT", 0,
+     "Run as an agent of a distributed insert, wait on PORT for a controller "
+     "to send the JSON configuration and this agent's share of the tables. "
+     "HOST defaults to 127.0.0.1, the controller is not authenticated."},
     {0}};
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
@@ -101,10 +107,22 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         arguments->prepared_rand = DEFAULT_PREPARED_RAND;
       }
       break;
+    case 'e':
+      arguments->random_seed = strtoull(arg, NULL, 10);
+      if (arguments->random_seed == 0) {
+        errorPrint(stderr,
+                   "Invalid -e: %s, will derive the seed from the clock\n",
+                   arg);
+      }
+      break;
     case 'f':
       arguments->demo_mode = false;
       arguments->metaFile = arg;
       break;
+    case 'K':
+      arguments->demo_mode = false;
+      arguments->agent_listen = arg;
+      break;
     case 'h':
       arguments->host = arg;
       break;
@@ -27,11 +27,12 @@ int selectAndGetResult(threadInfo *pThreadInfo, char *command) {
         }
     } else {
         TAOS_RES *res = taos_query(pThreadInfo->taos, command);
-        if (res == NULL || taos_errno(res) != 0) {
+        int32_t   code = res ? taos_errno(res) : -1;
+        if (code != 0) {
             errorPrint(stderr, "failed to execute sql:%s, reason:%s\n", command,
                        taos_errstr(res));
             taos_free_result(res);
-            return -1;
+            return code;
         }
 
         fetchResult(res, pThreadInfo);
@@ -40,20 +41,55 @@ int selectAndGetResult(threadInfo *pThreadInfo, char *command) {
     return 0;
 }
 
+#ifdef LINUX
+static void restQueryDone(void *param, int32_t code, int64_t startTs,
+                          int64_t endTs) {
+    threadInfo *pThreadInfo = (threadInfo *)param;
+    if (code != 0) {
+        errorPrint(stderr, "====restful return fail, threadID[%d]\n",
+                   pThreadInfo->threadID);
+        g_fail = true;
+    }
+    benchHistRecord(&pThreadInfo->delayHist, endTs - startTs);
+    pThreadInfo->totalQueried++;
+    benchStatsInflight(pThreadInfo->stats, -1);
+    benchStatsRecord(pThreadInfo->stats, 0, 0, endTs - startTs, code != 0);
+    benchMetricsRecord(pThreadInfo->metrics, 0, 0, endTs - startTs, code);
+}
+
+// keep rest_connections queries in flight from one thread through the epoll
+// engine, completions are recorded on the engine's loop thread
+static void specifiedTableRestQuery(threadInfo *pThreadInfo, SSQL *sql,
+                                    uint64_t queryTimes) {
+    SRestEngine *engine = restEngineCreate(
+        pThreadInfo, g_arguments->rest_connections, restQueryDone);
+    if (engine == NULL) {
+        g_fail = true;
+        return;
+    }
+    for (uint64_t i = 0; i < queryTimes && !g_arguments->terminate; i++) {
+        if (g_queryInfo.specifiedQueryInfo.queryInterval && i > 0) {
+            toolsMsleep(
+                (int32_t)g_queryInfo.specifiedQueryInfo.queryInterval);
+        }
+        benchStatsInflight(pThreadInfo->stats, 1);
+        restEngineSubmit(engine, sql->command, pThreadInfo);
+    }
+    restEngineDestroy(engine);
+}
+#endif
+
 static void *specifiedTableQuery(void *sarg) {
     threadInfo *pThreadInfo = (threadInfo *)sarg;
 #ifdef LINUX
     prctl(PR_SET_NAME, "specTableQuery");
 #endif
+    benchMetricsThread(1);
     uint64_t st = 0;
     uint64_t et = 0;
-    uint64_t minDelay = UINT64_MAX;
-    uint64_t maxDelay = 0;
-    uint64_t totalDelay = 0;
     int32_t  index = 0;
 
     uint64_t  queryTimes = g_queryInfo.specifiedQueryInfo.queryTimes;
-    pThreadInfo->query_delay_list = benchCalloc(queryTimes, sizeof(uint64_t), false);
     uint64_t  lastPrintTime = toolsGetTimestampMs();
     uint64_t  startTs = toolsGetTimestampMs();
 
@@ -63,6 +99,15 @@ static void *specifiedTableQuery(void *sarg) {
         sprintf(pThreadInfo->filePath, "%s-%d", sql->result, pThreadInfo->threadID);
     }
 
+#ifdef LINUX
+    SDataBase *  database = benchArrayGet(g_arguments->databases, 0);
+    SSuperTable *stbInfo = benchArrayGet(database->superTbls, 0);
+    if (g_arguments->rest_connections > 0 && stbInfo->iface == REST_IFACE) {
+        specifiedTableRestQuery(pThreadInfo, sql, queryTimes);
+        index = queryTimes;
+    }
+#endif
+
     while (index < queryTimes) {
         if (g_queryInfo.specifiedQueryInfo.queryInterval &&
             (et - st) < (int64_t)g_queryInfo.specifiedQueryInfo.queryInterval) {
@@ -75,23 +120,24 @@ static void *specifiedTableQuery(void *sarg) {
 
         st = toolsGetTimestampUs();
         debugPrint(stdout, "st: %" PRId64 "\n", st);
-        if (selectAndGetResult(
-                pThreadInfo,
-                sql->command)) {
+        uint64_t fetched = pThreadInfo->fetchedRows;
+        benchStatsInflight(pThreadInfo->stats, 1);
+        int32_t code = selectAndGetResult(pThreadInfo, sql->command);
+        bool    failed = code != 0;
+        if (failed) {
             g_fail = true;
         }
 
         et = toolsGetTimestampUs();
         uint64_t delay = et - st;
-        pThreadInfo->query_delay_list[index] = delay;
+        benchHistRecord(&pThreadInfo->delayHist, delay);
+        benchStatsInflight(pThreadInfo->stats, -1);
+        benchStatsRecord(pThreadInfo->stats,
+                         pThreadInfo->fetchedRows - fetched,
+                         strlen(sql->command), delay, failed);
+        benchMetricsRecord(pThreadInfo->metrics,
+                           pThreadInfo->fetchedRows - fetched, 0, delay, code);
         index++;
-        totalDelay += delay;
-        if (delay > maxDelay) {
-            maxDelay = delay;
-        }
-        if (delay < minDelay) {
-            minDelay = delay;
-        }
 
         pThreadInfo->totalQueried++;
         uint64_t currentPrintTime = toolsGetTimestampMs();
@@ -106,8 +152,10 @@ static void *specifiedTableQuery(void *sarg) {
             lastPrintTime = currentPrintTime;
         }
     }
-    qsort(pThreadInfo->query_delay_list, queryTimes, sizeof(uint64_t), compare);
-    pThreadInfo->avg_delay = (double)totalDelay / queryTimes;
+    SLatencyHist *hist = &pThreadInfo->delayHist;
+    if (hist->count > 0) {
+        pThreadInfo->avg_delay = (double)hist->total / hist->count;
+    }
     debugPrint(stdout,
               "thread[%d] complete query <%s> %" PRIu64
               " times,"
@@ -118,10 +166,11 @@ static void *specifiedTableQuery(void *sarg) {
               " max: %5" PRIu64 "us\n\n ",
               pThreadInfo->threadID,
               sql->command,
-              queryTimes, minDelay, pThreadInfo->avg_delay,
-              pThreadInfo->query_delay_list[(int32_t)(queryTimes * 0.9)],
-              pThreadInfo->query_delay_list[(int32_t)(queryTimes * 0.95)],
-              pThreadInfo->query_delay_list[(int32_t)(queryTimes * 0.99)], maxDelay);
+              queryTimes, hist->min, pThreadInfo->avg_delay,
+              benchHistPercentile(hist, 90),
+              benchHistPercentile(hist, 95),
+              benchHistPercentile(hist, 99), hist->max);
+    benchMetricsThread(-1);
     return NULL;
 }
 
@@ -131,6 +180,7 @@ static void *superTableQuery(void *sarg) {
 #ifdef LINUX
     prctl(PR_SET_NAME, "superTableQuery");
 #endif
+    benchMetricsThread(1);
 
     uint64_t st = 0;
     uint64_t et = (int64_t)g_queryInfo.superQueryInfo.queryInterval;
@@ -158,9 +208,22 @@ static void *superTableQuery(void *sarg) {
                             g_queryInfo.superQueryInfo.result[j],
                             pThreadInfo->threadID);
                 }
-                if (selectAndGetResult(pThreadInfo, sqlstr)){
+                uint64_t fetched = pThreadInfo->fetchedRows;
+                int64_t  queryStart = toolsGetTimestampUs();
+                benchStatsInflight(pThreadInfo->stats, 1);
+                int32_t code = selectAndGetResult(pThreadInfo, sqlstr);
+                bool    failed = code != 0;
+                if (failed) {
                     g_fail = true;
                 }
+                uint64_t delay = toolsGetTimestampUs() - queryStart;
+                benchStatsInflight(pThreadInfo->stats, -1);
+                benchStatsRecord(pThreadInfo->stats,
+                                 pThreadInfo->fetchedRows - fetched,
+                                 strlen(sqlstr), delay, failed);
+                benchMetricsRecord(pThreadInfo->metrics,
+                                   pThreadInfo->fetchedRows - fetched, 0,
+                                   delay, code);
 
                 pThreadInfo->totalQueried++;
 
@@ -187,6 +250,7 @@ static void *superTableQuery(void *sarg) {
             pThreadInfo->end_table_to, (double)(et - st) / 1000.0);
     }
     tmfree(sqlstr);
+    benchMetricsThread(-1);
     return NULL;
 }
 
@@ -249,6 +313,21 @@ int queryTestProcess() {
         }
     }
 
+    // specified table queries go through the epoll engine, which opens its
+    // own connections; super table queries keep one socket per thread
+    bool restEngine = false;
+#ifdef LINUX
+    restEngine =
+        g_arguments->rest_connections > 0 && stbInfo->iface == REST_IFACE;
+#endif
+    if (g_arguments->rest_connections > 0 &&
+        g_queryInfo.superQueryInfo.sqlCount > 0 &&
+        g_queryInfo.superQueryInfo.threadCnt > 0) {
+        infoPrint(stdout, "%s",
+                  "rest_connections only applies to specified table queries, "
+                  "super table queries use one connection per thread\n");
+    }
+
     pthread_t * pids = NULL;
     threadInfo *infos = NULL;
     //==== create sub threads for query from specify table
@@ -269,8 +348,11 @@ int queryTestProcess() {
                 pThreadInfo->querySeq = i;
                 pThreadInfo->db_index = 0;
                 pThreadInfo->stb_index = 0;
+                benchHistInit(&pThreadInfo->delayHist, g_arguments->latency_max);
 
-                if (stbInfo->iface == REST_IFACE) {
+                if (restEngine) {
+                    pThreadInfo->sockfd = -1;
+                } else if (stbInfo->iface == REST_IFACE) {
 #ifdef WINDOWS
                     WSADATA wsaData;
                     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -317,6 +399,8 @@ int queryTestProcess() {
                     }
                 }
 
+                pThreadInfo->stats = benchStatsRegister("specified_query");
+                pThreadInfo->metrics = benchMetricsRegister("specified_query");
                 pthread_create(pids + seq, NULL, specifiedTableQuery,
                                pThreadInfo);
             }
@@ -324,42 +408,40 @@ int queryTestProcess() {
                 uint64_t seq = i * nConcurrent + j;
                 pthread_join(pids[seq], NULL);
                 if (stbInfo->iface == REST_IFACE) {
-                    threadInfo *pThreadInfo = infos + j * nSqlCount + i;
+                    threadInfo *pThreadInfo = infos + seq;
 #ifdef WINDOWS
                     closesocket(pThreadInfo->sockfd);
                     WSACleanup();
 #else
-                    close(pThreadInfo->sockfd);
+                    if (pThreadInfo->sockfd >= 0) {
+                        close(pThreadInfo->sockfd);
+                    }
 #endif
+                    freeHttpBuffers(pThreadInfo);
                 }
                 if (g_fail) {
                     return -1;
                 }
             }
             uint64_t query_times = g_queryInfo.specifiedQueryInfo.queryTimes;
-            uint64_t total_query_times = query_times * nConcurrent;
-            double avg_delay = 0.0;
+            SLatencyHist delayHist;
+            benchHistInit(&delayHist, g_arguments->latency_max);
             for (int j = 0; j < nConcurrent; j++) {
                 uint64_t    seq = i * nConcurrent + j;
                 threadInfo *pThreadInfo = infos + seq;
-                avg_delay += pThreadInfo->avg_delay;
-                for (uint64_t k = 0; k < g_queryInfo.specifiedQueryInfo.queryTimes; k++) {
-                    sql->delay_list[j*query_times + k] = pThreadInfo->query_delay_list[k];
-                }
-                tmfree(pThreadInfo->query_delay_list);
+                benchHistMerge(&delayHist, &pThreadInfo->delayHist);
+                benchHistDestroy(&pThreadInfo->delayHist);
             }
-            avg_delay /= nConcurrent;
-            qsort(sql->delay_list, total_query_times, sizeof(uint64_t), compare);
             infoPrint(stdout, "complete query <%s> with %d threads and %"PRIu64
-                    " times for each, query delay min: %.6fs,"
-                    "avg: %.6fs, p90: %.6fs, p95: %.6fs, p99: %.6fs, max: %.6fs\n",
-                    sql->command, nConcurrent, query_times,
-                    sql->delay_list[0]/1E6,
-                    avg_delay/1E6,
-                    sql->delay_list[(int32_t)(total_query_times * 0.90)]/1E6,
-                    sql->delay_list[(int32_t)(total_query_times * 0.95)]/1E6,
-                    sql->delay_list[(int32_t)(total_query_times * 0.99)]/1E6,
-                    sql->delay_list[(int32_t)total_query_times - 1]/1E6);
+                    " times for each\n",
+                    sql->command, nConcurrent, query_times);
+            benchHistPrint(stdout, "query delay", &delayHist, 1E6, "s");
+            char label[SQL_BUFF_LEN];
+            snprintf(label, sizeof(label), "query %s", sql->command);
+            if (benchHistDump(&delayHist, label)) {
+                g_fail = true;
+            }
+            benchHistDestroy(&delayHist);
         }
     } else {
         g_queryInfo.specifiedQueryInfo.concurrent = 0;
@@ -370,7 +452,6 @@ int queryTestProcess() {
     for (int i = 0; i < g_queryInfo.specifiedQueryInfo.sqls->size; ++i) {
         SSQL * sql = benchArrayGet(g_queryInfo.specifiedQueryInfo.sqls, i);
         tmfree(sql->command);
-        tmfree(sql->delay_list);
     }
     benchArrayDestroy(g_queryInfo.specifiedQueryInfo.sqls);
 
@@ -441,6 +522,8 @@ int queryTestProcess() {
                     return -1;
                 }
             }
+            pThreadInfo->stats = benchStatsRegister("super_query");
+            pThreadInfo->metrics = benchMetricsRegister("super_query");
             pthread_create(pidsOfSub + i, NULL, superTableQuery, pThreadInfo);
         }
 
@@ -459,6 +542,7 @@ int queryTestProcess() {
 #else
             close(pThreadInfo->sockfd);
 #endif
+            freeHttpBuffers(pThreadInfo);
         }
         if (g_fail) {
             return -1;
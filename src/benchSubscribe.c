@@ -77,6 +77,7 @@ static void *specifiedSubscribe(void *sarg) {
 #ifdef LINUX
     prctl(PR_SET_NAME, "specSub");
 #endif
+    benchMetricsThread(1);
     sprintf(g_queryInfo.specifiedQueryInfo.topic[pThreadInfo->threadID],
             "taosbenchmark-subscribe-%" PRIu64 "-%d", pThreadInfo->querySeq,
             pThreadInfo->threadID);
@@ -110,16 +111,22 @@ static void *specifiedSubscribe(void *sarg) {
             g_queryInfo.specifiedQueryInfo
                 .endAfterConsume[pThreadInfo->querySeq]);
 
+        int64_t consumeStart = toolsGetTimestampUs();
         g_queryInfo.specifiedQueryInfo.res[pThreadInfo->threadID] =
             taos_consume(
                 g_queryInfo.specifiedQueryInfo.tsub[pThreadInfo->threadID]);
+        int64_t consumeEnd = toolsGetTimestampUs();
         if (g_queryInfo.specifiedQueryInfo.res[pThreadInfo->threadID]) {
             if (sql->result[0] != 0) {
                 sprintf(pThreadInfo->filePath, "%s-%d", sql->result, pThreadInfo->threadID);
             }
-            fetchResult(
+            int rows = fetchResult(
                 g_queryInfo.specifiedQueryInfo.res[pThreadInfo->threadID],
                 pThreadInfo);
+            benchStatsRecord(pThreadInfo->stats, rows, 0,
+                             consumeEnd - consumeStart, false);
+            benchMetricsRecord(pThreadInfo->metrics, rows, 0,
+                               consumeEnd - consumeStart, 0);
 
             g_queryInfo.specifiedQueryInfo.consumed[pThreadInfo->threadID]++;
             if ((g_queryInfo.specifiedQueryInfo
@@ -154,6 +161,7 @@ static void *specifiedSubscribe(void *sarg) {
     *code = 0;
     taos_free_result(g_queryInfo.specifiedQueryInfo.res[pThreadInfo->threadID]);
 free_of_specified_subscribe:
+    benchMetricsThread(-1);
     return code;
 }
 
@@ -167,6 +175,7 @@ static void *superSubscribe(void *sarg) {
 #ifdef LINUX
     prctl(PR_SET_NAME, "superSub");
 #endif
+    benchMetricsThread(1);
     if (pThreadInfo->ntables > MAX_QUERY_SQL_COUNT) {
         errorPrint(stderr,
                    "The table number(%" PRId64
@@ -223,7 +232,9 @@ static void *superSubscribe(void *sarg) {
             performancePrint(
                 stdout, "st: %" PRIu64 " et: %" PRIu64 " st-et: %" PRIu64 "\n",
                 st, et, (st - et));
+            int64_t consumeStart = toolsGetTimestampUs();
             res = taos_consume(tsub[tsubSeq]);
+            int64_t consumeEnd = toolsGetTimestampUs();
             et = toolsGetTimestampMs();
             performancePrint(
                 stdout, "st: %" PRIu64 " et: %" PRIu64 " delta: %" PRIu64 "\n",
@@ -237,7 +248,11 @@ static void *superSubscribe(void *sarg) {
                                 .result[pThreadInfo->querySeq],
                             pThreadInfo->threadID);
                 }
-                fetchResult(res, pThreadInfo);
+                int rows = fetchResult(res, pThreadInfo);
+                benchStatsRecord(pThreadInfo->stats, rows, 0,
+                                 consumeEnd - consumeStart, false);
+                benchMetricsRecord(pThreadInfo->metrics, rows, 0,
+                                   consumeEnd - consumeStart, 0);
                 consumed[tsubSeq]++;
 
                 if ((g_queryInfo.superQueryInfo.resubAfterConsume != -1) &&
@@ -269,6 +284,7 @@ static void *superSubscribe(void *sarg) {
 free_of_super_subscribe:
 
     tmfree(subSqlStr);
+    benchMetricsThread(-1);
     return code;
 }
 
@@ -347,6 +363,10 @@ int subscribeTestProcess() {
                 pThreadInfo->db_index = 0;
                 pThreadInfo->taos =
                     select_one_from_pool(database->dbName);
+                pThreadInfo->stats =
+                    benchStatsRegister("specified_subscribe");
+                pThreadInfo->metrics =
+                    benchMetricsRegister("specified_subscribe");
                 pthread_create(pids + seq, NULL, specifiedSubscribe,
                                pThreadInfo);
             }
@@ -407,6 +427,8 @@ int subscribeTestProcess() {
                 tableFrom = pThreadInfo->end_table_to + 1;
                 pThreadInfo->taos =
                     select_one_from_pool(database->dbName);
+                pThreadInfo->stats = benchStatsRegister("super_subscribe");
+                pThreadInfo->metrics = benchMetricsRegister("super_subscribe");
                 pthread_create(pidsOfStable + seq, NULL, superSubscribe,
                                pThreadInfo);
             }
@@ -14,6 +14,9 @@
  */
 
 #include "bench.h"
+#ifdef DEFLATE_CODEC
+#include <zlib.h>
+#endif
 
 inline void* benchCalloc(size_t nmemb, size_t size, bool record) {
     void* ret = calloc(nmemb, size);
@@ -94,13 +97,6 @@ void resetAfterAnsiEscape(void) {
     }
 }
 
-int taosRandom() {
-    int number;
-    rand_s(&number);
-
-    return number;
-}
-
 void usleep(__int64 usec)
 {
   HANDLE timer;
@@ -122,8 +118,6 @@ void resetAfterAnsiEscape(void) {
     printf("\x1b[0m");
 }
 
-int taosRandom() { return rand(); }
-
 #endif
 
 int getAllChildNameOfSuperTable(TAOS *taos, char *dbName, char *stbName,
@@ -163,6 +157,119 @@ int getAllChildNameOfSuperTable(TAOS *taos, char *dbName, char *stbName,
     return 0;
 }
 
+// the longest formatted suffix: 20 digits, closing backquote and NUL
+#define NAME_SUFFIX_LEN 22
+
+void initNameStore(SNameStore *store, const char *prefix, bool escape) {
+    memset(store, 0, sizeof(SNameStore));
+    store->escape = escape;
+    if (prefix == NULL) {
+        return;
+    }
+    uint32_t len = (uint32_t)strlen(prefix);
+    if (len + 1 + NAME_SUFFIX_LEN > TSDB_TABLE_NAME_LEN) {
+        len = TSDB_TABLE_NAME_LEN - 1 - NAME_SUFFIX_LEN;
+    }
+    store->prefix = benchCalloc(1, len + 2, true);
+    if (escape) {
+        store->prefix[store->prefixLen++] = '`';
+    }
+    memcpy(store->prefix + store->prefixLen, prefix, len);
+    store->prefixLen += len;
+}
+
+// copy a server side name into the arena, escaped when the store is
+int appendNameStore(SNameStore *store, const char *name, uint32_t len) {
+    if (store->count + 1 >= store->capacity) {
+        uint64_t  capacity = store->capacity ? store->capacity * 2 : 1024;
+        uint64_t *offsets =
+            realloc(store->offsets, capacity * sizeof(uint64_t));
+        if (offsets == NULL) {
+            errorPrint(stderr, "%s", "failed to grow the table name store\n");
+            return -1;
+        }
+        store->offsets = offsets;
+        store->capacity = capacity;
+    }
+    if (store->arenaLen + len + 3 > store->arenaCap) {
+        uint64_t cap = store->arenaCap ? store->arenaCap : 64 * 1024;
+        while (store->arenaLen + len + 3 > cap) {
+            cap *= 2;
+        }
+        char *arena = realloc(store->arena, cap);
+        if (arena == NULL) {
+            errorPrint(stderr, "%s", "failed to grow the table name store\n");
+            return -1;
+        }
+        store->arena = arena;
+        store->arenaCap = cap;
+    }
+    char *pstr = store->arena + store->arenaLen;
+    if (store->escape) {
+        *pstr++ = '`';
+    }
+    memcpy(pstr, name, len);
+    pstr += len;
+    if (store->escape) {
+        *pstr++ = '`';
+    }
+    *pstr++ = '\0';
+    store->offsets[store->count++] = store->arenaLen;
+    store->arenaLen = pstr - store->arena;
+    store->offsets[store->count] = store->arenaLen;
+    return 0;
+}
+
+// name of child table tableSeq, *name points either into the arena or at
+// buf, which must hold TSDB_TABLE_NAME_LEN bytes; returns its length
+uint32_t getChildTblName(SSuperTable *stbInfo, uint64_t tableSeq, char *buf,
+                         char **name) {
+    SNameStore *store = &stbInfo->childTblNames;
+    if (store->arena) {
+        *name = store->arena + store->offsets[tableSeq];
+        return (uint32_t)(store->offsets[tableSeq + 1] -
+                          store->offsets[tableSeq] - 1);
+    }
+    uint32_t len = store->prefixLen;
+    memcpy(buf, store->prefix, len);
+    len += benchInt64ToStr((int64_t)tableSeq, buf + len);
+    if (store->escape) {
+        buf[len++] = '`';
+    }
+    buf[len] = '\0';
+    *name = buf;
+    return len;
+}
+
+// rebuild the store so that name i becomes the old name order[i], generated
+// names are materialized into the arena on the way
+int reorderNameStore(SSuperTable *stbInfo, const uint64_t *order,
+                     uint64_t count) {
+    SNameStore sorted;
+    // names are copied already escaped
+    initNameStore(&sorted, NULL, false);
+    char nameBuf[TSDB_TABLE_NAME_LEN];
+    for (uint64_t i = 0; i < count; i++) {
+        char *   name;
+        uint32_t len = getChildTblName(stbInfo, order[i], nameBuf, &name);
+        if (appendNameStore(&sorted, name, len)) {
+            freeNameStore(&sorted);
+            return -1;
+        }
+    }
+    sorted.escape = stbInfo->childTblNames.escape;
+    freeNameStore(&stbInfo->childTblNames);
+    stbInfo->childTblNames = sorted;
+    return 0;
+}
+
+void freeNameStore(SNameStore *store) {
+    tmfree(store->prefix);
+    tmfree(store->arena);
+    tmfree(store->offsets);
+    memset(store, 0, sizeof(SNameStore));
+}
+
 int convertHostToServAddr(char *host, uint16_t port,
                           struct sockaddr_in *serv_addr) {
     if (!host) {
@@ -272,6 +379,175 @@ int64_t toolsGetTimestamp(int32_t precision) {
 
 void toolsMsleep(int32_t mseconds) { usleep(mseconds * 1000); }
 
+// sleep until toolsGetTimestampUs() reaches deadlineUs, the last stretch is
+// spent spinning so the wake-up is not rounded to the scheduler tick
+void toolsUsleepUntil(int64_t deadlineUs) {
+    int64_t now = toolsGetTimestampUs();
+    while (deadlineUs - now > 200) {
+        usleep(deadlineUs - now - 100);
+        now = toolsGetTimestampUs();
+    }
+    while (now < deadlineUs) {
+        now = toolsGetTimestampUs();
+    }
+}
+
+// xoshiro256** state, one per thread so generation never serializes on a
+// shared lock; every stream is derived from the run seed
+static BENCH_THREAD_LOCAL uint64_t g_randState[4];
+static BENCH_THREAD_LOCAL bool     g_randSeeded = false;
+
+static FORCE_INLINE uint64_t randRotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitMix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// pick a seed from the clock when none was given and print it, so any
+// run can be replayed with -e/random_seed
+void benchRandInit(void) {
+    if (0 == g_arguments->random_seed) {
+        g_arguments->random_seed = (uint64_t)toolsGetTimestampUs();
+        infoPrint(stdout, "random seed: %" PRIu64 "\n",
+                  g_arguments->random_seed);
+    }
+}
+
+// stream 0 is the main thread, worker threads use their thread id + 1.
+// Agents share one seed, their index keeps their column values apart
+void benchRandSeed(uint64_t stream) {
+    stream += (uint64_t)g_arguments->agent_index << 32;
+    uint64_t x = g_arguments->random_seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; i++) {
+        g_randState[i] = splitMix64(&x);
+    }
+    g_randSeeded = true;
+}
+
+// switch the thread to a stream derived from the seed and key, e.g. one
+// child table, so its values do not depend on which thread asks; saved
+// keeps the previous state for benchRandRestore
+void benchRandKeyed(uint64_t key, uint64_t saved[4]) {
+    if (!g_randSeeded) {
+        benchRandSeed(0);
+    }
+    memcpy(saved, g_randState, sizeof(g_randState));
+    uint64_t x = g_arguments->random_seed ^ splitMix64(&key);
+    for (int i = 0; i < 4; i++) {
+        g_randState[i] = splitMix64(&x);
+    }
+}
+
+void benchRandRestore(const uint64_t saved[4]) {
+    memcpy(g_randState, saved, sizeof(g_randState));
+}
+
+uint64_t benchRandNext(void) {
+    if (!g_randSeeded) {
+        benchRandSeed(0);
+    }
+    uint64_t *s = g_randState;
+    uint64_t  result = randRotl(s[1] * 5, 7) * 9;
+    uint64_t  t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = randRotl(s[3], 45);
+    return result;
+}
+
+// non-negative 31-bit value, same range as glibc rand()
+int taosRandom() { return (int)(benchRandNext() >> 33); }
+
+// [0, bound) by multiply-shift instead of modulo
+uint32_t benchRandBelow(uint32_t bound) {
+    return (uint32_t)(((benchRandNext() >> 32) * (uint64_t)bound) >> 32);
+}
+
+void benchRandFill(uint32_t *out, int32_t n) {
+    int32_t i = 0;
+    for (; i + 1 < n; i += 2) {
+        uint64_t r = benchRandNext();
+        out[i] = (uint32_t)(r >> 32);
+        out[i + 1] = (uint32_t)r;
+    }
+    if (i < n) {
+        out[i] = (uint32_t)(benchRandNext() >> 32);
+    }
+}
+
+#define RAND_FILL_CHUNK 256
+
+// fill out with values in [min, max); raw words are generated first and
+// reduced in a separate branch-free loop the compiler can vectorize
+void benchRandFillRange(int32_t *out, int32_t n, int32_t min, int32_t max) {
+    uint32_t raw[RAND_FILL_CHUNK];
+    uint64_t range = (max > min) ? (uint64_t)((int64_t)max - min) : 1;
+    while (n > 0) {
+        int32_t m = n < RAND_FILL_CHUNK ? n : RAND_FILL_CHUNK;
+        benchRandFill(raw, m);
+        for (int32_t i = 0; i < m; i++) {
+            out[i] = (int32_t)(min + (int64_t)((raw[i] * range) >> 32));
+        }
+        out += m;
+        n -= m;
+    }
+}
+
+// fill out with values in [min, max)
+void benchRandFillDouble(double *out, int32_t n, double min, double max) {
+    double scale = (max - min) / 9007199254740992.0;  // 2^53
+    for (int32_t i = 0; i < n; i++) {
+        out[i] = min + (double)(benchRandNext() >> 11) * scale;
+    }
+}
+
+static const char g_digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// write the decimal form of value into buf without the trailing '\0',
+// two digits per step, return the number of bytes written
+int32_t benchInt64ToStr(int64_t value, char *buf) {
+    char     tmp[BIGINT_BUFF_LEN];
+    char *   p = tmp + sizeof(tmp);
+    uint64_t v = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    while (v >= 100) {
+        uint32_t idx = (uint32_t)(v % 100) * 2;
+        v /= 100;
+        *--p = g_digitPairs[idx + 1];
+        *--p = g_digitPairs[idx];
+    }
+    if (v >= 10) {
+        uint32_t idx = (uint32_t)v * 2;
+        *--p = g_digitPairs[idx + 1];
+        *--p = g_digitPairs[idx];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0) {
+        *--p = '-';
+    }
+    int32_t len = (int32_t)(tmp + sizeof(tmp) - p);
+    memcpy(buf, p, len);
+    return len;
+}
+
 int regexMatch(const char *s, const char *reg, int cflags) {
     regex_t regex;
     char    msgbuf[100] = {0};
@@ -357,14 +633,276 @@ void encode_base_64() {
         g_arguments->base64_buf[encoded_len - 1 - l] = '=';
 }
 
-int postProceSql(char *sqlstr, threadInfo *pThreadInfo) {
-    SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
-    SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
-    int32_t      code = -1;
-    char *       req_fmt =
-        "POST %s HTTP/1.1\r\nHost: %s:%d\r\nAccept: */*\r\nAuthorization: "
-        "Basic %s\r\nContent-Length: %d\r\nContent-Type: "
-        "application/x-www-form-urlencoded\r\n\r\n%s";
+static void parseHttpHeaders(SHttpResp *resp, char *buf, int64_t end) {
+    char *line = buf;
+    char *stop = buf + end;
+    if (0 == strncmp(line, "HTTP/1.", 7) && line + 12 <= stop) {
+        resp->status = atoi(line + 9);
+    }
+    while (line < stop) {
+        char *eol = strstr(line, "\r\n");
+        if (NULL == eol || eol > stop) {
+            break;
+        }
+        if (0 == strncasecmp(line, "Content-Length:", 15)) {
+            resp->contentLength = atoll(line + 15);
+        } else if (0 == strncasecmp(line, "Transfer-Encoding:", 18)) {
+            *eol = '\0';
+            resp->chunked = (NULL != strstr(line + 18, "chunked"));
+            *eol = '\r';
+        } else if (0 == strncasecmp(line, "Connection:", 11)) {
+            *eol = '\0';
+            resp->close = (NULL != strstr(line + 11, "close"));
+            *eol = '\r';
+        }
+        line = eol + 2;
+    }
+}
+
+// feed the first received bytes of buf into the parser, return 1 when the
+// response is complete, 0 when more bytes are needed and -1 if malformed
+int parseHttpResponse(SHttpResp *resp, char *buf, int64_t received) {
+    if (0 == resp->bodyStart) {
+        int64_t from = resp->scanned > 3 ? resp->scanned - 3 : 0;
+        int64_t end = -1;
+        for (int64_t i = from; i + 3 < received; i++) {
+            if (buf[i] == '\r' && buf[i + 1] == '\n' && buf[i + 2] == '\r' &&
+                buf[i + 3] == '\n') {
+                end = i;
+                break;
+            }
+        }
+        resp->scanned = received;
+        if (end < 0) {
+            return 0;
+        }
+        buf[end + 2] = '\0';
+        parseHttpHeaders(resp, buf, end + 2);
+        buf[end + 2] = '\r';
+        if (0 == resp->status) {
+            return -1;
+        }
+        resp->bodyStart = end + 4;
+        resp->readPos = resp->bodyStart;
+        if (resp->status == 204 || resp->status == 304 ||
+            resp->status / 100 == 1) {
+            return 1;
+        }
+    }
+
+    if (resp->chunked) {
+        while (true) {
+            int64_t avail = received - resp->readPos;
+            if (resp->chunkLeft > 0) {
+                int64_t n = avail < resp->chunkLeft ? avail : resp->chunkLeft;
+                memmove(buf + resp->bodyStart + resp->bodyLen,
+                        buf + resp->readPos, n);
+                resp->bodyLen += n;
+                resp->readPos += n;
+                resp->chunkLeft -= n;
+                if (resp->chunkLeft > 0) {
+                    return 0;
+                }
+                resp->chunkLeft = HTTP_CHUNK_CRLF;
+                continue;
+            }
+            if (resp->chunkLeft == HTTP_CHUNK_CRLF) {
+                if (avail < 2) {
+                    return 0;
+                }
+                resp->readPos += 2;
+                resp->chunkLeft = HTTP_CHUNK_SIZE;
+                continue;
+            }
+            // a size line or a trailer line
+            char *   line = buf + resp->readPos;
+            int64_t  i = 0;
+            while (i + 1 < avail && !(line[i] == '\r' && line[i + 1] == '\n')) {
+                i++;
+            }
+            if (i + 1 >= avail) {
+                return 0;
+            }
+            resp->readPos += i + 2;
+            if (resp->chunkLeft == HTTP_CHUNK_TRAILER) {
+                if (0 == i) {
+                    return 1;
+                }
+                continue;
+            }
+            if (!isxdigit((unsigned char)line[0])) {
+                return -1;
+            }
+            int64_t size = strtoll(line, NULL, 16);
+            resp->chunkLeft = size > 0 ? size : HTTP_CHUNK_TRAILER;
+        }
+    }
+
+    if (resp->contentLength >= 0) {
+        if (received - resp->bodyStart < resp->contentLength) {
+            return 0;
+        }
+        resp->bodyLen = resp->contentLength;
+        return 1;
+    }
+    // neither framing, the body runs until the server closes
+    resp->bodyLen = received - resp->bodyStart;
+    resp->close = true;
+    return 0;
+}
+
+static void closeHttpSocket(threadInfo *pThreadInfo) {
+    if (pThreadInfo->sockfd >= 0) {
+#ifdef WINDOWS
+        closesocket(pThreadInfo->sockfd);
+#else
+        close(pThreadInfo->sockfd);
+#endif
+        pThreadInfo->sockfd = -1;
+    }
+}
+
+static int reconnectHttp(threadInfo *pThreadInfo) {
+    closeHttpSocket(pThreadInfo);
+    int sockfd = (int)socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        errorPrint(stderr, "%s\n", "failed to create socket");
+        return -1;
+    }
+    if (connect(sockfd, (struct sockaddr *)&(g_arguments->serv_addr),
+                sizeof(struct sockaddr)) < 0) {
+        errorPrint(stderr, "%s\n", "failed to connect");
+#ifdef WINDOWS
+        closesocket(sockfd);
+#else
+        close(sockfd);
+#endif
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (const char *)&one,
+               sizeof(one));
+    pThreadInfo->sockfd = sockfd;
+    return 0;
+}
+
+// send all pieces with scatter-gather io, the body is never copied
+static int sendHttpPieces(threadInfo *pThreadInfo, char **data, int64_t *len,
+                          int count) {
+#ifdef WINDOWS
+    WSABUF bufs[3];
+    for (int i = 0; i < count; i++) {
+        bufs[i].buf = data[i];
+        bufs[i].len = (ULONG)len[i];
+    }
+    DWORD sent = 0;
+    if (0 != WSASend(pThreadInfo->sockfd, bufs, count, &sent, 0, NULL,
+                     NULL)) {
+        return -1;
+    }
+    return 0;
+#else
+    struct iovec iov[3];
+    int          first = 0;
+    for (int i = 0; i < count; i++) {
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = len[i];
+    }
+    while (first < count) {
+        struct msghdr msg = {0};
+        msg.msg_iov = iov + first;
+        msg.msg_iovlen = count - first;
+#ifdef MSG_NOSIGNAL
+        ssize_t bytes = sendmsg(pThreadInfo->sockfd, &msg, MSG_NOSIGNAL);
+#else
+        ssize_t bytes = sendmsg(pThreadInfo->sockfd, &msg, 0);
+#endif
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while (first < count && (size_t)bytes >= iov[first].iov_len) {
+            bytes -= iov[first].iov_len;
+            first++;
+        }
+        if (first < count) {
+            iov[first].iov_base = (char *)iov[first].iov_base + bytes;
+            iov[first].iov_len -= bytes;
+        }
+    }
+    return 0;
+#endif
+}
+
+// only insert bodies are compressed, queries are too small to gain from it
+static bool compressHttp() {
+    return g_arguments->rest_compression != REST_COMPRESS_NONE &&
+           g_arguments->test_mode == INSERT_TEST;
+}
+
+#ifdef DEFLATE_CODEC
+static int64_t threadCpuTimeUs() {
+#ifdef LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return toolsGetTimestampUs();
+#endif
+}
+#endif
+
+// deflate body into *out with a stream kept across requests, gzip or zlib
+// framed per rest_compression; returns the compressed length or -1
+int64_t compressHttpBody(threadInfo *pThreadInfo, void **stream,
+                         const char *body, int64_t len, char **out,
+                         uint64_t *cap) {
+#ifdef DEFLATE_CODEC
+    int64_t   cpuStart = threadCpuTimeUs();
+    z_stream *zs = (z_stream *)*stream;
+    if (zs == NULL) {
+        zs = benchCalloc(1, sizeof(z_stream), false);
+        int windowBits =
+            g_arguments->rest_compression == REST_COMPRESS_GZIP ? 15 + 16 : 15;
+        if (Z_OK != deflateInit2(zs, g_arguments->rest_compression_level,
+                                 Z_DEFLATED, windowBits, 8,
+                                 Z_DEFAULT_STRATEGY)) {
+            errorPrint(stderr, "%s", "failed to init deflate stream\n");
+            tmfree(zs);
+            return -1;
+        }
+        *stream = zs;
+    } else {
+        deflateReset(zs);
+    }
+    uint64_t bound = deflateBound(zs, (uLong)len);
+    if (*cap < bound) {
+        tmfree(*out);
+        *out = benchCalloc(1, bound, false);
+        *cap = bound;
+    }
+    zs->next_in = (Bytef *)body;
+    zs->avail_in = (uInt)len;
+    zs->next_out = (Bytef *)*out;
+    zs->avail_out = (uInt)bound;
+    int ret = deflate(zs, Z_FINISH);
+    pThreadInfo->compressCpuUs += threadCpuTimeUs() - cpuStart;
+    if (ret != Z_STREAM_END) {
+        errorPrint(stderr, "failed to compress request body, code: %d\n", ret);
+        return -1;
+    }
+    pThreadInfo->bodyBytes += len;
+    pThreadInfo->wireBytes += zs->total_out;
+    return (int64_t)zs->total_out;
+#else
+    return -1;
+#endif
+}
+
+static void buildHttpHeader(threadInfo *pThreadInfo, SDataBase *database,
+                            SSuperTable *stbInfo) {
     char url[1024];
     if (stbInfo->iface == REST_IFACE) {
         sprintf(url, "/rest/sql/%s", database->dbName);
@@ -383,158 +921,135 @@ int postProceSql(char *sqlstr, threadInfo *pThreadInfo) {
                stbInfo->lineProtocol == TSDB_SML_JSON_PROTOCOL) {
         sprintf(url, "/opentsdb/v1/put/json/%s", database->dbName);
     }
-
-    int      bytes, sent, received, req_str_len, resp_len;
-    char *   request_buf = NULL;
-    char *   response_buf = NULL;
     uint16_t rest_port = g_arguments->port + TSDB_PORT_HTTP;
-    int req_buf_len = (int)strlen(sqlstr) + REQ_EXTRA_BUF_LEN;
+    pThreadInfo->httpHeader = benchCalloc(1, REQ_EXTRA_BUF_LEN + 1024, true);
+    pThreadInfo->httpHeaderLen = (uint32_t)snprintf(
+        pThreadInfo->httpHeader, REQ_EXTRA_BUF_LEN + 1024,
+        "POST %s HTTP/1.1\r\nHost: %s:%d\r\nAccept: */*\r\nAuthorization: "
+        "Basic %s\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+        "%sContent-Length: ",
+        url, g_arguments->host, rest_port, g_arguments->base64_buf,
+        !compressHttp()                                           ? ""
+        : g_arguments->rest_compression == REST_COMPRESS_GZIP
+            ? "Content-Encoding: gzip\r\n"
+            : "Content-Encoding: deflate\r\n");
+}
 
-    request_buf = benchCalloc(1, req_buf_len, false);
-    uint64_t response_length;
-    if (g_arguments->test_mode == INSERT_TEST) {
-        response_length = RESP_BUF_LEN;
-    } else {
-        response_length = g_queryInfo.response_buffer;
+void freeDeflateStream(void **stream) {
+#ifdef DEFLATE_CODEC
+    if (*stream) {
+        deflateEnd((z_stream *)*stream);
+        tmfree(*stream);
+        *stream = NULL;
     }
-    response_buf = benchCalloc(1, response_length, false);
+#endif
+}
 
-    int r;
-    if (stbInfo->lineProtocol == TSDB_SML_TELNET_PROTOCOL &&
-        stbInfo->tcpTransfer) {
-        r = snprintf(request_buf, req_buf_len, "%s", sqlstr);
-    } else {
-        r = snprintf(request_buf, req_buf_len, req_fmt, url, g_arguments->host,
-                     rest_port, g_arguments->base64_buf, strlen(sqlstr),
-                     sqlstr);
-    }
-    if (r >= req_buf_len) {
-        free(request_buf);
-        free(response_buf);
-        ERROR_EXIT("too long request");
-    }
+void freeHttpBuffers(threadInfo *pThreadInfo) {
+    tmfree(pThreadInfo->httpHeader);
+    pThreadInfo->httpHeader = NULL;
+    tmfree(pThreadInfo->httpResp);
+    pThreadInfo->httpResp = NULL;
+    pThreadInfo->httpRespCap = 0;
+    freeDeflateStream(&pThreadInfo->httpDeflate);
+    tmfree(pThreadInfo->httpBody);
+    pThreadInfo->httpBody = NULL;
+    pThreadInfo->httpBodyCap = 0;
+}
 
-    req_str_len = (int)strlen(request_buf);
-    debugPrint(stdout, "request buffer: %s\n", request_buf);
-    sent = 0;
-    do {
-        bytes = send(pThreadInfo->sockfd, request_buf + sent,
-                     req_str_len - sent, 0);
-        if (bytes < 0) {
-            errorPrint(stderr, "%s", "writing no message to socket\n");
-            goto free_of_post;
+// read one response into pThreadInfo->httpResp, return 1 when complete, 0
+// when the server closed before sending anything and -1 on error
+static int recvHttpResponse(threadInfo *pThreadInfo, SHttpResp *resp) {
+    int64_t received = 0;
+    while (true) {
+        if (received + 1 >= (int64_t)pThreadInfo->httpRespCap) {
+            pThreadInfo->httpRespCap *= 2;
+            char *grown = realloc(pThreadInfo->httpResp,
+                                  pThreadInfo->httpRespCap);
+            if (NULL == grown) {
+                errorPrint(stderr, "%s", "failed to grow response buffer\n");
+                return -1;
+            }
+            pThreadInfo->httpResp = grown;
         }
-        if (bytes == 0) break;
-        sent += bytes;
-    } while (sent < req_str_len);
-
-    if (stbInfo->lineProtocol == TSDB_SML_TELNET_PROTOCOL &&
-        stbInfo->iface == SML_REST_IFACE && stbInfo->tcpTransfer) {
-        code = 0;
-        goto free_of_post;
-    }
-
-    resp_len = response_length - 1;
-    received = 0;
-
-    char resEncodingChunk[] = "Encoding: chunked";
-    char succMessage[] = "succ";
-    char resHttp[] = "HTTP/1.1 ";
-    char resHttpOk[] = "HTTP/1.1 200 OK";
-    char influxHttpOk[] = "HTTP/1.1 204";
-    bool chunked = false;
-
-    do {
+        char *buf = pThreadInfo->httpResp;
 #ifdef WINDOWS
-        bytes = recv(pThreadInfo->sockfd, response_buf + received,
-                     resp_len - received, 0);
+        int bytes = recv(pThreadInfo->sockfd, buf + received,
+                         (int)(pThreadInfo->httpRespCap - received - 1), 0);
 #else
-        bytes = read(pThreadInfo->sockfd, response_buf + received,
-                     resp_len - received);
+        ssize_t bytes = read(pThreadInfo->sockfd, buf + received,
+                             pThreadInfo->httpRespCap - received - 1);
 #endif
-
-        debugPrint(stdout, "response_buffer: %s\n", response_buf);
-        if (NULL != strstr(response_buf, resEncodingChunk)) {
-            chunked = true;
+        if (bytes < 0 && errno == EINTR) {
+            continue;
         }
-        int64_t index = strlen(response_buf) - 1;
-        while (response_buf[index] == '\n' || response_buf[index] == '\r') {
-            index--;
-        }
-        debugPrint(stdout, "index: %" PRId64 "\n", index);
-        if (chunked && response_buf[index] == '0') {
-            break;
-        }
-        if (!chunked && response_buf[index] == '}') {
-            break;
-        }
-
         if (bytes <= 0) {
+            if (0 == received) {
+                return 0;
+            }
+            if (0 == bytes && resp->bodyStart > 0 && !resp->chunked &&
+                resp->contentLength < 0) {
+                return 1;
+            }
             errorPrint(stderr, "%s", "reading no response from socket\n");
-            goto free_of_post;
+            return -1;
         }
-
         received += bytes;
-
-        if (g_arguments->test_mode == INSERT_TEST) {
-            if (strlen(response_buf)) {
-                if (((NULL != strstr(response_buf, resEncodingChunk)) &&
-                     (NULL != strstr(response_buf, resHttp))) ||
-                    ((NULL != strstr(response_buf, resHttpOk)) ||
-                     (NULL != strstr(response_buf, influxHttpOk)))) {
-                    break;
-                }
-            }
+        int ret = parseHttpResponse(resp, buf, received);
+        if (ret != 0) {
+            return ret;
         }
-    } while (received < resp_len);
-
-    if (received == resp_len) {
-        errorPrint(stderr, "%s", "storing complete response from socket\n");
-        goto free_of_post;
     }
+}
 
-    if (NULL == strstr(response_buf, resHttpOk) &&
-        NULL == strstr(response_buf, influxHttpOk) &&
-        NULL == strstr(response_buf, succMessage)) {
-        errorPrint(stderr, "Response:\n%s\n", response_buf);
+// judge a complete response whose raw bytes are in buf, return 0 on success,
+// else the code the server answered with or -1
+static int32_t checkHttpResponse(threadInfo *pThreadInfo, SSuperTable *stbInfo,
+                                 SHttpResp *resp, char *buf) {
+    int32_t code = -1;
+    char *  body = buf + resp->bodyStart;
+    body[resp->bodyLen] = '\0';
+    debugPrint(stdout, "Response: %d\n%s\n", resp->status, body);
+
+    if (resp->status / 100 != 2) {
+        errorPrint(stderr, "Response: %d\n%s\n", resp->status, body);
         goto free_of_post;
     }
-
-    if (NULL != strstr(response_buf, succMessage) && stbInfo->iface == REST_IFACE) {
+    // influxdb write answers 204 without a body
+    if (resp->status == 204) {
         code = 0;
         goto free_of_post;
     }
-    
-    if (NULL != strstr(response_buf, influxHttpOk) &&
-        stbInfo->lineProtocol == TSDB_SML_LINE_PROTOCOL && stbInfo->iface == SML_REST_IFACE) {
+    if (NULL != strstr(body, "succ") && stbInfo->iface == REST_IFACE) {
         code = 0;
         goto free_of_post;
     }
     if (g_arguments->test_mode == INSERT_TEST) {
-        debugPrint(stdout, "Response: \n%s\n", response_buf);
-        char* start = strstr(response_buf, "{");
+        char* start = strstr(body, "{");
         if (start == NULL) {
-            errorPrint(stderr, "Invalid response format: %s\n", response_buf);
+            errorPrint(stderr, "Invalid response format: %s\n", body);
             goto free_of_post;
         }
         tools_cJSON* resObj = tools_cJSON_Parse(start);
         if (resObj == NULL) {
             errorPrint(stderr, "Cannot parse response into json: %s\n", start);
+            goto free_of_post;
         }
         tools_cJSON* codeObj = tools_cJSON_GetObjectItem(resObj, "code");
         if (!tools_cJSON_IsNumber(codeObj)) {
-            errorPrint(stderr, "Invalid or miss 'code' key in json: %s\n", tools_cJSON_Print(resObj));
+            errorPrint(stderr, "Invalid or miss 'code' key in json: %s\n", start);
             tools_cJSON_Delete(resObj);
             goto free_of_post;
         }
         if (codeObj->valueint != 0 &&
-            (stbInfo->iface == SML_REST_IFACE && stbInfo->lineProtocol == TSDB_SML_LINE_PROTOCOL && codeObj->valueint != 200)) {
+            !(stbInfo->iface == SML_REST_IFACE &&
+              stbInfo->lineProtocol == TSDB_SML_LINE_PROTOCOL &&
+              codeObj->valueint == 200)) {
             tools_cJSON* desc = tools_cJSON_GetObjectItem(resObj, "desc");
-            if (!tools_cJSON_IsString(desc)) {
-                errorPrint(stderr, "Invalid or miss 'desc' key in json: %s\n", tools_cJSON_Print(resObj));
-                goto free_of_post;
-            }
-            errorPrint(stderr, "insert mode response, code: %d, reason: %s\n", (int)codeObj->valueint, desc->valuestring);
+            errorPrint(stderr, "insert mode response, code: %d, reason: %s\n",
+                       (int)codeObj->valueint,
+                       tools_cJSON_IsString(desc) ? desc->valuestring : start);
+            code = (int32_t)codeObj->valueint;
             tools_cJSON_Delete(resObj);
             goto free_of_post;
         }
@@ -543,45 +1058,556 @@ int postProceSql(char *sqlstr, threadInfo *pThreadInfo) {
     code = 0;
 free_of_post:
     if (strlen(pThreadInfo->filePath) > 0) {
-        appendResultBufToFile(response_buf, pThreadInfo);
+        appendResultBufToFile(body, pThreadInfo);
     }
-    tmfree(request_buf);
-    tmfree(response_buf);
     return code;
 }
 
-void fetchResult(TAOS_RES *res, threadInfo *pThreadInfo) {
-    TAOS_ROW    row = NULL;
-    int         num_rows = 0;
-    int         num_fields = taos_field_count(res);
-    TAOS_FIELD *fields = taos_fetch_fields(res);
-
-    char *databuf = (char *)benchCalloc(1, FETCH_BUFFER_SIZE, true);
-
-    int64_t totalLen = 0;
+int postProceSql(char *sqlstr, threadInfo *pThreadInfo) {
+    SDataBase *  database = benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
+    SSuperTable *stbInfo = benchArrayGet(database->superTbls, pThreadInfo->stb_index);
+    int64_t      bodyLen = (int64_t)strlen(sqlstr);
+    debugPrint(stdout, "request body: %s\n", sqlstr);
 
-    // fetch the records row by row
-    while ((row = taos_fetch_row(res))) {
-        if (totalLen >= (FETCH_BUFFER_SIZE - HEAD_BUFF_LEN * 2)) {
-            if (strlen(pThreadInfo->filePath) > 0) {
-                appendResultBufToFile(databuf, pThreadInfo);
-            }
-            totalLen = 0;
-            memset(databuf, 0, FETCH_BUFFER_SIZE);
+    if (stbInfo->lineProtocol == TSDB_SML_TELNET_PROTOCOL &&
+        stbInfo->iface == SML_REST_IFACE && stbInfo->tcpTransfer) {
+        char *  data[1] = {sqlstr};
+        int32_t prev = benchPhaseSwitch(pThreadInfo, PHASE_SEND);
+        int     code = sendHttpPieces(pThreadInfo, data, &bodyLen, 1);
+        benchPhaseSwitch(pThreadInfo, prev);
+        if (code) {
+            errorPrint(stderr, "%s", "writing no message to socket\n");
+            return -1;
         }
-        num_rows++;
-        char temp[HEAD_BUFF_LEN] = {0};
-        int  len = taos_print_row(temp, row, fields, num_fields);
-        len += sprintf(temp + len, "\n");
-        debugPrint(stdout, "query result:%s\n", temp);
-        memcpy(databuf + totalLen, temp, len);
-        totalLen += len;
+        return 0;
     }
 
-    if (strlen(pThreadInfo->filePath) > 0) {
-        appendResultBufToFile(databuf, pThreadInfo);
+    if (NULL == pThreadInfo->httpHeader) {
+        buildHttpHeader(pThreadInfo, database, stbInfo);
+        pThreadInfo->httpRespCap =
+            (g_arguments->test_mode == INSERT_TEST)
+                ? RESP_BUF_LEN
+                : g_queryInfo.response_buffer;
+        if (pThreadInfo->httpRespCap < RESP_BUF_LEN) {
+            pThreadInfo->httpRespCap = RESP_BUF_LEN;
+        }
+        pThreadInfo->httpResp =
+            benchCalloc(1, pThreadInfo->httpRespCap, false);
     }
-    free(databuf);
+    char *  payload = sqlstr;
+    int32_t prev = benchPhaseSwitch(pThreadInfo, PHASE_COMPRESS);
+    if (compressHttp()) {
+        bodyLen = compressHttpBody(pThreadInfo, &pThreadInfo->httpDeflate,
+                                   sqlstr, bodyLen, &pThreadInfo->httpBody,
+                                   &pThreadInfo->httpBodyCap);
+        if (bodyLen < 0) {
+            benchPhaseSwitch(pThreadInfo, prev);
+            return -1;
+        }
+        payload = pThreadInfo->httpBody;
+    }
+    char    lengthLine[32];
+    char *  data[3] = {pThreadInfo->httpHeader, lengthLine, payload};
+    int64_t len[3] = {pThreadInfo->httpHeaderLen,
+                      sprintf(lengthLine, "%" PRId64 "\r\n\r\n", bodyLen),
+                      bodyLen};
+
+    // a kept-alive connection may have been closed by the server while idle,
+    // so a request that gets nothing back is retried once on a new one
+    SHttpResp resp;
+    int       ret = 0;
+    for (int attempt = 0; attempt < 2 && ret == 0; attempt++) {
+        benchPhaseSwitch(pThreadInfo, PHASE_SEND);
+        if (pThreadInfo->sockfd < 0 || attempt > 0) {
+            if (reconnectHttp(pThreadInfo)) {
+                benchPhaseSwitch(pThreadInfo, prev);
+                return -1;
+            }
+        }
+        memset(&resp, 0, sizeof(resp));
+        resp.contentLength = -1;
+        resp.chunkLeft = HTTP_CHUNK_SIZE;
+        if (sendHttpPieces(pThreadInfo, data, len, 3)) {
+            continue;
+        }
+        benchPhaseSwitch(pThreadInfo, PHASE_WAIT);
+        ret = recvHttpResponse(pThreadInfo, &resp);
+    }
+    benchPhaseSwitch(pThreadInfo, prev);
+    if (ret <= 0) {
+        if (ret == 0) {
+            errorPrint(stderr, "%s", "writing no message to socket\n");
+        } else {
+            errorPrint(stderr, "%s", "malformed http response\n");
+        }
+        closeHttpSocket(pThreadInfo);
+        return -1;
+    }
+    if (resp.close) {
+        closeHttpSocket(pThreadInfo);
+    }
+
+    return checkHttpResponse(pThreadInfo, stbInfo, &resp,
+                             pThreadInfo->httpResp);
+}
+
+#ifdef LINUX
+#define REST_CONN_IDLE      0
+#define REST_CONN_SENDING   1
+#define REST_CONN_RECEIVING 2
+
+// one non-blocking keep-alive connection of the event loop engine
+typedef struct SRestConn_S {
+    int32_t             sockfd;
+    int32_t             state;
+    char *              body;
+    int64_t             bodyLen;
+    char *              zbuf;  // compressed body
+    uint64_t            zcap;
+    void *              param;
+    char                lengthLine[32];
+    struct iovec        iov[3];
+    int32_t             iovFirst;
+    SHttpResp           resp;
+    char *              respBuf;
+    uint64_t            respCap;
+    int64_t             received;
+    int64_t             startTs;
+    bool                retried;
+    struct SRestConn_S *next;
+} SRestConn;
+
+// a loop thread multiplexing many connections through epoll, so the number
+// of concurrent clients does not require as many threads
+typedef struct SRestEngine_S {
+    threadInfo *    pThreadInfo;
+    SSuperTable *   stbInfo;
+    SRestConn *     conns;
+    uint32_t        size;
+    uint32_t        busy;
+    SRestConn *     idle;
+    SRestConn *     ready;
+    int             epfd;
+    int             wakefd;
+    bool            closing;
+    void *          deflate;  // used by the submitting thread only
+    restDoneFp      fp;
+    pthread_t       loop;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} SRestEngine;
+
+static void watchRestConn(SRestEngine *engine, SRestConn *conn, uint32_t events,
+                          int op) {
+    struct epoll_event ev = {0};
+    ev.events = events;
+    ev.data.ptr = conn;
+    epoll_ctl(engine->epfd, op, conn->sockfd, &ev);
+}
+
+static void closeRestConn(SRestEngine *engine, SRestConn *conn) {
+    if (conn->sockfd >= 0) {
+        epoll_ctl(engine->epfd, EPOLL_CTL_DEL, conn->sockfd, NULL);
+        close(conn->sockfd);
+        conn->sockfd = -1;
+    }
+}
+
+static int openRestConn(SRestEngine *engine, SRestConn *conn) {
+    closeRestConn(engine, conn);
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        errorPrint(stderr, "failed to create socket, reason: %s\n",
+                   strerror(errno));
+        return -1;
+    }
+    if (connect(sockfd, (struct sockaddr *)&(g_arguments->serv_addr),
+                sizeof(struct sockaddr)) < 0) {
+        errorPrint(stderr, "failed to connect, reason: %s\n", strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK);
+    conn->sockfd = sockfd;
+    watchRestConn(engine, conn, EPOLLIN, EPOLL_CTL_ADD);
+    return 0;
+}
+
+static void finishRestConn(SRestEngine *engine, SRestConn *conn,
+                           int32_t code) {
+    int64_t endTs = toolsGetTimestampUs();
+    if (code != 0 || conn->resp.close) {
+        closeRestConn(engine, conn);
+    } else {
+        watchRestConn(engine, conn, EPOLLIN, EPOLL_CTL_MOD);
+    }
+    conn->state = REST_CONN_IDLE;
+    engine->fp(conn->param, code, conn->startTs, endTs);
+    pthread_mutex_lock(&engine->mutex);
+    conn->next = engine->idle;
+    engine->idle = conn;
+    engine->busy--;
+    pthread_cond_broadcast(&engine->cond);
+    pthread_mutex_unlock(&engine->mutex);
+}
+
+// write as much of the request as the socket takes, then wait for the
+// response; returns -1 when the connection is broken
+static int flushRestConn(SRestEngine *engine, SRestConn *conn) {
+    while (conn->iovFirst < 3) {
+        struct msghdr msg = {0};
+        msg.msg_iov = conn->iov + conn->iovFirst;
+        msg.msg_iovlen = 3 - conn->iovFirst;
+        ssize_t bytes = sendmsg(conn->sockfd, &msg, MSG_NOSIGNAL);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watchRestConn(engine, conn, EPOLLOUT, EPOLL_CTL_MOD);
+                return 0;
+            }
+            return -1;
+        }
+        while (conn->iovFirst < 3 &&
+               (size_t)bytes >= conn->iov[conn->iovFirst].iov_len) {
+            bytes -= conn->iov[conn->iovFirst].iov_len;
+            conn->iovFirst++;
+        }
+        if (conn->iovFirst < 3) {
+            conn->iov[conn->iovFirst].iov_base =
+                (char *)conn->iov[conn->iovFirst].iov_base + bytes;
+            conn->iov[conn->iovFirst].iov_len -= bytes;
+        }
+    }
+    conn->state = REST_CONN_RECEIVING;
+    watchRestConn(engine, conn, EPOLLIN, EPOLL_CTL_MOD);
+    return 0;
+}
+
+static void startRestConn(SRestEngine *engine, SRestConn *conn) {
+    threadInfo *pThreadInfo = engine->pThreadInfo;
+    int64_t     bodyLen = conn->bodyLen;
+    conn->iov[0].iov_base = pThreadInfo->httpHeader;
+    conn->iov[0].iov_len = pThreadInfo->httpHeaderLen;
+    conn->iov[1].iov_base = conn->lengthLine;
+    conn->iov[1].iov_len =
+        sprintf(conn->lengthLine, "%" PRId64 "\r\n\r\n", bodyLen);
+    conn->iov[2].iov_base = conn->body;
+    conn->iov[2].iov_len = bodyLen;
+    conn->iovFirst = 0;
+    memset(&conn->resp, 0, sizeof(conn->resp));
+    conn->resp.contentLength = -1;
+    conn->resp.chunkLeft = HTTP_CHUNK_SIZE;
+    conn->received = 0;
+    conn->state = REST_CONN_SENDING;
+    if ((conn->sockfd < 0 && openRestConn(engine, conn)) ||
+        flushRestConn(engine, conn)) {
+        // the server may have dropped an idle keep-alive connection
+        if (!conn->retried) {
+            conn->retried = true;
+            closeRestConn(engine, conn);
+            startRestConn(engine, conn);
+            return;
+        }
+        errorPrint(stderr, "%s", "writing no message to socket\n");
+        finishRestConn(engine, conn, -1);
+    }
+}
+
+static void readRestConn(SRestEngine *engine, SRestConn *conn) {
+    while (true) {
+        if (conn->received + 1 >= (int64_t)conn->respCap) {
+            conn->respCap *= 2;
+            char *grown = realloc(conn->respBuf, conn->respCap);
+            if (NULL == grown) {
+                errorPrint(stderr, "%s", "failed to grow response buffer\n");
+                finishRestConn(engine, conn, -1);
+                return;
+            }
+            conn->respBuf = grown;
+        }
+        ssize_t bytes = read(conn->sockfd, conn->respBuf + conn->received,
+                             conn->respCap - conn->received - 1);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (conn->state == REST_CONN_IDLE) {
+            // the server closed or spoke out of turn on an idle connection
+            closeRestConn(engine, conn);
+            return;
+        }
+        if (bytes <= 0) {
+            if (0 == conn->received && !conn->retried) {
+                conn->retried = true;
+                closeRestConn(engine, conn);
+                startRestConn(engine, conn);
+                return;
+            }
+            if (0 == bytes && conn->resp.bodyStart > 0 &&
+                !conn->resp.chunked && conn->resp.contentLength < 0) {
+                finishRestConn(engine, conn,
+                               checkHttpResponse(engine->pThreadInfo,
+                                                 engine->stbInfo, &conn->resp,
+                                                 conn->respBuf));
+                return;
+            }
+            errorPrint(stderr, "%s", "reading no response from socket\n");
+            finishRestConn(engine, conn, -1);
+            return;
+        }
+        conn->received += bytes;
+        int ret = parseHttpResponse(&conn->resp, conn->respBuf, conn->received);
+        if (ret < 0) {
+            errorPrint(stderr, "%s", "malformed http response\n");
+            finishRestConn(engine, conn, -1);
+            return;
+        }
+        if (ret > 0) {
+            finishRestConn(engine, conn,
+                           checkHttpResponse(engine->pThreadInfo,
+                                             engine->stbInfo, &conn->resp,
+                                             conn->respBuf));
+            return;
+        }
+    }
+}
+
+static void *restEngineLoop(void *arg) {
+    SRestEngine *      engine = (SRestEngine *)arg;
+    struct epoll_event events[64];
+    prctl(PR_SET_NAME, "restEngineLoop");
+    while (true) {
+        int n = epoll_wait(engine->epfd, events, 64, -1);
+        if (n < 0 && errno != EINTR) {
+            errorPrint(stderr, "epoll_wait failed, reason: %s\n",
+                       strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            SRestConn *conn = events[i].data.ptr;
+            if (conn == NULL) {
+                uint64_t count;
+                if (read(engine->wakefd, &count, sizeof(count)) < 0) {
+                    debugPrint(stdout, "%s", "spurious engine wakeup\n");
+                }
+                pthread_mutex_lock(&engine->mutex);
+                SRestConn *ready = engine->ready;
+                engine->ready = NULL;
+                bool closing = engine->closing;
+                pthread_mutex_unlock(&engine->mutex);
+                if (closing) {
+                    return NULL;
+                }
+                while (ready) {
+                    SRestConn *next = ready->next;
+                    ready->retried = false;
+                    ready->startTs = toolsGetTimestampUs();
+                    startRestConn(engine, ready);
+                    ready = next;
+                }
+                continue;
+            }
+            if (conn->sockfd < 0) {
+                continue;
+            }
+            if (conn->state == REST_CONN_SENDING &&
+                (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                if (flushRestConn(engine, conn)) {
+                    errorPrint(stderr, "%s",
+                               "writing no message to socket\n");
+                    finishRestConn(engine, conn, -1);
+                }
+                continue;
+            }
+            readRestConn(engine, conn);
+        }
+    }
+    return NULL;
+}
+
+SRestEngine *restEngineCreate(threadInfo *pThreadInfo, uint32_t connections,
+                              restDoneFp fp) {
+    SDataBase *  database =
+        benchArrayGet(g_arguments->databases, pThreadInfo->db_index);
+    SSuperTable *stbInfo =
+        benchArrayGet(database->superTbls, pThreadInfo->stb_index);
+    SRestEngine *engine = benchCalloc(1, sizeof(SRestEngine), false);
+    engine->pThreadInfo = pThreadInfo;
+    engine->stbInfo = stbInfo;
+    engine->size = connections;
+    engine->fp = fp;
+    engine->epfd = epoll_create1(0);
+    engine->wakefd = eventfd(0, EFD_NONBLOCK);
+    if (engine->epfd < 0 || engine->wakefd < 0) {
+        errorPrint(stderr, "failed to create rest engine, reason: %s\n",
+                   strerror(errno));
+        if (engine->epfd >= 0) {
+            close(engine->epfd);
+        }
+        if (engine->wakefd >= 0) {
+            close(engine->wakefd);
+        }
+        tmfree(engine);
+        return NULL;
+    }
+    if (NULL == pThreadInfo->httpHeader) {
+        buildHttpHeader(pThreadInfo, database, stbInfo);
+    }
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(engine->epfd, EPOLL_CTL_ADD, engine->wakefd, &ev);
+
+    uint64_t respCap = (g_arguments->test_mode == INSERT_TEST)
+                           ? RESP_BUF_LEN
+                           : g_queryInfo.response_buffer;
+    if (respCap < RESP_BUF_LEN) {
+        respCap = RESP_BUF_LEN;
+    }
+    engine->conns = benchCalloc(connections, sizeof(SRestConn), false);
+    for (uint32_t i = 0; i < connections; i++) {
+        engine->conns[i].sockfd = -1;
+    }
+    for (uint32_t i = 0; i < connections; i++) {
+        SRestConn *conn = engine->conns + i;
+        conn->respCap = respCap;
+        conn->respBuf = benchCalloc(1, respCap, false);
+        if (openRestConn(engine, conn)) {
+            restEngineDestroy(engine);
+            return NULL;
+        }
+        conn->next = engine->idle;
+        engine->idle = conn;
+    }
+    pthread_mutex_init(&engine->mutex, NULL);
+    pthread_cond_init(&engine->cond, NULL);
+    pthread_create(&engine->loop, NULL, restEngineLoop, engine);
+    return engine;
+}
+
+// queue body on an idle connection, blocking while all of them are busy;
+// body must stay valid until fp is called with param
+void restEngineSubmit(SRestEngine *engine, char *body, void *param) {
+    pthread_mutex_lock(&engine->mutex);
+    while (engine->idle == NULL) {
+        pthread_cond_wait(&engine->cond, &engine->mutex);
+    }
+    SRestConn *conn = engine->idle;
+    engine->idle = conn->next;
+    engine->busy++;
+    pthread_mutex_unlock(&engine->mutex);
+
+    // compress on the submitting thread, the loop only moves bytes
+    conn->body = body;
+    conn->bodyLen = (int64_t)strlen(body);
+    conn->param = param;
+    if (compressHttp()) {
+        int32_t prev = benchPhaseSwitch(engine->pThreadInfo, PHASE_COMPRESS);
+        conn->bodyLen =
+            compressHttpBody(engine->pThreadInfo, &engine->deflate, body,
+                             conn->bodyLen, &conn->zbuf, &conn->zcap);
+        benchPhaseSwitch(engine->pThreadInfo, prev);
+        if (conn->bodyLen < 0) {
+            int64_t now = toolsGetTimestampUs();
+            engine->fp(param, -1, now, now);
+            pthread_mutex_lock(&engine->mutex);
+            conn->next = engine->idle;
+            engine->idle = conn;
+            engine->busy--;
+            pthread_cond_broadcast(&engine->cond);
+            pthread_mutex_unlock(&engine->mutex);
+            return;
+        }
+        conn->body = conn->zbuf;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    conn->next = engine->ready;
+    engine->ready = conn;
+    pthread_mutex_unlock(&engine->mutex);
+    uint64_t one = 1;
+    if (write(engine->wakefd, &one, sizeof(one)) < 0) {
+        errorPrint(stderr, "failed to wake rest engine, reason: %s\n",
+                   strerror(errno));
+    }
+}
+
+void restEngineDrain(SRestEngine *engine) {
+    pthread_mutex_lock(&engine->mutex);
+    while (engine->busy > 0) {
+        pthread_cond_wait(&engine->cond, &engine->mutex);
+    }
+    pthread_mutex_unlock(&engine->mutex);
+}
+
+void restEngineDestroy(SRestEngine *engine) {
+    if (engine->loop) {
+        restEngineDrain(engine);
+        pthread_mutex_lock(&engine->mutex);
+        engine->closing = true;
+        pthread_mutex_unlock(&engine->mutex);
+        uint64_t one = 1;
+        if (write(engine->wakefd, &one, sizeof(one)) < 0) {
+            errorPrint(stderr, "failed to stop rest engine, reason: %s\n",
+                       strerror(errno));
+        }
+        pthread_join(engine->loop, NULL);
+        pthread_mutex_destroy(&engine->mutex);
+        pthread_cond_destroy(&engine->cond);
+    }
+    for (uint32_t i = 0; i < engine->size; i++) {
+        closeRestConn(engine, engine->conns + i);
+        tmfree(engine->conns[i].respBuf);
+        tmfree(engine->conns[i].zbuf);
+    }
+    freeDeflateStream(&engine->deflate);
+    close(engine->wakefd);
+    close(engine->epfd);
+    tmfree(engine->conns);
+    tmfree(engine);
+}
+#endif
+
+int fetchResult(TAOS_RES *res, threadInfo *pThreadInfo) {
+    TAOS_ROW    row = NULL;
+    int         num_rows = 0;
+    int         num_fields = taos_field_count(res);
+    TAOS_FIELD *fields = taos_fetch_fields(res);
+
+    char *databuf = (char *)benchCalloc(1, FETCH_BUFFER_SIZE, true);
+
+    int64_t totalLen = 0;
+
+    // fetch the records row by row
+    while ((row = taos_fetch_row(res))) {
+        if (totalLen >= (FETCH_BUFFER_SIZE - HEAD_BUFF_LEN * 2)) {
+            if (strlen(pThreadInfo->filePath) > 0) {
+                appendResultBufToFile(databuf, pThreadInfo);
+            }
+            totalLen = 0;
+            memset(databuf, 0, FETCH_BUFFER_SIZE);
+        }
+        num_rows++;
+        char temp[HEAD_BUFF_LEN] = {0};
+        int  len = taos_print_row(temp, row, fields, num_fields);
+        len += sprintf(temp + len, "\n");
+        debugPrint(stdout, "query result:%s\n", temp);
+        memcpy(databuf + totalLen, temp, len);
+        totalLen += len;
+    }
+
+    if (strlen(pThreadInfo->filePath) > 0) {
+        appendResultBufToFile(databuf, pThreadInfo);
+    }
+    free(databuf);
+    pThreadInfo->fetchedRows += num_rows;
+    return num_rows;
 }
 
 char *taos_convert_datatype_to_string(int type) {
@@ -786,6 +1812,34 @@ int taos_convert_string_to_datatype(char *type, int length) {
     }
 }
 
+#define POOL_CONNECT_THREADS 32
+
+typedef struct SPoolConnector_S {
+    TAOS_POOL *pool;
+    int        from;
+    int        step;
+    int        failed;
+} SPoolConnector;
+
+static void *connectPoolRange(void *arg) {
+    SPoolConnector *connector = (SPoolConnector *)arg;
+    TAOS_POOL *     pool = connector->pool;
+    for (int i = connector->from; i < pool->size; i += connector->step) {
+        int64_t start = toolsGetTimestampUs();
+        pool->taos_list[i] =
+            taos_connect(g_arguments->host, g_arguments->user,
+                         g_arguments->password, NULL, g_arguments->port);
+        pool->connect_us[i] = toolsGetTimestampUs() - start;
+        if (pool->taos_list[i] == NULL) {
+            errorPrint(stderr, "Failed to connect to TDengine, reason:%s\n",
+                       taos_errstr(NULL));
+            connector->failed = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
 int init_taos_list() {
 #ifdef LINUX
     if (strlen(configDir)) {
@@ -798,61 +1852,273 @@ int init_taos_list() {
         wordfree(&full_path);
     }
 #endif
-    int        size = g_arguments->connection_pool;
+    int size = g_arguments->connection_pool;
+    // room for every insert thread to own its connections
+    if (g_arguments->connections_per_thread > 0 &&
+        size < (int)(g_arguments->nthreads *
+                     g_arguments->connections_per_thread)) {
+        size = g_arguments->nthreads * g_arguments->connections_per_thread;
+    }
     TAOS_POOL *pool = g_arguments->pool;
     pool->taos_list = benchCalloc(size, sizeof(TAOS *), true);
+    pool->db_list = benchCalloc(size, sizeof(char *), true);
+    pool->connect_us = benchCalloc(size, sizeof(int64_t), true);
+    pthread_mutex_init(&pool->mutex, NULL);
     pool->current = 0;
     pool->size = size;
-    for (int i = 0; i < size; ++i) {
-        pool->taos_list[i] =
-            taos_connect(g_arguments->host, g_arguments->user,
-                         g_arguments->password, NULL, g_arguments->port);
-        if (pool->taos_list[i] == NULL) {
-            errorPrint(stderr, "Failed to connect to TDengine, reason:%s\n",
-                       taos_errstr(NULL));
-            return -1;
+
+    // taos_connect is mostly waiting on the server, so open them in parallel
+    int connectors = size < POOL_CONNECT_THREADS ? size : POOL_CONNECT_THREADS;
+    pthread_t *     pids = benchCalloc(connectors, sizeof(pthread_t), false);
+    SPoolConnector *args =
+        benchCalloc(connectors, sizeof(SPoolConnector), false);
+    int64_t start = toolsGetTimestampUs();
+    int     failed = 0;
+    int     started = 0;
+    for (; started < connectors; started++) {
+        args[started].pool = pool;
+        args[started].from = started;
+        args[started].step = connectors;
+        int code = pthread_create(pids + started, NULL, connectPoolRange,
+                                  args + started);
+        if (code) {
+            errorPrint(stderr, "failed to start connecting thread: %s\n",
+                       strerror(code));
+            failed = 1;
+            break;
         }
     }
+    for (int i = 0; i < started; i++) {
+        pthread_join(pids[i], NULL);
+        failed |= args[i].failed;
+    }
+    int64_t spent = toolsGetTimestampUs() - start;
+    tmfree(pids);
+    tmfree(args);
+    if (failed) {
+        return -1;
+    }
+
+    SLatencyHist hist;
+    benchHistInit(&hist, g_arguments->latency_max);
+    for (int i = 0; i < size; i++) {
+        benchHistRecord(&hist, pool->connect_us[i]);
+    }
+    infoPrint(stdout, "opened %d connection(s) in %.4f seconds with %d "
+              "thread(s)\n", size, spent / 1E6, connectors);
+    benchHistPrint(stdout, "connect delay", &hist, 1000.0, "ms");
+    benchHistDestroy(&hist);
     return 0;
 }
 
-TAOS *select_one_from_pool(char *db_name) {
+// select db_name on taos unless it is already the connection's database
+static int selectPoolDb(int index, char *db_name) {
     TAOS_POOL *pool = g_arguments->pool;
-    TAOS *     taos = pool->taos_list[pool->current];
-    if (db_name != NULL) {
-        int code = taos_select_db(taos, db_name);
-        if (code) {
-            errorPrint(stderr, "failed to select %s, reason: %s\n", db_name,
-                       taos_errstr(NULL));
-            return NULL;
-        }
+    pthread_mutex_lock(&pool->mutex);
+    bool cached = pool->db_list[index] != NULL &&
+                  0 == strcmp(pool->db_list[index], db_name);
+    pthread_mutex_unlock(&pool->mutex);
+    if (cached) {
+        return 0;
     }
+    int code = taos_select_db(pool->taos_list[index], db_name);
+    if (code) {
+        errorPrint(stderr, "failed to select %s, reason: %s\n", db_name,
+                   taos_errstr(NULL));
+        return -1;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    tmfree(pool->db_list[index]);
+    pool->db_list[index] = strdup(db_name);
+    pthread_mutex_unlock(&pool->mutex);
+    return 0;
+}
+
+TAOS *select_one_from_pool(char *db_name) {
+    TAOS_POOL *pool = g_arguments->pool;
+    pthread_mutex_lock(&pool->mutex);
+    int index = pool->current;
     pool->current++;
     if (pool->current >= pool->size) {
         pool->current = 0;
     }
-    return taos;
+    pthread_mutex_unlock(&pool->mutex);
+    if (db_name != NULL && selectPoolDb(index, db_name)) {
+        return NULL;
+    }
+    return pool->taos_list[index];
+}
+
+// k-th connection owned by thread threadID, threads never share connections
+// as long as the pool holds connections_per_thread for each of them
+TAOS *select_thread_conn(uint32_t threadID, uint32_t k, char *db_name) {
+    TAOS_POOL *pool = g_arguments->pool;
+    uint32_t   perThread = g_arguments->connections_per_thread;
+    if (perThread == 0) {
+        perThread = 1;
+    }
+    int index = (int)(((uint64_t)threadID * perThread + k % perThread) %
+                      pool->size);
+    if (db_name != NULL && selectPoolDb(index, db_name)) {
+        return NULL;
+    }
+    return pool->taos_list[index];
 }
 
 void cleanup_taos_list() {
-    for (int i = 0; i < g_arguments->pool->size; ++i) {
-        taos_close(g_arguments->pool->taos_list[i]);
+    TAOS_POOL *pool = g_arguments->pool;
+    for (int i = 0; i < pool->size; ++i) {
+        taos_close(pool->taos_list[i]);
+        tmfree(pool->db_list[i]);
+    }
+    tmfree(pool->taos_list);
+    tmfree(pool->db_list);
+    tmfree(pool->connect_us);
+    pthread_mutex_destroy(&pool->mutex);
+}
+// values below HIST_LINEAR_BUCKETS get one bucket each, above that every
+// power of two is split into HIST_SUB_BUCKETS, so the error stays under 1/64
+#define HIST_LINEAR_BUCKETS 128
+#define HIST_SUB_BUCKETS    64
+
+static uint32_t histIndex(uint64_t value) {
+    if (value < HIST_LINEAR_BUCKETS) {
+        return (uint32_t)value;
+    }
+    uint32_t shift = 0;
+    while ((value >> shift) >= HIST_LINEAR_BUCKETS) {
+        shift++;
     }
-    tmfree(g_arguments->pool->taos_list);
+    return HIST_LINEAR_BUCKETS + (shift - 1) * HIST_SUB_BUCKETS +
+           (uint32_t)((value >> shift) - HIST_SUB_BUCKETS);
 }
-void delay_list_init(delayList *list) {
-    list->size = 0;
-    list->head = NULL;
-    list->tail = NULL;
+
+// highest value that falls into the bucket
+static uint64_t histBucketHigh(uint32_t index) {
+    if (index < HIST_LINEAR_BUCKETS) {
+        return index;
+    }
+    uint32_t j = index - HIST_LINEAR_BUCKETS;
+    uint32_t shift = j / HIST_SUB_BUCKETS + 1;
+    uint64_t sub = HIST_SUB_BUCKETS + j % HIST_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void benchHistInit(SLatencyHist *hist, uint64_t highest) {
+    if (highest < HIST_LINEAR_BUCKETS) {
+        highest = HIST_LINEAR_BUCKETS;
+    }
+    hist->highest = highest;
+    hist->size = histIndex(highest) + 1;
+    hist->counts = benchCalloc(hist->size, sizeof(uint64_t), false);
+    hist->count = 0;
+    hist->total = 0;
+    hist->min = UINT64_MAX;
+    hist->max = 0;
+}
+
+void benchHistDestroy(SLatencyHist *hist) {
+    tmfree(hist->counts);
+    hist->counts = NULL;
+    hist->size = 0;
+}
+
+void benchHistRecord(SLatencyHist *hist, uint64_t value) {
+    // values beyond the range land in the last bucket, min/max stay exact
+    uint64_t clamped = value > hist->highest ? hist->highest : value;
+    hist->counts[histIndex(clamped)]++;
+    hist->count++;
+    hist->total += value;
+    if (value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+}
+
+void benchHistMerge(SLatencyHist *dst, SLatencyHist *src) {
+    if (src->count == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < src->size; i++) {
+        if (src->counts[i] == 0) {
+            continue;
+        }
+        uint32_t index = i < dst->size ? i : dst->size - 1;
+        dst->counts[index] += src->counts[i];
+    }
+    dst->count += src->count;
+    dst->total += src->total;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t benchHistPercentile(SLatencyHist *hist, double percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    double   rank = percentile / 100.0 * hist->count;
+    uint64_t target = (uint64_t)rank;
+    if (target < rank || target == 0) target++;
+    uint64_t cumulative = 0;
+    for (uint32_t i = 0; i < hist->size; i++) {
+        cumulative += hist->counts[i];
+        if (cumulative >= target) {
+            uint64_t value = histBucketHigh(i);
+            if (value > hist->max) value = hist->max;
+            if (value < hist->min) value = hist->min;
+            return value;
+        }
+    }
+    return hist->max;
+}
+
+void benchHistPrint(FILE *fp, const char *title, SLatencyHist *hist,
+                    double divisor, const char *unit) {
+    if (hist->count == 0) {
+        return;
+    }
+    int prec = divisor >= 1E6 ? 6 : 2;
+    infoPrint(fp,
+              "%s, min: %.*f%s, avg: %.*f%s, p50: %.*f%s, p90: %.*f%s, "
+              "p95: %.*f%s, p99: %.*f%s, p99.9: %.*f%s, p99.99: %.*f%s, "
+              "max: %.*f%s\n\n",
+              title, prec, hist->min / divisor, unit,
+              prec, (double)hist->total / hist->count / divisor, unit,
+              prec, benchHistPercentile(hist, 50) / divisor, unit,
+              prec, benchHistPercentile(hist, 90) / divisor, unit,
+              prec, benchHistPercentile(hist, 95) / divisor, unit,
+              prec, benchHistPercentile(hist, 99) / divisor, unit,
+              prec, benchHistPercentile(hist, 99.9) / divisor, unit,
+              prec, benchHistPercentile(hist, 99.99) / divisor, unit,
+              prec, hist->max / divisor, unit);
 }
 
-void delay_list_destroy(delayList *list) {
-    while (list->size > 0) {
-        delayNode *current = list->head;
-        list->head = list->head->next;
-        tmfree(current);
-        list->size--;
+// append the non-empty buckets to latency_dump_file so runs can be
+// compared offline
+int benchHistDump(SLatencyHist *hist, const char *label) {
+    if (g_arguments->latency_dump_file == NULL || hist->count == 0) {
+        return 0;
+    }
+    FILE *fp = fopen(g_arguments->latency_dump_file, "a");
+    if (fp == NULL) {
+        errorPrint(stderr, "failed to open latency dump file %s: %s\n",
+                   g_arguments->latency_dump_file, strerror(errno));
+        return -1;
     }
+    fprintf(fp, "# %s count: %" PRIu64 ", min: %" PRIu64 "us, max: %" PRIu64
+            "us, avg: %.2fus\n", label, hist->count, hist->min, hist->max,
+            (double)hist->total / hist->count);
+    fprintf(fp, "# value(us) count percentile\n");
+    uint64_t cumulative = 0;
+    for (uint32_t i = 0; i < hist->size; i++) {
+        if (hist->counts[i] == 0) {
+            continue;
+        }
+        cumulative += hist->counts[i];
+        fprintf(fp, "%" PRIu64 " %" PRIu64 " %.6f\n", histBucketHigh(i),
+                hist->counts[i], cumulative * 100.0 / hist->count);
+    }
+    fprintf(fp, "\n");
+    fclose(fp);
+    return 0;
 }
 
 int compare(const void *a, const void *b) {
@@ -950,4 +2216,1361 @@ void benchSetSignal(int32_t signum, FSignalHandler sigfp) {
     act.sa_sigaction = (void (*)(int, siginfo_t *, void *)) sigfp;
     sigaction(signum, &act, NULL);
 }
-#endif
\ No newline at end of file
+#endif
+
+// samples every registered slot each stats_interval_ms and appends one
+// record per label plus an aggregate to stats_file
+typedef struct SStatsSampler_S {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    pthread_t       thread;
+    SStatsSlot *    slots;
+    FILE *          fp;
+    bool            running;
+    int64_t         startTs;
+    int64_t         lastTs;
+} SStatsSampler;
+
+static SStatsSampler g_sampler;
+
+typedef struct SStatsSum_S {
+    uint64_t     rows;
+    uint64_t     requests;
+    uint64_t     bytes;
+    uint64_t     errors;
+    int64_t      inflight;
+    SLatencyHist hist;
+} SStatsSum;
+
+static void benchHistReset(SLatencyHist *hist) {
+    memset(hist->counts, 0, hist->size * sizeof(uint64_t));
+    hist->count = 0;
+    hist->total = 0;
+    hist->min = UINT64_MAX;
+    hist->max = 0;
+}
+
+// take the slot's interval counters, leaving it ready for the next one
+static void drainStatsSlot(SStatsSlot *slot, SStatsSum *sum) {
+    pthread_mutex_lock(&slot->mutex);
+    sum->rows += slot->rows;
+    sum->requests += slot->requests;
+    sum->bytes += slot->bytes;
+    sum->errors += slot->errors;
+    sum->inflight += slot->inflight;
+    benchHistMerge(&sum->hist, &slot->hist);
+    slot->rows = 0;
+    slot->requests = 0;
+    slot->bytes = 0;
+    slot->errors = 0;
+    benchHistReset(&slot->hist);
+    pthread_mutex_unlock(&slot->mutex);
+}
+
+static void writeStatsRecord(int64_t now, const char *label, SStatsSum *sum,
+                             double seconds) {
+    // an agent without stats_file only forwards to its controller
+    if (g_sampler.fp == NULL) {
+        return;
+    }
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;
+    if (sum->hist.count) {
+        p50 = benchHistPercentile(&sum->hist, 50) / 1000.0;
+        p90 = benchHistPercentile(&sum->hist, 90) / 1000.0;
+        p99 = benchHistPercentile(&sum->hist, 99) / 1000.0;
+        max = sum->hist.max / 1000.0;
+    }
+    double elapsed = (now - g_sampler.startTs) / 1E6;
+    if (g_arguments->stats_format == STATS_FORMAT_CSV) {
+        fprintf(g_sampler.fp,
+                "%" PRId64 ",%.3f,%s,%.2f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,"
+                "%" PRIu64 ",%" PRId64 "\n",
+                now / 1000, elapsed, label, sum->rows / seconds,
+                sum->requests / seconds, sum->bytes / seconds, p50, p90, p99,
+                max, sum->errors, sum->inflight);
+    } else {
+        fprintf(g_sampler.fp,
+                "{\"ts\":%" PRId64 ",\"elapsed\":%.3f,\"label\":\"%s\","
+                "\"rows_per_sec\":%.2f,\"requests_per_sec\":%.2f,"
+                "\"bytes_per_sec\":%.2f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,"
+                "\"p99_ms\":%.3f,\"max_ms\":%.3f,\"errors\":%" PRIu64
+                ",\"inflight\":%" PRId64 "}\n",
+                now / 1000, elapsed, label, sum->rows / seconds,
+                sum->requests / seconds, sum->bytes / seconds, p50, p90, p99,
+                max, sum->errors, sum->inflight);
+    }
+}
+
+static void sampleStats() {
+    int64_t now = toolsGetTimestampUs();
+    double  seconds = (now - g_sampler.lastTs) / 1E6;
+    if (seconds <= 0) {
+        return;
+    }
+    g_sampler.lastTs = now;
+    SStatsSum total = {0};
+    benchHistInit(&total.hist, g_arguments->latency_max);
+    pthread_mutex_lock(&g_sampler.mutex);
+    for (SStatsSlot *slot = g_sampler.slots; slot; slot = slot->next) {
+        bool seen = false;
+        for (SStatsSlot *prev = g_sampler.slots; prev != slot && !seen;
+             prev = prev->next) {
+            seen = 0 == strcmp(prev->label, slot->label);
+        }
+        if (seen) {
+            continue;
+        }
+        SStatsSum sum = {0};
+        benchHistInit(&sum.hist, g_arguments->latency_max);
+        for (SStatsSlot *same = slot; same; same = same->next) {
+            if (0 == strcmp(same->label, slot->label)) {
+                drainStatsSlot(same, &sum);
+            }
+        }
+        writeStatsRecord(now, slot->label, &sum, seconds);
+        total.rows += sum.rows;
+        total.requests += sum.requests;
+        total.bytes += sum.bytes;
+        total.errors += sum.errors;
+        total.inflight += sum.inflight;
+        benchHistMerge(&total.hist, &sum.hist);
+        benchHistDestroy(&sum.hist);
+    }
+    pthread_mutex_unlock(&g_sampler.mutex);
+    writeStatsRecord(now, "all", &total, seconds);
+    benchAgentStats(now, total.rows, total.requests, total.bytes, total.errors,
+                    total.inflight, &total.hist);
+    benchHistDestroy(&total.hist);
+    if (g_sampler.fp) {
+        fflush(g_sampler.fp);
+    }
+}
+
+static void *statsSampler(void *arg) {
+#ifdef LINUX
+    prctl(PR_SET_NAME, "statsSampler");
+#endif
+    pthread_mutex_lock(&g_sampler.mutex);
+    while (g_sampler.running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = deadline.tv_nsec +
+                      (uint64_t)g_arguments->stats_interval_ms * 1000000;
+        deadline.tv_sec += ns / 1000000000;
+        deadline.tv_nsec = ns % 1000000000;
+        pthread_cond_timedwait(&g_sampler.cond, &g_sampler.mutex, &deadline);
+        pthread_mutex_unlock(&g_sampler.mutex);
+        sampleStats();
+        pthread_mutex_lock(&g_sampler.mutex);
+    }
+    pthread_mutex_unlock(&g_sampler.mutex);
+    return NULL;
+}
+
+int benchStatsStart() {
+    // a controller writes the series merged from its agents instead
+    if (g_arguments->stats_interval_ms == 0 || g_arguments->agents ||
+        (g_arguments->stats_file == NULL && g_arguments->agent_count == 0)) {
+        return 0;
+    }
+    if (g_arguments->stats_file) {
+        g_sampler.fp = fopen(g_arguments->stats_file, "w");
+        if (g_sampler.fp == NULL) {
+            errorPrint(stderr, "failed to open stats file %s: %s\n",
+                       g_arguments->stats_file, strerror(errno));
+            return -1;
+        }
+    }
+    if (g_sampler.fp && g_arguments->stats_format == STATS_FORMAT_CSV) {
+        fprintf(g_sampler.fp,
+                "timestamp_ms,elapsed_s,label,rows_per_sec,requests_per_sec,"
+                "bytes_per_sec,p50_ms,p90_ms,p99_ms,max_ms,errors,inflight\n");
+    }
+    pthread_mutex_init(&g_sampler.mutex, NULL);
+    pthread_cond_init(&g_sampler.cond, NULL);
+    g_sampler.startTs = toolsGetTimestampUs();
+    g_sampler.lastTs = g_sampler.startTs;
+    g_sampler.running = true;
+    pthread_create(&g_sampler.thread, NULL, statsSampler, NULL);
+    return 0;
+}
+
+SStatsSlot *benchStatsRegister(const char *label) {
+    if (!g_sampler.running) {
+        return NULL;
+    }
+    SStatsSlot *slot = benchCalloc(1, sizeof(SStatsSlot), true);
+    pthread_mutex_init(&slot->mutex, NULL);
+    slot->label = label;
+    benchHistInit(&slot->hist, g_arguments->latency_max);
+    pthread_mutex_lock(&g_sampler.mutex);
+    slot->next = g_sampler.slots;
+    g_sampler.slots = slot;
+    pthread_mutex_unlock(&g_sampler.mutex);
+    return slot;
+}
+
+void benchStatsRecord(SStatsSlot *slot, uint64_t rows, uint64_t bytes,
+                      uint64_t delay, bool failed) {
+    if (slot == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&slot->mutex);
+    if (failed) {
+        slot->errors++;
+    } else {
+        slot->rows += rows;
+        slot->requests++;
+        slot->bytes += bytes;
+        benchHistRecord(&slot->hist, delay);
+    }
+    pthread_mutex_unlock(&slot->mutex);
+}
+
+void benchStatsInflight(SStatsSlot *slot, int64_t delta) {
+    if (slot == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&slot->mutex);
+    slot->inflight += delta;
+    pthread_mutex_unlock(&slot->mutex);
+}
+
+// write the last partial interval and release every slot
+void benchStatsStop() {
+    if (!g_sampler.running) {
+        return;
+    }
+    pthread_mutex_lock(&g_sampler.mutex);
+    g_sampler.running = false;
+    pthread_cond_signal(&g_sampler.cond);
+    pthread_mutex_unlock(&g_sampler.mutex);
+    pthread_join(g_sampler.thread, NULL);
+    SStatsSlot *slot = g_sampler.slots;
+    while (slot) {
+        SStatsSlot *next = slot->next;
+        benchHistDestroy(&slot->hist);
+        pthread_mutex_destroy(&slot->mutex);
+        tmfree(slot);
+        slot = next;
+    }
+    g_sampler.slots = NULL;
+    if (g_sampler.fp) {
+        fclose(g_sampler.fp);
+        g_sampler.fp = NULL;
+    }
+    pthread_mutex_destroy(&g_sampler.mutex);
+    pthread_cond_destroy(&g_sampler.cond);
+}
+
+// OpenMetrics endpoint: workers bump their own slot, a small accept loop
+// sums them up whenever it is scraped
+static const uint64_t g_metricBounds[METRICS_BUCKETS - 1] = {
+    1000,   2000,   5000,    10000,   20000,   50000,   100000,
+    200000, 500000, 1000000, 2000000, 5000000, 10000000};
+
+#define METRICS_ERROR_CODES 64
+
+typedef struct SMetricsServer_S {
+    pthread_mutex_t mutex;  // guards slot registration and error codes
+    pthread_t       thread;
+    SMetricSlot *   slots;
+    int32_t         codes[METRICS_ERROR_CODES];
+    uint64_t        codeCounts[METRICS_ERROR_CODES];
+    uint32_t        codeNum;
+    uint64_t        otherErrors;  // codes beyond METRICS_ERROR_CODES
+    int64_t         activeThreads;
+    int             listenfd;
+    bool            running;
+} SMetricsServer;
+
+static SMetricsServer g_metrics;
+
+SMetricSlot *benchMetricsRegister(const char *label) {
+    if (!g_metrics.running) {
+        return NULL;
+    }
+    SMetricSlot *slot = benchCalloc(1, sizeof(SMetricSlot), true);
+    slot->label = label;
+    pthread_mutex_lock(&g_metrics.mutex);
+    slot->next = g_metrics.slots;
+    g_metrics.slots = slot;
+    pthread_mutex_unlock(&g_metrics.mutex);
+    return slot;
+}
+
+void benchMetricsRecord(SMetricSlot *slot, uint64_t rows,
+                        uint64_t affectedRows, uint64_t delay, int32_t code) {
+    if (slot == NULL) {
+        return;
+    }
+    if (code != 0) {
+        BENCH_ATOMIC_ADD(&slot->errors, 1);
+        // errors are rare, a lock is fine here
+        pthread_mutex_lock(&g_metrics.mutex);
+        uint32_t i = 0;
+        while (i < g_metrics.codeNum && g_metrics.codes[i] != code) {
+            i++;
+        }
+        if (i == g_metrics.codeNum && i < METRICS_ERROR_CODES) {
+            g_metrics.codes[g_metrics.codeNum++] = code;
+        }
+        if (i < METRICS_ERROR_CODES) {
+            g_metrics.codeCounts[i]++;
+        } else {
+            g_metrics.otherErrors++;
+        }
+        pthread_mutex_unlock(&g_metrics.mutex);
+        return;
+    }
+    uint32_t bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && delay > g_metricBounds[bucket]) {
+        bucket++;
+    }
+    BENCH_ATOMIC_ADD(&slot->rows, rows);
+    BENCH_ATOMIC_ADD(&slot->affectedRows, affectedRows);
+    BENCH_ATOMIC_ADD(&slot->requests, 1);
+    BENCH_ATOMIC_ADD(&slot->latencyUs, delay);
+    BENCH_ATOMIC_ADD(&slot->buckets[bucket], 1);
+}
+
+void benchMetricsThread(int64_t delta) {
+    if (g_metrics.running) {
+        BENCH_ATOMIC_ADD(&g_metrics.activeThreads, delta);
+    }
+}
+
+#ifndef WINDOWS
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef struct SMetricsBuf_S {
+    char * data;
+    size_t len;
+    size_t cap;
+} SMetricsBuf;
+
+static void metricsAppend(SMetricsBuf *buf, const char *fmt, ...) {
+    while (true) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            return;
+        }
+        if (buf->len + n < buf->cap) {
+            buf->len += n;
+            return;
+        }
+        buf->cap = (buf->cap + n) * 2;
+        buf->data = realloc(buf->data, buf->cap);
+        if (buf->data == NULL) {
+            errorPrint(stderr, "%s", "failed to grow the metrics buffer\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void sumMetricSlots(const char *label, SMetricSlot *sum) {
+    memset(sum, 0, sizeof(SMetricSlot));
+    for (SMetricSlot *slot = g_metrics.slots; slot; slot = slot->next) {
+        if (0 != strcmp(slot->label, label)) {
+            continue;
+        }
+        sum->rows += BENCH_ATOMIC_LOAD(&slot->rows);
+        sum->affectedRows += BENCH_ATOMIC_LOAD(&slot->affectedRows);
+        sum->requests += BENCH_ATOMIC_LOAD(&slot->requests);
+        sum->errors += BENCH_ATOMIC_LOAD(&slot->errors);
+        sum->latencyUs += BENCH_ATOMIC_LOAD(&slot->latencyUs);
+        for (int i = 0; i < METRICS_BUCKETS; i++) {
+            sum->buckets[i] += BENCH_ATOMIC_LOAD(&slot->buckets[i]);
+        }
+    }
+}
+
+// true when no slot before this one has the same label
+static bool firstOfLabel(SMetricSlot *slot) {
+    for (SMetricSlot *prev = g_metrics.slots; prev != slot;
+         prev = prev->next) {
+        if (0 == strcmp(prev->label, slot->label)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void renderCounter(SMetricsBuf *buf, const char *name,
+                          const char *help, size_t offset) {
+    metricsAppend(buf, "# TYPE taosbenchmark_%s counter\n"
+                       "# HELP taosbenchmark_%s %s\n", name, name, help);
+    for (SMetricSlot *slot = g_metrics.slots; slot; slot = slot->next) {
+        if (!firstOfLabel(slot)) {
+            continue;
+        }
+        SMetricSlot sum;
+        sumMetricSlots(slot->label, &sum);
+        metricsAppend(buf, "taosbenchmark_%s_total{label=\"%s\"} %" PRIu64 "\n",
+                      name, slot->label,
+                      *(uint64_t *)((char *)&sum + offset));
+    }
+}
+
+static void renderMetrics(SMetricsBuf *buf) {
+    pthread_mutex_lock(&g_metrics.mutex);
+    renderCounter(buf, "rows", "Rows inserted or fetched.",
+                  offsetof(SMetricSlot, rows));
+    renderCounter(buf, "affected_rows", "Rows the server reported affected.",
+                  offsetof(SMetricSlot, affectedRows));
+    renderCounter(buf, "requests", "Requests and queries completed.",
+                  offsetof(SMetricSlot, requests));
+    metricsAppend(buf,
+                  "# TYPE taosbenchmark_request_latency_seconds histogram\n"
+                  "# HELP taosbenchmark_request_latency_seconds Latency of "
+                  "successful requests.\n");
+    for (SMetricSlot *slot = g_metrics.slots; slot; slot = slot->next) {
+        if (!firstOfLabel(slot)) {
+            continue;
+        }
+        SMetricSlot sum;
+        sumMetricSlots(slot->label, &sum);
+        uint64_t cumulative = 0;
+        for (int i = 0; i < METRICS_BUCKETS; i++) {
+            cumulative += sum.buckets[i];
+            if (i < METRICS_BUCKETS - 1) {
+                metricsAppend(buf,
+                              "taosbenchmark_request_latency_seconds_bucket"
+                              "{label=\"%s\",le=\"%g\"} %" PRIu64 "\n",
+                              slot->label, g_metricBounds[i] / 1E6,
+                              cumulative);
+            } else {
+                metricsAppend(buf,
+                              "taosbenchmark_request_latency_seconds_bucket"
+                              "{label=\"%s\",le=\"+Inf\"} %" PRIu64 "\n",
+                              slot->label, cumulative);
+            }
+        }
+        metricsAppend(buf,
+                      "taosbenchmark_request_latency_seconds_sum{label=\"%s\"}"
+                      " %.6f\n"
+                      "taosbenchmark_request_latency_seconds_count"
+                      "{label=\"%s\"} %" PRIu64 "\n",
+                      slot->label, sum.latencyUs / 1E6, slot->label,
+                      cumulative);
+    }
+    metricsAppend(buf, "# TYPE taosbenchmark_errors counter\n"
+                       "# HELP taosbenchmark_errors Failed requests by error "
+                       "code.\n");
+    for (uint32_t i = 0; i < g_metrics.codeNum; i++) {
+        metricsAppend(buf,
+                      "taosbenchmark_errors_total{code=\"0x%08x\"} %" PRIu64
+                      "\n",
+                      (uint32_t)g_metrics.codes[i], g_metrics.codeCounts[i]);
+    }
+    if (g_metrics.otherErrors) {
+        metricsAppend(buf,
+                      "taosbenchmark_errors_total{code=\"other\"} %" PRIu64
+                      "\n",
+                      g_metrics.otherErrors);
+    }
+    pthread_mutex_unlock(&g_metrics.mutex);
+    metricsAppend(buf,
+                  "# TYPE taosbenchmark_active_threads gauge\n"
+                  "# HELP taosbenchmark_active_threads Worker threads "
+                  "running.\n"
+                  "taosbenchmark_active_threads %" PRId64 "\n# EOF\n",
+                  (int64_t)BENCH_ATOMIC_LOAD(&g_metrics.activeThreads));
+}
+
+static void serveMetrics(int fd) {
+    char    request[RESP_BUF_LEN];
+    int64_t received = 0;
+    // the request itself does not matter, wait for the end of its headers
+    while (received < (int64_t)sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + received,
+                         sizeof(request) - 1 - received, 0);
+        if (n <= 0) {
+            return;
+        }
+        received += n;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    SMetricsBuf body = {0};
+    body.cap = 16 * 1024;
+    body.data = benchCalloc(1, body.cap, false);
+    renderMetrics(&body);
+    char header[256];
+    int  headerLen = snprintf(
+        header, sizeof(header),
+        "HTTP/1.1 200 OK\r\nContent-Type: application/openmetrics-text; "
+        "version=1.0.0; charset=utf-8\r\nContent-Length: %zu\r\n"
+        "Connection: close\r\n\r\n",
+        body.len);
+    char *  data[2] = {header, body.data};
+    size_t  lens[2] = {(size_t)headerLen, body.len};
+    for (int i = 0; i < 2; i++) {
+        size_t sent = 0;
+        while (sent < lens[i]) {
+            ssize_t n = send(fd, data[i] + sent, lens[i] - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                goto serve_end;
+            }
+            sent += n;
+        }
+    }
+serve_end:
+    tmfree(body.data);
+}
+
+static void *metricsServer(void *arg) {
+#ifdef LINUX
+    prctl(PR_SET_NAME, "metricsServer");
+#endif
+    while (g_metrics.running) {
+        int fd = accept(g_metrics.listenfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // a client that stalls only holds up the scrapes behind it, and the
+        // stop, for this long
+        struct timeval timeout = {METRICS_IO_TIMEOUT_MS / 1000,
+                                  (METRICS_IO_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serveMetrics(fd);
+        close(fd);
+    }
+    return NULL;
+}
+#endif
+
+int benchMetricsStart() {
+    if (g_arguments->metrics_port == 0) {
+        return 0;
+    }
+#ifdef WINDOWS
+    infoPrint(stdout, "%s",
+              "metrics_port is not supported on windows, will be ignored\n");
+    return 0;
+#else
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_arguments->metrics_port);
+    const char *host =
+        g_arguments->metrics_host ? g_arguments->metrics_host : "127.0.0.1";
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        errorPrint(stderr, "invalid metrics_host: %s\n", host);
+        return -1;
+    }
+    g_metrics.listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (g_metrics.listenfd < 0 ||
+        setsockopt(g_metrics.listenfd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                   sizeof(reuse)) ||
+        bind(g_metrics.listenfd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(g_metrics.listenfd, 16)) {
+        errorPrint(stderr, "failed to listen on %s:%u for metrics: %s\n",
+                   host, g_arguments->metrics_port, strerror(errno));
+        if (g_metrics.listenfd >= 0) {
+            close(g_metrics.listenfd);
+        }
+        return -1;
+    }
+    pthread_mutex_init(&g_metrics.mutex, NULL);
+    g_metrics.running = true;
+    int code = pthread_create(&g_metrics.thread, NULL, metricsServer, NULL);
+    if (code) {
+        errorPrint(stderr, "failed to start the metrics server: %s\n",
+                   strerror(code));
+        g_metrics.running = false;
+        close(g_metrics.listenfd);
+        pthread_mutex_destroy(&g_metrics.mutex);
+        return -1;
+    }
+    infoPrint(stdout, "serving metrics on http://%s:%u/metrics\n", host,
+              g_arguments->metrics_port);
+    return 0;
+#endif
+}
+
+void benchMetricsStop() {
+#ifndef WINDOWS
+    if (!g_metrics.running) {
+        return;
+    }
+    g_metrics.running = false;
+    // wakes the accept loop up
+    shutdown(g_metrics.listenfd, SHUT_RDWR);
+    pthread_join(g_metrics.thread, NULL);
+    close(g_metrics.listenfd);
+    SMetricSlot *slot = g_metrics.slots;
+    while (slot) {
+        SMetricSlot *next = slot->next;
+        tmfree(slot);
+        slot = next;
+    }
+    g_metrics.slots = NULL;
+    pthread_mutex_destroy(&g_metrics.mutex);
+#endif
+}
+
+// phase timers: the thread that owns a threadInfo switches phases, calls
+// made on its behalf from sender or callback threads are not charged
+static BENCH_THREAD_LOCAL threadInfo *g_phaseOwner = NULL;
+
+static FORCE_INLINE int64_t phaseNowNs() {
+#ifdef WINDOWS
+    return toolsGetTimestampNs();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000L + ts.tv_nsec;
+#endif
+}
+
+void benchPhaseStart(threadInfo *pThreadInfo) {
+    if (!g_arguments->phase_timers) {
+        return;
+    }
+    g_phaseOwner = pThreadInfo;
+    memset(pThreadInfo->phaseNs, 0, sizeof(pThreadInfo->phaseNs));
+    pThreadInfo->phase = PHASE_BUILD;
+    pThreadInfo->phaseTs = phaseNowNs();
+}
+
+// charge the time since the last switch to the current phase and enter
+// the new one, returns the phase left so callers can go back to it
+int32_t benchPhaseSwitch(threadInfo *pThreadInfo, int32_t phase) {
+    if (pThreadInfo->phaseTs == 0 || g_phaseOwner != pThreadInfo) {
+        return phase;
+    }
+    int64_t now = phaseNowNs();
+    int32_t prev = pThreadInfo->phase;
+    pThreadInfo->phaseNs[prev] += now - pThreadInfo->phaseTs;
+    pThreadInfo->phaseTs = now;
+    pThreadInfo->phase = phase;
+    return prev;
+}
+
+void benchPhaseStop(threadInfo *pThreadInfo) {
+    if (g_phaseOwner != pThreadInfo) {
+        return;
+    }
+    benchPhaseSwitch(pThreadInfo, pThreadInfo->phase);
+    pThreadInfo->phaseTs = 0;
+    g_phaseOwner = NULL;
+}
+
+// distributed insert: a controller prepares the database, sends its json
+// configuration and a share of the tables to every agent over one tcp
+// connection, starts them together and merges what they report. Messages
+// are text lines:
+//   controller -> agent: CONFIG <bytes>\n<json>,
+//                        ASSIGN <index> <count> <random seed>,
+//                        START <delay ms>
+//   agent -> controller: READY, STATS <interval> <counters> <histogram>,
+//                        RESULT <db.stb> <rows> <affected> <us> <histogram>,
+//                        DONE <failed>
+#ifndef WINDOWS
+typedef struct SAgentLink_S {
+    int      fd;
+    char *   buf;
+    uint32_t pos;
+    uint32_t len;
+    uint32_t cap;
+} SAgentLink;
+
+static void linkInit(SAgentLink *link, int fd) {
+    link->fd = fd;
+    link->cap = RESP_BUF_LEN;
+    link->buf = benchCalloc(1, link->cap, false);
+    link->pos = 0;
+    link->len = 0;
+}
+
+static void linkClose(SAgentLink *link) {
+    if (link->fd >= 0) {
+        close(link->fd);
+        link->fd = -1;
+    }
+    tmfree(link->buf);
+    link->buf = NULL;
+}
+
+// the next line without its newline, valid until the next read, NULL once
+// the peer is gone
+static char *linkReadLine(SAgentLink *link) {
+    while (true) {
+        char *nl = memchr(link->buf + link->pos, '\n', link->len - link->pos);
+        if (nl) {
+            char *line = link->buf + link->pos;
+            *nl = '\0';
+            link->pos = (uint32_t)(nl + 1 - link->buf);
+            return line;
+        }
+        if (link->pos > 0) {
+            memmove(link->buf, link->buf + link->pos, link->len - link->pos);
+            link->len -= link->pos;
+            link->pos = 0;
+        }
+        if (link->len == link->cap) {
+            link->cap *= 2;
+            link->buf = realloc(link->buf, link->cap);
+            if (link->buf == NULL) {
+                errorPrint(stderr, "%s", "failed to grow the agent buffer\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        ssize_t n = recv(link->fd, link->buf + link->len,
+                         link->cap - link->len, 0);
+        if (n <= 0) {
+            return NULL;
+        }
+        link->len += (uint32_t)n;
+    }
+}
+
+static int linkRead(SAgentLink *link, char *out, uint64_t size) {
+    uint64_t got = link->len - link->pos;
+    if (got > size) {
+        got = size;
+    }
+    memcpy(out, link->buf + link->pos, got);
+    link->pos += (uint32_t)got;
+    while (got < size) {
+        ssize_t n = recv(link->fd, out + got, size - got, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        got += n;
+    }
+    return 0;
+}
+
+static int linkSend(SAgentLink *link, const char *data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(link->fd, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return -1;
+        }
+        sent += n;
+    }
+    return 0;
+}
+
+// " count total min max n index:count..." of the non-empty buckets
+static void histAppend(SMetricsBuf *out, SLatencyHist *hist) {
+    if (hist == NULL) {
+        metricsAppend(out, " 0 0 0 0 0");
+        return;
+    }
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < hist->size; i++) {
+        used += hist->counts[i] != 0;
+    }
+    metricsAppend(out, " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %u",
+                  hist->count, hist->total, hist->count ? hist->min : 0,
+                  hist->max, used);
+    for (uint32_t i = 0; i < hist->size; i++) {
+        if (hist->counts[i]) {
+            metricsAppend(out, " %u:%" PRIu64, i, hist->counts[i]);
+        }
+    }
+}
+
+// merge what histAppend wrote into hist, NULL if it is malformed
+static char *histMergeText(char *p, SLatencyHist *hist) {
+    uint64_t count = strtoull(p, &p, 10);
+    uint64_t total = strtoull(p, &p, 10);
+    uint64_t min = strtoull(p, &p, 10);
+    uint64_t max = strtoull(p, &p, 10);
+    uint32_t used = (uint32_t)strtoul(p, &p, 10);
+    for (uint32_t i = 0; i < used; i++) {
+        uint32_t index = (uint32_t)strtoul(p, &p, 10);
+        if (*p != ':') {
+            return NULL;
+        }
+        uint64_t n = strtoull(p + 1, &p, 10);
+        hist->counts[index < hist->size ? index : hist->size - 1] += n;
+    }
+    if (count) {
+        hist->count += count;
+        hist->total += total;
+        if (min < hist->min) hist->min = min;
+        if (max > hist->max) hist->max = max;
+    }
+    return p;
+}
+
+typedef struct SAgent_S {
+    SAgentLink      link;
+    pthread_mutex_t mutex;  // the stats sampler sends too
+    bool            started;
+    int64_t         startUs;
+} SAgent;
+
+static SAgent g_agent = {.link = {.fd = -1}};
+
+static int agentSend(const char *data, size_t len) {
+    pthread_mutex_lock(&g_agent.mutex);
+    int code = linkSend(&g_agent.link, data, len);
+    pthread_mutex_unlock(&g_agent.mutex);
+    return code;
+}
+
+// the controller already created the database and tables, the agent only
+// inserts into its share and keeps its share of every rate. Its seed keeps
+// the tags rendered on demand equal to those of the created tables
+static void applyAgentShare(uint32_t index, uint32_t count, uint64_t seed) {
+    g_arguments->random_seed = seed;
+    g_arguments->agent_index = index;
+    g_arguments->agent_count = count;
+    g_arguments->agents = benchArrayDestroy(g_arguments->agents);
+    g_arguments->answer_yes = true;
+    // paths in the remote configuration name files on the controller's
+    // host, the agent writes none of them
+    g_arguments->stats_file = NULL;
+    g_arguments->latency_dump_file = NULL;
+    if (g_arguments->stats_interval_ms == 0) {
+        g_arguments->stats_interval_ms = AGENT_STATS_INTERVAL;
+    }
+    for (int i = 0; i < g_arguments->databases->size; i++) {
+        SDataBase *database = benchArrayGet(g_arguments->databases, i);
+        database->drop = false;
+        for (int j = 0; j < database->superTbls->size; j++) {
+            SSuperTable *stbInfo = benchArrayGet(database->superTbls, j);
+            if (stbInfo->insert_rate > 0) {
+                uint64_t rate = stbInfo->insert_rate / count +
+                                (index < stbInfo->insert_rate % count);
+                stbInfo->insert_rate = rate > 0 ? rate : 1;
+            }
+        }
+    }
+}
+#endif
+
+int benchAgentAccept() {
+#ifdef WINDOWS
+    errorPrint(stderr, "%s", "agent mode is not supported on windows\n");
+    return -1;
+#else
+    // the controller is not authenticated, only listen beyond the local
+    // host when asked to
+    char  host[MAX_FILE_NAME_LEN] = "127.0.0.1";
+    char *colon = strrchr(g_arguments->agent_listen, ':');
+    char *port = g_arguments->agent_listen;
+    if (colon) {
+        snprintf(host, sizeof(host), "%.*s",
+                 (int)(colon - g_arguments->agent_listen),
+                 g_arguments->agent_listen);
+        port = colon + 1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)atoi(port));
+    if (atoi(port) <= 0 || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        errorPrint(stderr, "invalid agent address: %s\n",
+                   g_arguments->agent_listen);
+        return -1;
+    }
+    int listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (listenfd < 0 || bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(listenfd, 1)) {
+        errorPrint(stderr, "failed to listen on %s for the controller: %s\n",
+                   g_arguments->agent_listen, strerror(errno));
+        if (listenfd >= 0) {
+            close(listenfd);
+        }
+        return -1;
+    }
+    infoPrint(stdout, "agent waiting for a controller on %s:%s\n", host, port);
+    int fd = accept(listenfd, NULL, NULL);
+    close(listenfd);
+    if (fd < 0) {
+        errorPrint(stderr, "failed to accept the controller: %s\n",
+                   strerror(errno));
+        return -1;
+    }
+    pthread_mutex_init(&g_agent.mutex, NULL);
+    linkInit(&g_agent.link, fd);
+
+    uint64_t size = 0;
+    char *   line = linkReadLine(&g_agent.link);
+    if (line == NULL || 1 != sscanf(line, "CONFIG %" SCNu64, &size) ||
+        size == 0 || size > MAX_JSON_BUFF) {
+        errorPrint(stderr, "%s", "controller sent no configuration\n");
+        return -1;
+    }
+    char *content = benchCalloc(1, size + 1, false);
+    if (linkRead(&g_agent.link, content, size)) {
+        errorPrint(stderr, "%s", "controller went away\n");
+        tmfree(content);
+        return -1;
+    }
+    g_arguments->g_totalChildTables = 0;
+    char *outputFile = g_arguments->output_file;
+    int   code = getInfoFromJsonContent(content, "controller configuration");
+    tmfree(content);
+    if (code) {
+        return -1;
+    }
+    g_arguments->output_file = outputFile;
+    if (g_arguments->test_mode != INSERT_TEST) {
+        errorPrint(stderr, "%s", "agents only run insert configurations\n");
+        return -1;
+    }
+    uint32_t index = 0, count = 0;
+    uint64_t seed = 0;
+    line = linkReadLine(&g_agent.link);
+    if (line == NULL ||
+        3 != sscanf(line, "ASSIGN %u %u %" SCNu64, &index, &count, &seed) ||
+        index >= count || seed == 0) {
+        errorPrint(stderr, "%s", "controller sent no share of the tables\n");
+        return -1;
+    }
+    applyAgentShare(index, count, seed);
+    infoPrint(stdout, "agent %u of %u\n", index, count);
+    return 0;
+#endif
+}
+
+// tell the controller this agent is prepared and wait for the common start
+int benchAgentReady() {
+    if (g_arguments->agent_count == 0) {
+        return 0;
+    }
+#ifndef WINDOWS
+    int64_t delay = 0;
+    char *  line = NULL;
+    if (0 == agentSend("READY\n", 6)) {
+        line = linkReadLine(&g_agent.link);
+    }
+    if (line == NULL || 1 != sscanf(line, "START %" SCNd64, &delay)) {
+        errorPrint(stderr, "%s", "controller went away before the start\n");
+        return -1;
+    }
+    toolsUsleepUntil(toolsGetTimestampUs() + delay * 1000);
+    g_agent.startUs = toolsGetTimestampUs();
+    g_agent.started = true;
+#endif
+    return 0;
+}
+
+// forwarded from the stats sampler, the controller merges the records of
+// all agents by interval number counted from the common start
+void benchAgentStats(int64_t now, uint64_t rows, uint64_t requests,
+                     uint64_t bytes, uint64_t errors, int64_t inflight,
+                     SLatencyHist *hist) {
+#ifndef WINDOWS
+    if (!g_agent.started || g_agent.link.fd < 0) {
+        return;
+    }
+    int64_t  interval = g_arguments->stats_interval_ms * 1000;
+    uint64_t k = (uint64_t)((now - g_agent.startUs + interval / 2) / interval);
+    SMetricsBuf out = {0};
+    out.cap = RESP_BUF_LEN;
+    out.data = benchCalloc(1, out.cap, false);
+    metricsAppend(&out,
+                  "STATS %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                  " %" PRIu64 " %" PRId64,
+                  k > 0 ? k : 1, rows, requests, bytes, errors, inflight);
+    histAppend(&out, hist);
+    metricsAppend(&out, "\n");
+    agentSend(out.data, out.len);
+    tmfree(out.data);
+#endif
+}
+
+void benchAgentReport(const char *dbName, const char *stbName, uint64_t rows,
+                      uint64_t affectedRows, int64_t us, SLatencyHist *hist) {
+#ifndef WINDOWS
+    if (g_agent.link.fd < 0) {
+        return;
+    }
+    SMetricsBuf out = {0};
+    out.cap = RESP_BUF_LEN;
+    out.data = benchCalloc(1, out.cap, false);
+    metricsAppend(&out,
+                  "RESULT %s.%s %" PRIu64 " %" PRIu64 " %" PRId64, dbName,
+                  stbName, rows, affectedRows, us);
+    histAppend(&out, hist);
+    metricsAppend(&out, "\n");
+    agentSend(out.data, out.len);
+    tmfree(out.data);
+#endif
+}
+
+void benchAgentFinish(bool failed) {
+#ifndef WINDOWS
+    if (g_agent.link.fd < 0) {
+        return;
+    }
+    agentSend(failed ? "DONE 1\n" : "DONE 0\n", 7);
+    linkClose(&g_agent.link);
+    pthread_mutex_destroy(&g_agent.mutex);
+#endif
+}
+
+#ifndef WINDOWS
+typedef struct SAgentPeer_S {
+    char *     addr;
+    SAgentLink link;
+    pthread_t  thread;
+    bool       ready;
+    bool       done;
+    bool       failed;
+    uint64_t   rows;
+    int64_t    us;
+} SAgentPeer;
+
+// results of one super table summed over the agents
+typedef struct SMergedResult_S {
+    char *       label;
+    uint64_t     rows;
+    uint64_t     affectedRows;
+    int64_t      us;  // the slowest agent, they all started together
+    SLatencyHist hist;
+} SMergedResult;
+
+typedef struct SController_S {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    SAgentPeer *    peers;
+    uint32_t        count;
+    SMergedResult * results;
+    uint32_t        resultCount;
+    SStatsSum *     intervals;  // intervals[k - 1] is interval k
+    uint64_t        intervalCount;
+    int64_t         startUs;
+} SController;
+
+static SController g_controller;
+
+static SMergedResult *mergedResult(const char *label) {
+    for (uint32_t i = 0; i < g_controller.resultCount; i++) {
+        if (0 == strcmp(g_controller.results[i].label, label)) {
+            return g_controller.results + i;
+        }
+    }
+    SMergedResult *grown =
+        realloc(g_controller.results,
+                (g_controller.resultCount + 1) * sizeof(SMergedResult));
+    if (grown == NULL) {
+        errorPrint(stderr, "%s", "failed to grow the merged results\n");
+        return NULL;
+    }
+    g_controller.results = grown;
+    SMergedResult *result = g_controller.results + g_controller.resultCount++;
+    memset(result, 0, sizeof(SMergedResult));
+    result->label = strdup(label);
+    benchHistInit(&result->hist, g_arguments->latency_max);
+    return result;
+}
+
+// NULL when k lies past the intervals elapsed since the start or memory
+// runs out
+static SStatsSum *mergedInterval(uint64_t k) {
+    int64_t interval = (g_arguments->stats_interval_ms
+                            ? g_arguments->stats_interval_ms
+                            : AGENT_STATS_INTERVAL) * 1000LL;
+    int64_t elapsed = toolsGetTimestampUs() - g_controller.startUs;
+    if (k > (uint64_t)(elapsed > 0 ? elapsed : 0) / interval + 2) {
+        return NULL;
+    }
+    if (k > g_controller.intervalCount) {
+        SStatsSum *grown =
+            realloc(g_controller.intervals, k * sizeof(SStatsSum));
+        if (grown == NULL) {
+            errorPrint(stderr, "%s", "failed to grow the merged intervals\n");
+            return NULL;
+        }
+        g_controller.intervals = grown;
+        for (uint64_t i = g_controller.intervalCount; i < k; i++) {
+            memset(g_controller.intervals + i, 0, sizeof(SStatsSum));
+            benchHistInit(&g_controller.intervals[i].hist,
+                          g_arguments->latency_max);
+        }
+        g_controller.intervalCount = k;
+    }
+    return g_controller.intervals + k - 1;
+}
+
+static int mergeAgentLine(SAgentPeer *peer, char *line) {
+    char *p;
+    if (0 == strcmp(line, "READY")) {
+        peer->ready = true;
+    } else if (0 == strncmp(line, "STATS ", 6)) {
+        uint64_t   k = strtoull(line + 6, &p, 10);
+        SStatsSum *sum = mergedInterval(k > 0 ? k : 1);
+        if (sum == NULL) {
+            return -1;
+        }
+        sum->rows += strtoull(p, &p, 10);
+        sum->requests += strtoull(p, &p, 10);
+        sum->bytes += strtoull(p, &p, 10);
+        sum->errors += strtoull(p, &p, 10);
+        sum->inflight += strtoll(p, &p, 10);
+        if (histMergeText(p, &sum->hist) == NULL) {
+            return -1;
+        }
+    } else if (0 == strncmp(line, "RESULT ", 7)) {
+        char *label = line + 7;
+        p = strchr(label, ' ');
+        if (p == NULL) {
+            return -1;
+        }
+        *p++ = '\0';
+        SMergedResult *result = mergedResult(label);
+        if (result == NULL) {
+            return -1;
+        }
+        uint64_t       rows = strtoull(p, &p, 10);
+        result->rows += rows;
+        result->affectedRows += strtoull(p, &p, 10);
+        int64_t us = strtoll(p, &p, 10);
+        if (us > result->us) result->us = us;
+        peer->rows += rows;
+        peer->us += us;
+        if (histMergeText(p, &result->hist) == NULL) {
+            return -1;
+        }
+    } else if (0 == strncmp(line, "DONE ", 5)) {
+        peer->failed = atoi(line + 5) != 0;
+        peer->done = true;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void *agentReader(void *arg) {
+    SAgentPeer *peer = (SAgentPeer *)arg;
+    char *      line;
+    while ((line = linkReadLine(&peer->link)) != NULL) {
+        pthread_mutex_lock(&g_controller.mutex);
+        int code = mergeAgentLine(peer, line);
+        if (code) {
+            errorPrint(stderr, "agent %s sent a malformed message: %.64s\n",
+                       peer->addr, line);
+        }
+        bool done = peer->done;
+        pthread_cond_broadcast(&g_controller.cond);
+        pthread_mutex_unlock(&g_controller.mutex);
+        if (done) {
+            break;
+        }
+    }
+    pthread_mutex_lock(&g_controller.mutex);
+    if (!peer->done) {
+        errorPrint(stderr, "agent %s went away\n", peer->addr);
+        peer->failed = true;
+        peer->done = true;
+    }
+    pthread_cond_broadcast(&g_controller.cond);
+    pthread_mutex_unlock(&g_controller.mutex);
+    return NULL;
+}
+
+static int connectAgent(SAgentPeer *peer, const char *content, size_t len,
+                        uint32_t index) {
+    char  host[MAX_FILE_NAME_LEN];
+    char *colon = strrchr(peer->addr, ':');
+    snprintf(host, sizeof(host), "%.*s", (int)(colon - peer->addr),
+             peer->addr);
+    struct sockaddr_in addr;
+    if (convertHostToServAddr(host, (uint16_t)atoi(colon + 1), &addr)) {
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        errorPrint(stderr, "failed to connect agent %s: %s\n", peer->addr,
+                   strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    linkInit(&peer->link, fd);
+    char header[SQL_BUFF_LEN];
+    int  n = snprintf(header, sizeof(header), "CONFIG %zu\n", len);
+    if (linkSend(&peer->link, header, n) ||
+        linkSend(&peer->link, content, len)) {
+        return -1;
+    }
+    n = snprintf(header, sizeof(header), "ASSIGN %u %u %" PRIu64 "\n", index,
+                 g_controller.count, g_arguments->random_seed);
+    return linkSend(&peer->link, header, n);
+}
+
+static void printControllerReport(FILE *fp) {
+    for (uint32_t i = 0; i < g_controller.resultCount; i++) {
+        SMergedResult *result = g_controller.results + i;
+        double seconds = result->us > 0 ? result->us / 1E6 : 1E-6;
+        infoPrint(fp,
+                  "Spent %.4f seconds to insert rows: %" PRIu64
+                  ", affected rows: %" PRIu64 " with %u agent(s) into %s "
+                  "%.2f records/second\n",
+                  seconds, result->rows, result->affectedRows,
+                  g_controller.count, result->label, result->rows / seconds);
+        benchHistPrint(fp, "insert delay", &result->hist, 1000.0, "ms");
+    }
+    for (uint32_t i = 0; i < g_controller.count; i++) {
+        SAgentPeer *peer = g_controller.peers + i;
+        double      seconds = peer->us > 0 ? peer->us / 1E6 : 1E-6;
+        infoPrint(fp,
+                  "agent %s inserted rows: %" PRIu64 " in %.4f seconds, "
+                  "%.2f records/second%s\n",
+                  peer->addr, peer->rows, seconds, peer->rows / seconds,
+                  peer->failed ? ", failed" : "");
+    }
+}
+
+// the merged time series goes to stats_file like a local run's "all" rows
+static int writeControllerStats(int64_t startUs) {
+    if (g_arguments->stats_file == NULL || g_controller.intervalCount == 0) {
+        return 0;
+    }
+    g_sampler.fp = fopen(g_arguments->stats_file, "w");
+    if (g_sampler.fp == NULL) {
+        errorPrint(stderr, "failed to open stats file %s: %s\n",
+                   g_arguments->stats_file, strerror(errno));
+        return -1;
+    }
+    if (g_arguments->stats_format == STATS_FORMAT_CSV) {
+        fprintf(g_sampler.fp,
+                "timestamp_ms,elapsed_s,label,rows_per_sec,requests_per_sec,"
+                "bytes_per_sec,p50_ms,p90_ms,p99_ms,max_ms,errors,inflight\n");
+    }
+    uint32_t interval = g_arguments->stats_interval_ms
+                            ? g_arguments->stats_interval_ms
+                            : AGENT_STATS_INTERVAL;
+    g_sampler.startTs = startUs;
+    for (uint64_t k = 1; k <= g_controller.intervalCount; k++) {
+        writeStatsRecord(startUs + (int64_t)k * interval * 1000, "all",
+                         g_controller.intervals + k - 1, interval / 1000.0);
+    }
+    fclose(g_sampler.fp);
+    g_sampler.fp = NULL;
+    return 0;
+}
+#endif
+
+// runs instead of the local insert once the database and tables are ready
+int benchControllerRun() {
+#ifdef WINDOWS
+    errorPrint(stderr, "%s", "controller mode is not supported on windows\n");
+    return -1;
+#else
+    FILE *fp = fopen(g_arguments->metaFile, "r");
+    if (fp == NULL) {
+        errorPrint(stderr, "failed to read %s, reason:%s\n",
+                   g_arguments->metaFile, strerror(errno));
+        return -1;
+    }
+    char * content = benchCalloc(1, MAX_JSON_BUFF + 1, false);
+    size_t len = fread(content, 1, MAX_JSON_BUFF, fp);
+    fclose(fp);
+
+    int code = -1;
+    pthread_mutex_init(&g_controller.mutex, NULL);
+    pthread_cond_init(&g_controller.cond, NULL);
+    g_controller.count = (uint32_t)g_arguments->agents->size;
+    // no interval is valid before the start is sent
+    g_controller.startUs = INT64_MAX;
+    g_controller.peers =
+        benchCalloc(g_controller.count, sizeof(SAgentPeer), true);
+    uint32_t connected = 0;
+    for (; connected < g_controller.count; connected++) {
+        SAgentPeer *peer = g_controller.peers + connected;
+        peer->addr = *(char **)benchArrayGet(g_arguments->agents, connected);
+        peer->link.fd = -1;
+        if (connectAgent(peer, content, len, connected)) {
+            linkClose(&peer->link);
+            break;
+        }
+        pthread_create(&peer->thread, NULL, agentReader, peer);
+    }
+    tmfree(content);
+
+    // start only when every agent is prepared, a failed agent aborts all
+    bool failed = connected < g_controller.count;
+    pthread_mutex_lock(&g_controller.mutex);
+    for (uint32_t i = 0; i < connected && !failed; i++) {
+        SAgentPeer *peer = g_controller.peers + i;
+        while (!peer->ready && !peer->done) {
+            pthread_cond_wait(&g_controller.cond, &g_controller.mutex);
+        }
+        failed = peer->done;
+    }
+    int64_t startUs = toolsGetTimestampUs() + AGENT_START_DELAY_MS * 1000;
+    g_controller.startUs = startUs;
+    pthread_mutex_unlock(&g_controller.mutex);
+    if (!failed) {
+        char start[SQL_BUFF_LEN];
+        int  n = snprintf(start, sizeof(start), "START %d\n",
+                          AGENT_START_DELAY_MS);
+        for (uint32_t i = 0; i < connected; i++) {
+            linkSend(&g_controller.peers[i].link, start, n);
+        }
+        infoPrint(stdout, "started %u agent(s)\n", connected);
+    } else {
+        errorPrint(stderr, "%s", "not every agent is ready, abort\n");
+    }
+    for (uint32_t i = 0; i < connected; i++) {
+        SAgentPeer *peer = g_controller.peers + i;
+        if (failed) {
+            // wakes the reader up
+            shutdown(peer->link.fd, SHUT_RDWR);
+        }
+        pthread_join(peer->thread, NULL);
+        failed = failed || peer->failed;
+        linkClose(&peer->link);
+    }
+    if (!failed) {
+        code = 0;
+    }
+    if (connected == g_controller.count) {
+        printControllerReport(stdout);
+        if (g_arguments->fpOfInsertResult) {
+            printControllerReport(g_arguments->fpOfInsertResult);
+        }
+        for (uint32_t i = 0; i < g_controller.resultCount; i++) {
+            char label[SQL_BUFF_LEN];
+            snprintf(label, sizeof(label), "insert %s",
+                     g_controller.results[i].label);
+            if (benchHistDump(&g_controller.results[i].hist, label)) {
+                code = -1;
+            }
+        }
+        if (writeControllerStats(startUs)) {
+            code = -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < g_controller.resultCount; i++) {
+        free(g_controller.results[i].label);
+        benchHistDestroy(&g_controller.results[i].hist);
+    }
+    free(g_controller.results);
+    for (uint64_t k = 0; k < g_controller.intervalCount; k++) {
+        benchHistDestroy(&g_controller.intervals[k].hist);
+    }
+    free(g_controller.intervals);
+    tmfree(g_controller.peers);
+    pthread_mutex_destroy(&g_controller.mutex);
+    pthread_cond_destroy(&g_controller.cond);
+    return code;
+#endif
+}
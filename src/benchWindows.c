@@ -30,6 +30,7 @@ void printUsage() {
                     "            [--replia=NUMBER] [--tag-type=TAG_TYPE] [--data-type=COL_TYPE]\n"
                     "            [--interlace-rows=NUMBER] [--config-dir=CONFIG_DIR] [--chinese]\n"
                     "            [--database=DATABASE] [--escape-character] [--prepared_rand=NUMBER]\n"
+                    "            [--random-seed=NUMBER]\n"
                     "            [--debug] [--performance] [--host=HOST] [--connection_pool=NUMBER]\n"
                     "            [--insert-interval=NUMBER] [--interface=IFACE] [--columns=NUMBER]\n"
                     "            [--table-prefix=TABLE_PREFIX] [--random] [--records=NUMBER]\n"
@@ -60,6 +61,8 @@ void printHelp() {
       "  -C, --chinese              Nchar and binary are basic unicode chinese\n"
       "                             characters, optional.\n"
       "  -d, --database=DATABASE    Name of database, default is test.\n"
+      "  -e, --random-seed=NUMBER   Seed of the random data generator, default is\n"
+      "                             derived from the clock.\n"
       "  -E, --escape-character     Use escape character in stable and child table\n"
       "                             name, optional.\n"
       "  -F, --prepared_rand=NUMBER Random data source size, default is 10000.\n"
@@ -275,6 +278,12 @@ void commandLineParseArgument(int argc, char *argv[]) {
             } else {
                 exit_required("-m");
             }
+        } else if (strcmp(argv[i], "-e") == 0) {
+            if (i < argc - 1) {
+                g_arguments->random_seed = strtoull(argv[++i], NULL, 10);
+            } else {
+                exit_required("-e");
+            }
         } else if (strcmp(argv[i], "-E") == 0) {
             stbInfo->escape_character = true;
         } else if (strcmp(argv[i], "-C") == 0) {
@@ -0,0 +1,679 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the MIT license as published by the Free Software
+ * Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CUnit/CUnitCI.h"
+#include "bench.h"
+#ifdef DEFLATE_CODEC
+#include <zlib.h>
+#endif
+
+// defined by benchMain.c in taosBenchmark
+SArguments*    g_arguments;
+SQueryMetaInfo g_queryInfo;
+bool           g_fail = false;
+uint64_t       g_memoryUsage = 0;
+tools_cJSON*   root;
+
+CU_SUITE_SETUP() {
+    init_argument();
+    return CUE_SUCCESS;
+}
+
+static void recordAll(SLatencyHist *hist, const uint64_t *values, int n) {
+    for (int i = 0; i < n; i++) {
+        benchHistRecord(hist, values[i]);
+    }
+}
+
+// below 128 every value has its own bucket
+static void testHistLinear(void) {
+    SLatencyHist hist;
+    benchHistInit(&hist, 1000);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 50), 0);
+    for (uint64_t v = 1; v <= 100; v++) {
+        benchHistRecord(&hist, v);
+    }
+    CU_ASSERT_EQUAL(hist.count, 100);
+    CU_ASSERT_EQUAL(hist.total, 5050);
+    CU_ASSERT_EQUAL(hist.min, 1);
+    CU_ASSERT_EQUAL(hist.max, 100);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 50), 50);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 99), 99);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 100), 100);
+    benchHistDestroy(&hist);
+}
+
+// 127 is the last linear bucket, 128 and 129 share the first log bucket
+// and 130 starts the next one
+static void testHistLinearToLog(void) {
+    const uint64_t values[] = {127, 128, 129, 130, 5000};
+    SLatencyHist   hist;
+    benchHistInit(&hist, 10000);
+    recordAll(&hist, values, 5);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 20), 127);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 40), 129);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 60), 129);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 80), 131);
+    // the top bucket reaches 5055, the result never exceeds the max
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 99), 5000);
+    CU_ASSERT_EQUAL(hist.max, 5000);
+    benchHistDestroy(&hist);
+}
+
+// 254 and 255 end the first power of two, 256 starts the next one where a
+// bucket spans 4 values
+static void testHistSubBucketEdges(void) {
+    const uint64_t values[] = {254, 255, 256, 259, 260, 100000};
+    SLatencyHist   hist;
+    benchHistInit(&hist, 1000000);
+    recordAll(&hist, values, 6);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 30), 255);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 50), 259);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 60), 259);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 70), 263);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 99), 100000);
+    CU_ASSERT_EQUAL(hist.max, 100000);
+
+    // and at the power after, 511 ends a bucket and 512 opens one of 8
+    SLatencyHist next;
+    benchHistInit(&next, 1000000);
+    const uint64_t edges[] = {511, 512};
+    recordAll(&next, edges, 2);
+    CU_ASSERT_EQUAL(benchHistPercentile(&next, 50), 511);
+    CU_ASSERT_EQUAL(benchHistPercentile(&next, 99), 512);
+    benchHistRecord(&next, 600);
+    CU_ASSERT_EQUAL(benchHistPercentile(&next, 66), 519);
+    benchHistDestroy(&next);
+    benchHistDestroy(&hist);
+}
+
+// values past highest count in the last bucket, min and max stay exact
+static void testHistBeyondHighest(void) {
+    SLatencyHist hist;
+    benchHistInit(&hist, 1000);
+    for (int i = 0; i < 99; i++) {
+        benchHistRecord(&hist, 10);
+    }
+    benchHistRecord(&hist, 50000);
+    CU_ASSERT_EQUAL(benchHistPercentile(&hist, 99), 10);
+    CU_ASSERT_EQUAL(hist.max, 50000);
+    CU_ASSERT_EQUAL(hist.total, 99 * 10 + 50000);
+    CU_ASSERT(benchHistPercentile(&hist, 100) <= hist.max);
+    benchHistDestroy(&hist);
+}
+
+static void testHistMerge(void) {
+    SLatencyHist low, high;
+    benchHistInit(&low, 1000);
+    benchHistInit(&high, 1000);
+    for (uint64_t v = 1; v <= 100; v++) {
+        benchHistRecord(v <= 50 ? &low : &high, v);
+    }
+    benchHistMerge(&low, &high);
+    CU_ASSERT_EQUAL(low.count, 100);
+    CU_ASSERT_EQUAL(low.total, 5050);
+    CU_ASSERT_EQUAL(low.min, 1);
+    CU_ASSERT_EQUAL(low.max, 100);
+    CU_ASSERT_EQUAL(benchHistPercentile(&low, 50), 50);
+    CU_ASSERT_EQUAL(benchHistPercentile(&low, 99), 99);
+    benchHistDestroy(&high);
+    benchHistDestroy(&low);
+}
+
+static void initResp(SHttpResp *resp) {
+    memset(resp, 0, sizeof(SHttpResp));
+    resp->contentLength = -1;
+    resp->chunkLeft = HTTP_CHUNK_SIZE;
+}
+
+// deliver wire to the parser the way reads would, cut after each offset in
+// cuts; returns the result of the last call
+static int feedResp(SHttpResp *resp, char *buf, const char *wire,
+                    const int64_t *cuts, int ncuts) {
+    int64_t total = (int64_t)strlen(wire);
+    int64_t received = 0;
+    int     ret = 0;
+    for (int i = 0; i <= ncuts; i++) {
+        int64_t upto = i < ncuts ? cuts[i] : total;
+        memcpy(buf + received, wire + received, upto - received);
+        received = upto;
+        ret = parseHttpResponse(resp, buf, received);
+        if (i < ncuts) {
+            CU_ASSERT_EQUAL(ret, 0);
+        }
+    }
+    return ret;
+}
+
+static void testHttpContentLength(void) {
+    const char *wire =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+        "Content-Length: 11\r\n\r\n{\"code\":0}\n";
+    char        buf[256];
+    SHttpResp   resp;
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, NULL, 0), 1);
+    CU_ASSERT_EQUAL(resp.status, 200);
+    CU_ASSERT_EQUAL(resp.contentLength, 11);
+    CU_ASSERT_EQUAL(resp.bodyLen, 11);
+    CU_ASSERT_FALSE(resp.chunked);
+    CU_ASSERT_FALSE(resp.close);
+    CU_ASSERT_EQUAL(0, memcmp(buf + resp.bodyStart, "{\"code\":0}\n", 11));
+
+    // the body arrives in two reads
+    const int64_t cuts[] = {(int64_t)strlen(wire) - 5};
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, cuts, 1), 1);
+    CU_ASSERT_EQUAL(resp.bodyLen, 11);
+}
+
+static void testHttpChunkedSplit(void) {
+    const char *wire =
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+        "Connection: close\r\n\r\n"
+        "5\r\nhello\r\n7\r\n, world\r\n0\r\n\r\n";
+    char      buf[256];
+    SHttpResp resp;
+    int64_t   total = (int64_t)strlen(wire);
+    // a single cut anywhere, inside chunk data, size lines and the trailer
+    for (int64_t cut = 1; cut < total; cut++) {
+        initResp(&resp);
+        CU_ASSERT_EQUAL_FATAL(feedResp(&resp, buf, wire, &cut, 1), 1);
+        CU_ASSERT_EQUAL(resp.bodyLen, 12);
+        CU_ASSERT_EQUAL(0, memcmp(buf + resp.bodyStart, "hello, world", 12));
+        CU_ASSERT_TRUE(resp.close);
+    }
+    // and one byte per read
+    int64_t cuts[256];
+    for (int64_t i = 0; i + 1 < total; i++) {
+        cuts[i] = i + 1;
+    }
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, cuts, (int)total - 1), 1);
+    CU_ASSERT_EQUAL(resp.bodyLen, 12);
+    CU_ASSERT_EQUAL(0, memcmp(buf + resp.bodyStart, "hello, world", 12));
+}
+
+static void testHttpSplitHeader(void) {
+    const char *  wire = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+    // inside a header name, then inside the blank line ending the headers
+    const int64_t cuts[] = {24, 37};
+    char          buf[128];
+    SHttpResp     resp;
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, cuts, 1), 1);
+    CU_ASSERT_EQUAL(resp.contentLength, 2);
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, cuts + 1, 1), 1);
+    CU_ASSERT_EQUAL(resp.bodyStart, 38);
+    CU_ASSERT_EQUAL(resp.bodyLen, 2);
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, cuts, 2), 1);
+    CU_ASSERT_EQUAL(0, memcmp(buf + resp.bodyStart, "ok", 2));
+}
+
+// the first response ends where the second starts, which parses on its own
+static void testHttpPipelined(void) {
+    const char *first =
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "3\r\none\r\n0\r\n\r\n";
+    const char *second = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\ntwo";
+    char        wire[256];
+    char        buf[256];
+    snprintf(wire, sizeof(wire), "%s%s", first, second);
+    SHttpResp resp;
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, NULL, 0), 1);
+    CU_ASSERT_EQUAL(resp.bodyLen, 3);
+    CU_ASSERT_EQUAL(0, memcmp(buf + resp.bodyStart, "one", 3));
+    CU_ASSERT_EQUAL(resp.readPos, (int64_t)strlen(first));
+
+    char *   next = buf + resp.readPos;
+    int64_t  left = (int64_t)strlen(wire) - resp.readPos;
+    initResp(&resp);
+    CU_ASSERT_EQUAL(parseHttpResponse(&resp, next, left), 1);
+    CU_ASSERT_EQUAL(resp.bodyLen, 3);
+    CU_ASSERT_EQUAL(0, memcmp(next + resp.bodyStart, "two", 3));
+
+    // the other way round a length framed body stops at its length
+    snprintf(wire, sizeof(wire), "%s%s", second, first);
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, wire, NULL, 0), 1);
+    CU_ASSERT_EQUAL(resp.bodyStart + resp.bodyLen, (int64_t)strlen(second));
+    next = buf + resp.bodyStart + resp.bodyLen;
+    left = (int64_t)strlen(first);
+    initResp(&resp);
+    CU_ASSERT_EQUAL(parseHttpResponse(&resp, next, left), 1);
+    CU_ASSERT_EQUAL(0, memcmp(next + resp.bodyStart, "one", 3));
+}
+
+static void testHttpMalformed(void) {
+    char      buf[128];
+    SHttpResp resp;
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, "garbage\r\n\r\n", NULL, 0), -1);
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf,
+                             "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked"
+                             "\r\n\r\nzz\r\n", NULL, 0), -1);
+    // no framing, the body runs until the server closes
+    initResp(&resp);
+    CU_ASSERT_EQUAL(feedResp(&resp, buf, "HTTP/1.0 200 OK\r\n\r\nabc", NULL, 0),
+                    0);
+    CU_ASSERT_EQUAL(resp.bodyLen, 3);
+    CU_ASSERT_TRUE(resp.close);
+}
+
+// child_table_exists with limit 7 offset 5 over 20 tables leaves 7 names,
+// the scheduler must hand out exactly those and nothing past them
+static void testSchedulerLimitOffset(void) {
+    SSuperTable stbInfo = {0};
+    stbInfo.childTblCount = 20;
+    stbInfo.childTblLimit = 7;
+    stbInfo.childTblOffset = 5;
+    stbInfo.steal_chunk = 3;
+    stbInfo.insertRows = 10;
+    STableScheduler scheduler;
+    initTableScheduler(&scheduler, &stbInfo, 7);
+    threadInfo pThreadInfo = {0};
+    pThreadInfo.scheduler = &scheduler;
+    const uint64_t from[] = {0, 3, 6};
+    const uint64_t to[] = {2, 5, 6};
+    int32_t        rows = 0;
+    for (int i = 0; i < 3; i++) {
+        CU_ASSERT_TRUE_FATAL(takeTableUnit(&pThreadInfo, &stbInfo, &rows));
+        CU_ASSERT_EQUAL(pThreadInfo.start_table_from, from[i]);
+        CU_ASSERT_EQUAL(pThreadInfo.end_table_to, to[i]);
+    }
+    CU_ASSERT_FALSE(takeTableUnit(&pThreadInfo, &stbInfo, &rows));
+    CU_ASSERT_TRUE(pThreadInfo.start_table_from > pThreadInfo.end_table_to);
+    CU_ASSERT_EQUAL(pThreadInfo.unitsTaken, 3);
+    pthread_mutex_destroy(&scheduler.mutex);
+}
+
+// in interlace mode every chunk comes back once per round, the last round
+// only writes the rows left
+static void testSchedulerInterlaceRounds(void) {
+    SSuperTable stbInfo = {0};
+    stbInfo.steal_chunk = 4;
+    stbInfo.interlaceRows = 4;
+    stbInfo.insertRows = 10;
+    stbInfo.startTimestamp = 1000;
+    stbInfo.timestamp_step = 10;
+    STableScheduler scheduler;
+    initTableScheduler(&scheduler, &stbInfo, 6);
+    CU_ASSERT_EQUAL(scheduler.units, 6);
+    threadInfo pThreadInfo = {0};
+    pThreadInfo.scheduler = &scheduler;
+    const uint64_t from[] = {0, 4, 0, 4, 0, 4};
+    const uint64_t to[] = {3, 5, 3, 5, 3, 5};
+    const int32_t  rows[] = {4, 4, 4, 4, 2, 2};
+    const int64_t  start[] = {1000, 1000, 1040, 1040, 1080, 1080};
+    for (int i = 0; i < 6; i++) {
+        int32_t interlaceRows = 0;
+        CU_ASSERT_TRUE_FATAL(
+            takeTableUnit(&pThreadInfo, &stbInfo, &interlaceRows));
+        CU_ASSERT_EQUAL(pThreadInfo.start_table_from, from[i]);
+        CU_ASSERT_EQUAL(pThreadInfo.end_table_to, to[i]);
+        CU_ASSERT_EQUAL(interlaceRows, rows[i]);
+        CU_ASSERT_EQUAL(pThreadInfo.start_time, start[i]);
+    }
+    int32_t interlaceRows = 0;
+    CU_ASSERT_FALSE(takeTableUnit(&pThreadInfo, &stbInfo, &interlaceRows));
+    pthread_mutex_destroy(&scheduler.mutex);
+}
+
+typedef struct {
+    SSuperTable *stbInfo;
+    threadInfo   info;
+    uint8_t *    covered;
+} SStealer;
+
+static void *stealTables(void *arg) {
+    SStealer *stealer = arg;
+    int32_t   rows = 0;
+    while (takeTableUnit(&stealer->info, stealer->stbInfo, &rows)) {
+        for (uint64_t t = stealer->info.start_table_from;
+             t <= stealer->info.end_table_to; t++) {
+            stealer->covered[t]++;
+        }
+    }
+    return NULL;
+}
+
+// threads racing for units still cover every table exactly once, whatever
+// the chunk size and the table count left by limit and offset
+static void testSchedulerConcurrentCover(void) {
+    const uint64_t tables[] = {1, 7, 100, 1001};
+    const uint32_t chunks[] = {1, 3, 64, 2000};
+    for (int t = 0; t < 4; t++) {
+        for (int c = 0; c < 4; c++) {
+            SSuperTable stbInfo = {0};
+            stbInfo.steal_chunk = chunks[c];
+            STableScheduler scheduler;
+            initTableScheduler(&scheduler, &stbInfo, tables[t]);
+            SStealer stealers[4];
+            pthread_t pids[4];
+            for (int i = 0; i < 4; i++) {
+                memset(stealers + i, 0, sizeof(SStealer));
+                stealers[i].stbInfo = &stbInfo;
+                stealers[i].info.scheduler = &scheduler;
+                stealers[i].covered = benchCalloc(tables[t], 1, false);
+                CU_ASSERT_EQUAL_FATAL(
+                    pthread_create(pids + i, NULL, stealTables, stealers + i),
+                    0);
+            }
+            uint64_t units = 0;
+            for (int i = 0; i < 4; i++) {
+                pthread_join(pids[i], NULL);
+                units += stealers[i].info.unitsTaken;
+            }
+            CU_ASSERT_EQUAL(units, scheduler.chunks);
+            for (uint64_t n = 0; n < tables[t]; n++) {
+                int hits = 0;
+                for (int i = 0; i < 4; i++) {
+                    hits += stealers[i].covered[n];
+                }
+                CU_ASSERT_EQUAL(hits, 1);
+            }
+            for (int i = 0; i < 4; i++) {
+                tmfree(stealers[i].covered);
+            }
+            pthread_mutex_destroy(&scheduler.mutex);
+        }
+    }
+}
+
+// a local http server answering the rest engine: request k is answered
+// with a length framed body, a chunked body written in three pieces, or a
+// length framed body followed by closing the connection, in turn
+#define REST_TEST_REQUESTS 60
+#define REST_TEST_FAIL     7   // answered with 500
+
+typedef struct {
+    int             listenfd;
+    pthread_mutex_t mutex;
+    int             requests;
+    int             accepted;
+    int             seen[REST_TEST_REQUESTS];
+    pthread_t       conns[REST_TEST_REQUESTS + 8];
+    int             connCount;
+} SRestServer;
+
+typedef struct {
+    SRestServer *server;
+    int          fd;
+} SRestServerConn;
+
+static void writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static void *serveRestConn(void *arg) {
+    SRestServerConn *conn = arg;
+    SRestServer *    server = conn->server;
+    char             buf[4096];
+    int64_t          received = 0;
+    while (true) {
+        ssize_t n = read(conn->fd, buf + received, sizeof(buf) - 1 - received);
+        if (n <= 0) {
+            break;
+        }
+        received += n;
+        buf[received] = '\0';
+        char *end = strstr(buf, "\r\n\r\n");
+        char *length = strstr(buf, "Content-Length: ");
+        if (end == NULL || length == NULL) {
+            continue;
+        }
+        int64_t bodyStart = end + 4 - buf;
+        int64_t bodyLen = atoll(length + 16);
+        if (received < bodyStart + bodyLen) {
+            continue;
+        }
+        int id = atoi(buf + bodyStart);
+        received = 0;
+
+        pthread_mutex_lock(&server->mutex);
+        int k = server->requests++;
+        if (id >= 0 && id < REST_TEST_REQUESTS) {
+            server->seen[id]++;
+        }
+        pthread_mutex_unlock(&server->mutex);
+        if (id == REST_TEST_FAIL) {
+            const char *resp =
+                "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 2\r\n"
+                "\r\nno";
+            writeAll(conn->fd, resp, strlen(resp));
+        } else if (k % 3 == 0) {
+            const char *resp =
+                "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n{\"code\":0}";
+            writeAll(conn->fd, resp, strlen(resp));
+        } else if (k % 3 == 1) {
+            const char *parts[] = {
+                "HTTP/1.1 200 OK\r\nTransfer-Encoding: chu",
+                "nked\r\n\r\n4\r\n{\"co\r\n6\r\nde\"",
+                ":0}\r\n0\r\n\r\n"};
+            for (int i = 0; i < 3; i++) {
+                writeAll(conn->fd, parts[i], strlen(parts[i]));
+                toolsMsleep(1);
+            }
+        } else {
+            const char *resp =
+                "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 10"
+                "\r\n\r\n{\"code\":0}";
+            writeAll(conn->fd, resp, strlen(resp));
+            break;
+        }
+    }
+    close(conn->fd);
+    tmfree(conn);
+    return NULL;
+}
+
+static void *acceptRestConns(void *arg) {
+    SRestServer *server = arg;
+    while (true) {
+        int fd = accept(server->listenfd, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        SRestServerConn *conn = benchCalloc(1, sizeof(SRestServerConn), false);
+        conn->server = server;
+        conn->fd = fd;
+        pthread_mutex_lock(&server->mutex);
+        server->accepted++;
+        if (server->connCount < REST_TEST_REQUESTS + 8 &&
+            0 == pthread_create(server->conns + server->connCount, NULL,
+                                serveRestConn, conn)) {
+            server->connCount++;
+        } else {
+            close(fd);
+            tmfree(conn);
+        }
+        pthread_mutex_unlock(&server->mutex);
+    }
+    return NULL;
+}
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int             done;
+    int             failed;
+    int             codes[REST_TEST_REQUESTS];
+} SRestResults;
+
+static SRestResults g_restResults;
+
+static void restTestDone(void *param, int32_t code, int64_t startTs,
+                         int64_t endTs) {
+    int id = (int)(intptr_t)param;
+    pthread_mutex_lock(&g_restResults.mutex);
+    g_restResults.done++;
+    g_restResults.codes[id] = code;
+    if (code != 0) {
+        g_restResults.failed++;
+    }
+    pthread_mutex_unlock(&g_restResults.mutex);
+}
+
+static void testRestEngine(void) {
+    SRestServer server = {0};
+    pthread_mutex_init(&server.mutex, NULL);
+    server.listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    CU_ASSERT_FATAL(server.listenfd >= 0);
+    struct sockaddr_in addr = {0};
+    socklen_t          addrLen = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CU_ASSERT_EQUAL_FATAL(
+        bind(server.listenfd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    CU_ASSERT_EQUAL_FATAL(listen(server.listenfd, 16), 0);
+    getsockname(server.listenfd, (struct sockaddr *)&addr, &addrLen);
+    g_arguments->serv_addr = addr;
+    pthread_t acceptor;
+    CU_ASSERT_EQUAL_FATAL(
+        pthread_create(&acceptor, NULL, acceptRestConns, &server), 0);
+
+    SDataBase *  database = benchArrayGet(g_arguments->databases, 0);
+    SSuperTable *stbInfo = benchArrayGet(database->superTbls, 0);
+    stbInfo->iface = REST_IFACE;
+    threadInfo pThreadInfo = {0};
+    const char *header = "POST /rest/sql/test HTTP/1.1\r\nContent-Length: ";
+    pThreadInfo.httpHeader = benchCalloc(1, strlen(header) + 1, false);
+    strcpy(pThreadInfo.httpHeader, header);
+    pThreadInfo.httpHeaderLen = (uint32_t)strlen(header);
+
+    memset(&g_restResults, 0, sizeof(g_restResults));
+    pthread_mutex_init(&g_restResults.mutex, NULL);
+    SRestEngine *engine = restEngineCreate(&pThreadInfo, 3, restTestDone);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(engine);
+    char bodies[REST_TEST_REQUESTS][32];
+    for (int i = 0; i < REST_TEST_REQUESTS; i++) {
+        snprintf(bodies[i], sizeof(bodies[i]), "%d insert", i);
+        restEngineSubmit(engine, bodies[i], (void *)(intptr_t)i);
+    }
+    restEngineDrain(engine);
+    CU_ASSERT_EQUAL(g_restResults.done, REST_TEST_REQUESTS);
+    CU_ASSERT_EQUAL(g_restResults.failed, 1);
+    CU_ASSERT_NOT_EQUAL(g_restResults.codes[REST_TEST_FAIL], 0);
+    restEngineDestroy(engine);
+
+    shutdown(server.listenfd, SHUT_RDWR);
+    close(server.listenfd);
+    pthread_join(acceptor, NULL);
+    for (int i = 0; i < server.connCount; i++) {
+        pthread_join(server.conns[i], NULL);
+    }
+    for (int i = 0; i < REST_TEST_REQUESTS; i++) {
+        CU_ASSERT_EQUAL(server.seen[i], 1);
+    }
+    CU_ASSERT_EQUAL(server.requests, REST_TEST_REQUESTS);
+    // every third answer closes its connection, which is opened again
+    CU_ASSERT_TRUE(server.accepted > 3);
+    pthread_mutex_destroy(&server.mutex);
+    pthread_mutex_destroy(&g_restResults.mutex);
+    freeHttpBuffers(&pThreadInfo);
+}
+
+#ifdef DEFLATE_CODEC
+// inflate what compressHttpBody produced and compare with the original
+static void checkInflate(const char *zbuf, int64_t zlen, int windowBits,
+                         const char *body) {
+    z_stream zs = {0};
+    size_t   len = strlen(body);
+    char *   plain = benchCalloc(1, len + 16, false);
+    CU_ASSERT_EQUAL_FATAL(inflateInit2(&zs, windowBits), Z_OK);
+    zs.next_in = (Bytef *)zbuf;
+    zs.avail_in = (uInt)zlen;
+    zs.next_out = (Bytef *)plain;
+    zs.avail_out = (uInt)(len + 16);
+    CU_ASSERT_EQUAL(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    CU_ASSERT_EQUAL(zs.total_out, len);
+    CU_ASSERT_EQUAL(0, memcmp(plain, body, len));
+    inflateEnd(&zs);
+    tmfree(plain);
+}
+#endif
+
+// one stream is reset and reused across bodies, framed as the option says
+static void testCompressHttpBody(void) {
+#ifdef DEFLATE_CODEC
+    char *body = benchCalloc(1, 20000, false);
+    int   len = 0;
+    while (len < 19000) {
+        len += sprintf(body + len, "(%d,%d.5,'value') ", 1600000000 + len,
+                       len % 97);
+    }
+    const char *small = "insert into t values (1600000000000,1)";
+    const int   modes[] = {REST_COMPRESS_GZIP, REST_COMPRESS_DEFLATE};
+    const int   windowBits[] = {15 + 16, 15};
+    for (int m = 0; m < 2; m++) {
+        g_arguments->rest_compression = modes[m];
+        threadInfo pThreadInfo = {0};
+        void *     stream = NULL;
+        char *     out = NULL;
+        uint64_t   cap = 0;
+        int64_t    zlen =
+            compressHttpBody(&pThreadInfo, &stream, body, len, &out, &cap);
+        CU_ASSERT_FATAL(zlen > 0 && zlen < len);
+        checkInflate(out, zlen, windowBits[m], body);
+        int64_t wire = zlen;
+        zlen = compressHttpBody(&pThreadInfo, &stream, small,
+                                (int64_t)strlen(small), &out, &cap);
+        CU_ASSERT_FATAL(zlen > 0);
+        checkInflate(out, zlen, windowBits[m], small);
+        CU_ASSERT_EQUAL(pThreadInfo.bodyBytes, len + strlen(small));
+        CU_ASSERT_EQUAL(pThreadInfo.wireBytes, wire + zlen);
+        freeDeflateStream(&stream);
+        CU_ASSERT_PTR_NULL(stream);
+        tmfree(out);
+    }
+    g_arguments->rest_compression = REST_COMPRESS_NONE;
+    tmfree(body);
+#else
+    // without zlib the body is never compressed
+    threadInfo pThreadInfo = {0};
+    void *     stream = NULL;
+    char *     out = NULL;
+    uint64_t   cap = 0;
+    CU_ASSERT_EQUAL(
+        compressHttpBody(&pThreadInfo, &stream, "x", 1, &out, &cap), -1);
+#endif
+}
+
+CUNIT_CI_RUN("taosBenchmark",
+             CUNIT_CI_TEST(testHistLinear),
+             CUNIT_CI_TEST(testHistLinearToLog),
+             CUNIT_CI_TEST(testHistSubBucketEdges),
+             CUNIT_CI_TEST(testHistBeyondHighest),
+             CUNIT_CI_TEST(testHistMerge),
+             CUNIT_CI_TEST(testHttpContentLength),
+             CUNIT_CI_TEST(testHttpChunkedSplit),
+             CUNIT_CI_TEST(testHttpSplitHeader),
+             CUNIT_CI_TEST(testHttpPipelined),
+             CUNIT_CI_TEST(testHttpMalformed),
+             CUNIT_CI_TEST(testSchedulerLimitOffset),
+             CUNIT_CI_TEST(testSchedulerInterlaceRounds),
+             CUNIT_CI_TEST(testSchedulerConcurrentCover),
+             CUNIT_CI_TEST(testRestEngine),
+             CUNIT_CI_TEST(testCompressHttpBody));